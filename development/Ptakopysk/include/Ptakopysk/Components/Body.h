@@ -167,6 +167,8 @@ namespace Ptakopysk
         virtual void onRenderEditor( sf::RenderTarget* target );
         virtual void onFixtureGoodbye( b2Fixture* fixture );
         virtual bool onTriggerFunctionality( const std::string& name );
+        virtual void onSaveState( StateBuffer& state );
+        virtual void onLoadState( StateBuffer& state );
 
     private:
         float m_radius;
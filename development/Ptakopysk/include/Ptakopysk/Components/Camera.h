@@ -53,7 +53,7 @@ namespace Ptakopysk
         FORCEINLINE KeepAspectRatioMode getKeepAspectRatioMode() { return m_keepAspectRatioMode; };
         FORCEINLINE void setKeepAspectRatioMode( KeepAspectRatioMode v ) { m_keepAspectRatioMode = v; setSize( m_size ); };
         FORCEINLINE sf::RenderTexture* getTargetTexture() { return m_renderTexture; };
-        FORCEINLINE void setTargetTexture( sf::RenderTexture* v ) { if( m_renderTexture != v && m_renderTextureMine ) { m_renderTextureMine = false; DELETE_OBJECT( m_renderTexture ) }; m_renderTexture = v; };
+        void setTargetTexture( sf::RenderTexture* v );
         FORCEINLINE bool isTargetTextureMine() { return m_renderTextureMine; }
         FORCEINLINE GenerateRenderTextureMode getGenerateRenderTextureMode() { return m_generateRenderTextureMode; };
         FORCEINLINE void setGenerateRenderTextureMode( GenerateRenderTextureMode v ) { m_generateRenderTextureMode = v; };
@@ -130,6 +130,8 @@ namespace Ptakopysk
         virtual void onDuplicate( Component* dst );
         virtual void onUpdate( float dt );
         virtual void onRender( sf::RenderTarget*& target );
+        virtual void onRenderSnapshot( RenderSnapshot& snapshot );
+        virtual void onRenderQueue( RenderQueue& queue );
         virtual void onRenderEditor( sf::RenderTarget* target );
 
     private:
@@ -23,6 +23,11 @@ namespace Ptakopysk
 {
 
     class GameObject;
+    class RenderSnapshot;
+    class RenderQueue;
+    class SpriteBatch;
+    class SpatialGrid;
+    class StateBuffer;
 
     META_COMPONENT(
         META_ATTR_DESCRIPTION( "Base component." )
@@ -34,6 +39,8 @@ namespace Ptakopysk
     {
         RTTI_CLASS_DECLARE( Component );
         friend class GameObject;
+        friend class GameManager;
+        friend class RenderQueue;
 
     public:
         enum Type
@@ -43,8 +50,9 @@ namespace Ptakopysk
             tUpdate = 1 << 1,
             tRender = 1 << 2,
             tPhysics = 1 << 3,
-            tTransform = 1 << 4,
+            tTransform = 1 << 4, // onTransform runs only after GameObject::invalidateTransform(), not every frame.
             tShape = 1 << 5,
+            tParallelUpdate = 1 << 6,
             tAll = -1
         };
 
@@ -56,7 +64,7 @@ namespace Ptakopysk
         FORCEINLINE Type getTypeFlags() { return m_typeFlags; };
         FORCEINLINE void setTypeFlags( Type flags ) { m_typeFlags = flags; };
         FORCEINLINE bool isActive() { return m_active; };
-        FORCEINLINE void setActive( bool mode = true ) { m_active = mode; };
+        void setActive( bool mode = true );
         FORCEINLINE GameObject* getGameObject() { return m_gameObject; };
 
         void fromJson( const Json::Value& root );
@@ -82,8 +90,13 @@ namespace Ptakopysk
         virtual void onDuplicate( Component* dst );
         virtual void onEvent( const sf::Event& event ) {};
         virtual void onUpdate( float dt ) {};
+        virtual void onUpdateParallel( float dt ) {};
         virtual void onTransform( const sf::Transform& inTrans, sf::Transform& outTrans ) {};
         virtual void onRender( sf::RenderTarget*& target ) {};
+        virtual void onRenderSnapshot( RenderSnapshot& snapshot ) {};
+        virtual void onRenderQueue( RenderQueue& queue );
+        virtual bool onRenderBatch( SpriteBatch& batch, sf::RenderTarget* target ) { return false; };
+        virtual bool onCullingBounds( sf::FloatRect& result ) { return false; };
         virtual void onRenderEditor( sf::RenderTarget* target ) { onRender( target ); };
         virtual void onCollide( GameObject* other, bool beginOrEnd, b2Contact* contact ) {};
         virtual void onJointGoodbye( b2Joint* joint ) {};
@@ -96,13 +109,24 @@ namespace Ptakopysk
         virtual void onCustomAssetChanged( const ICustomAsset* a, bool addedOrRemoved ) {};
         virtual bool onTriggerFunctionality( const std::string& name ) { return false; };
         virtual bool onCheckContainsPoint( const sf::Vector2f& worldPos ) { return false; };
+        virtual bool onRecycle() { return false; };
+        virtual void onSaveState( StateBuffer& state ) {};
+        virtual void onLoadState( StateBuffer& state ) {};
+
+        FORCEINLINE void invalidateCullingBounds() { if( m_cullingGrid ) updateCulling(); };
 
     private:
         void setGameObject( GameObject* gameObject );
+        bool recycle();
+        void updateCulling();
+        void releaseCulling();
 
         Type m_typeFlags;
         bool m_active;
         GameObject* m_gameObject;
+        unsigned int m_poolIndex;
+        SpatialGrid* m_cullingGrid;
+        int m_cullingProxy;
     };
 
     Component::Type operator|( Component::Type a, Component::Type b );
@@ -49,6 +49,8 @@ namespace Ptakopysk
         virtual void onCreate();
         virtual void onDuplicate( Component* dst );
         virtual bool onTriggerFunctionality( const std::string& name );
+        virtual void onSaveState( StateBuffer& state );
+        virtual void onLoadState( StateBuffer& state );
 
     private:
         SpriteAtlasAsset* m_atlas;
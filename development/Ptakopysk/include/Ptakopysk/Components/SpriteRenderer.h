@@ -31,13 +31,13 @@ namespace Ptakopysk
         sf::Vector2f getSize();
         void setSize( sf::Vector2f size );
         FORCEINLINE sf::Vector2f getOrigin() { return m_shape->getOrigin(); };
-        FORCEINLINE void setOrigin( sf::Vector2f origin ) { m_shape->setOrigin( origin ); };
+        FORCEINLINE void setOrigin( sf::Vector2f origin ) { m_shape->setOrigin( origin ); invalidateCullingBounds(); };
         sf::Vector2f getOriginPercent();
         void setOriginPercent( sf::Vector2f origin );
         FORCEINLINE sf::Color getColor() { return m_shape->getFillColor(); };
         FORCEINLINE void setColor( sf::Color col ) { m_shape->setFillColor( col ); };
         FORCEINLINE sf::RenderStates getRenderStates() { return m_renderStates; };
-        FORCEINLINE void setRenderStates( sf::RenderStates states ) { m_renderStates = states; };
+        FORCEINLINE void setRenderStates( sf::RenderStates states ) { states.transform = m_renderStates.transform; m_renderStates = states; };
         FORCEINLINE RenderMaterial& getMaterial() { return m_material; };
         FORCEINLINE void setMaterial( RenderMaterial& v ) { m_material.copyFrom( v ); };
         FORCEINLINE bool getMaterialValidation() { return m_materialValidation; };
@@ -95,15 +95,23 @@ namespace Ptakopysk
         virtual void onDuplicate( Component* dst );
         virtual void onTransform( const sf::Transform& inTrans, sf::Transform& outTrans );
         virtual void onRender( sf::RenderTarget*& target );
+        virtual void onRenderSnapshot( RenderSnapshot& snapshot );
+        virtual void onRenderQueue( RenderQueue& queue );
+        virtual bool onCullingBounds( sf::FloatRect& result );
+        virtual bool onRenderBatch( SpriteBatch& batch, sf::RenderTarget* target );
         virtual void onRenderEditor( sf::RenderTarget* target );
         virtual void onTextureChanged( const sf::Texture* a, bool addedOrRemoved );
         virtual void onShaderChanged( const sf::Shader* a, bool addedOrRemoved );
         virtual bool onTriggerFunctionality( const std::string& name );
         virtual bool onCheckContainsPoint( const sf::Vector2f& worldPos );
+        virtual bool onRecycle();
+        virtual void onSaveState( StateBuffer& state );
+        virtual void onLoadState( StateBuffer& state );
 
     private:
         sf::Vector2f m_size;
         sf::RectangleShape* m_shape;
+        sf::Texture* m_sourceTexture;
         sf::RenderStates m_renderStates;
         RenderMaterial m_material;
         bool m_materialValidation;
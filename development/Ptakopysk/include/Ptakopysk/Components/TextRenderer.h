@@ -4,6 +4,7 @@
 #include "Component.h"
 #include <SFML/Graphics.hpp>
 #include "../System/RenderMaterial.h"
+#include "../System/GlyphRunCache.h"
 
 namespace Ptakopysk
 {
@@ -25,25 +26,25 @@ namespace Ptakopysk
 
         FORCEINLINE static Component* onBuildComponent() { return xnew TextRenderer(); }
 
-        FORCEINLINE sf::Text* getRenderer() { return m_text; };
-        FORCEINLINE sf::String getText() { return m_text->getString(); };
-        FORCEINLINE void setText( sf::String v ) { m_text->setString( v ); };
+        FORCEINLINE sf::Text* getRenderer() { syncText(); return m_text; };
+        FORCEINLINE sf::String getText() { return m_textDirty ? m_string : m_text->getString(); };
+        void setText( sf::String v );
         FORCEINLINE sf::Font* getFont() { return (sf::Font*)m_text->getFont(); };
-        FORCEINLINE void setFont( sf::Font* v ) { if( v ) m_text->setFont( *v ); };
+        void setFont( sf::Font* v );
         FORCEINLINE dword getSize() { return m_text->getCharacterSize(); };
-        FORCEINLINE void setSize( dword v ) { m_text->setCharacterSize( v ); };
-        FORCEINLINE sf::FloatRect measureText() { return m_text->getLocalBounds(); };
+        void setSize( dword v );
+        sf::FloatRect measureText();
         FORCEINLINE sf::Vector2f getDimensions() { sf::FloatRect r = measureText(); return sf::Vector2f( r.left + r.width, r.top + r.height ); };
         FORCEINLINE sf::Vector2f getOrigin() { return m_text->getOrigin(); };
-        FORCEINLINE void setOrigin( sf::Vector2f origin ) { m_text->setOrigin( origin ); };
+        FORCEINLINE void setOrigin( sf::Vector2f origin ) { m_text->setOrigin( origin ); invalidateCullingBounds(); };
         sf::Vector2f getOriginPercent();
         void setOriginPercent( sf::Vector2f origin );
         FORCEINLINE dword getStyle() { return m_text->getStyle(); };
-        FORCEINLINE void setStyle( dword v ) { m_text->setStyle( v ); };
+        void setStyle( dword v );
         FORCEINLINE sf::Color getColor() { return m_text->getColor(); };
         FORCEINLINE void setColor( sf::Color v ) { m_text->setColor( v ); };
         FORCEINLINE sf::RenderStates getRenderStates() { return m_renderStates; };
-        FORCEINLINE void setRenderStates( sf::RenderStates states ) { m_renderStates = states; };
+        FORCEINLINE void setRenderStates( sf::RenderStates states ) { states.transform = m_renderStates.transform; m_renderStates = states; };
         FORCEINLINE RenderMaterial& getMaterial() { return m_material; };
         FORCEINLINE void setMaterial( RenderMaterial& v ) { m_material.copyFrom( v ); };
         FORCEINLINE bool getMaterialValidation() { return m_materialValidation; };
@@ -112,17 +113,29 @@ namespace Ptakopysk
         virtual void onDuplicate( Component* dst );
         virtual void onTransform( const sf::Transform& inTrans, sf::Transform& outTrans );
         virtual void onRender( sf::RenderTarget*& target );
+        virtual void onRenderSnapshot( RenderSnapshot& snapshot );
+        virtual void onRenderQueue( RenderQueue& queue );
+        virtual bool onRenderBatch( SpriteBatch& batch, sf::RenderTarget* target );
+        virtual bool onCullingBounds( sf::FloatRect& result );
         virtual void onRenderEditor( sf::RenderTarget* target );
         virtual void onShaderChanged( const sf::Shader* a, bool addedOrRemoved );
         virtual void onFontChanged( const sf::Font* a, bool addedOrRemoved );
         virtual bool onTriggerFunctionality( const std::string& name );
         virtual bool onCheckContainsPoint( const sf::Vector2f& worldPos );
+        virtual void onSaveState( StateBuffer& state );
+        virtual void onLoadState( StateBuffer& state );
 
     private:
         std::string escapedString( std::string v );
         std::string unescapedString( std::string v );
+        void syncText();
+        GlyphRunCache::Run* glyphRun();
 
         sf::Text* m_text;
+        sf::String m_string;
+        bool m_textDirty;
+        GlyphRunCache::Run* m_run;
+        unsigned int m_runRevision;
         sf::RenderStates m_renderStates;
         RenderMaterial m_material;
         bool m_materialValidation;
@@ -8,6 +8,8 @@
 namespace Ptakopysk
 {
 
+    class GameManager;
+
     META_COMPONENT(
         META_ATTR_DESCRIPTION( "Transform component." )
     )
@@ -17,6 +19,7 @@ namespace Ptakopysk
     , public Component
     {
         RTTI_CLASS_DECLARE( Transform );
+        friend class GameManager;
 
     public:
         enum ModeType
@@ -32,16 +35,22 @@ namespace Ptakopysk
         FORCEINLINE static Component* onBuildComponent() { return xnew Transform(); }
 
         FORCEINLINE sf::Vector2f getPosition() { return m_position; };
-        FORCEINLINE void setPosition( sf::Vector2f pos ) { m_position = pos; };
+        FORCEINLINE void setPosition( sf::Vector2f pos ) { if( pos != m_position ) { m_position = pos; invalidate(); } };
         FORCEINLINE float getRotation() { return m_rotation; };
-        FORCEINLINE void setRotation( float rot ) { m_rotation = rot; };
+        FORCEINLINE void setRotation( float rot ) { if( rot != m_rotation ) { m_rotation = rot; invalidate(); } };
         FORCEINLINE sf::Vector2f getScale() { return m_scale; };
-        FORCEINLINE void setScale( sf::Vector2f scl ) { m_scale = scl; };
+        FORCEINLINE void setScale( sf::Vector2f scl ) { if( scl != m_scale ) { m_scale = scl; invalidate(); } };
         FORCEINLINE ModeType getMode() { return m_mode; };
-        FORCEINLINE void setMode( ModeType mode ) { m_mode = mode; };
+        FORCEINLINE void setMode( ModeType mode ) { if( mode != m_mode ) { m_mode = mode; invalidate(); } };
+        FORCEINLINE bool isInterpolated() { return m_interpolated; };
+        void setInterpolated( bool mode );
         FORCEINLINE const sf::Transform& getTransform() { return m_transform; };
         FORCEINLINE const sf::Transform& getTransformGlobal() { return m_transformGlobal; };
         void recomputeTransform();
+        void invalidate();
+        void storeInterpolationState();
+        FORCEINLINE void resetInterpolationState() { m_interpolationStored = false; };
+        void updateInterpolationTracking();
 
         META_PROPERTY(
             META_ATTR_DESCRIPTION( "Position vector." ),
@@ -68,20 +77,40 @@ namespace Ptakopysk
         )
         XeCore::Common::Property< ModeType, Transform > Mode;
 
+        META_PROPERTY(
+            META_ATTR_DESCRIPTION( "Interpolate between fixed steps (always on when game object has Body)." ),
+            META_ATTR_DEFAULT_VALUE( "false" )
+        )
+        XeCore::Common::Property< bool, Transform > Interpolated;
+
     protected:
         virtual Json::Value onSerialize( const std::string& property );
         virtual void onDeserialize( const std::string& property, const Json::Value& root );
 
+        virtual void onCreate();
+        virtual void onDestroy();
         virtual void onDuplicate( Component* dst );
         virtual void onTransform( const sf::Transform& inTrans, sf::Transform& outTrans );
+        virtual bool onRecycle();
+        virtual void onSaveState( StateBuffer& state );
+        virtual void onLoadState( StateBuffer& state );
 
     private:
+        static float s_interpolationAlpha;
+
         sf::Vector2f m_position;
         float m_rotation;
         sf::Vector2f m_scale;
         ModeType m_mode;
         sf::Transform m_transform;
         sf::Transform m_transformGlobal;
+        sf::Vector2f m_prevPosition;
+        float m_prevRotation;
+        sf::Vector2f m_prevScale;
+        bool m_interpolationStored;
+        bool m_interpolated;
+        GameManager* m_interpolationOwner;
+        unsigned int m_interpolationIndex;
     };
 
 }
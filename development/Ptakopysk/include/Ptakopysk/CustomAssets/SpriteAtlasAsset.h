@@ -5,6 +5,7 @@
 #include "../Components/SpriteRenderer.h"
 #include <SFML/Graphics/Rect.hpp>
 #include <map>
+#include <vector>
 
 namespace Ptakopysk
 {
@@ -24,19 +25,26 @@ namespace Ptakopysk
 
         SpriteAtlasAsset();
 
+        FORCEINLINE bool isPacked() { return m_packed; };
+        FORCEINLINE unsigned int getPagesCount() { return m_pages.size(); };
+        FORCEINLINE std::string getPage( unsigned int index ) { return index < m_pages.size() ? m_pages[ index ] : ""; };
         FORCEINLINE bool hasSubTexture( const std::string& name ) { return m_rects.count( name ); };
         bool getSubTexture( const std::string& name, sf::IntRect& outRect );
         bool applySubTexture( const std::string& name, SpriteRenderer* sprite );
         bool addSubTexture( const std::string& name, const sf::IntRect& rect );
         bool removeSubTexture( const std::string& name );
+        bool pack( const std::string& id, const std::vector< std::string >& textures, unsigned int pageSize, unsigned int padding, bool smooth );
 
     protected:
         virtual bool onLoad( const std::string& path );
 
     private:
         void readSubTexture( const Json::Value& root );
+        static void extrude( sf::Image& image, const sf::IntRect& rect, unsigned int before, unsigned int after );
 
         std::map< std::string, sf::IntRect > m_rects;
+        std::vector< std::string > m_pages;
+        bool m_packed;
     };
 
 }
@@ -0,0 +1,106 @@
+#ifndef __PTAKOPYSK__ALLOCATIONS__
+#define __PTAKOPYSK__ALLOCATIONS__
+
+#include <XeCore/Common/Base.h>
+#include <XeCore/Common/MemoryManager.h>
+#include <json/json.h>
+#include <cstddef>
+
+#if defined( PTAKOPYSK_ALLOCATION_HOOKS ) && defined( XMM_MEMORY_TRACING_MODE ) && defined( MEMORY_TRACE_ALL )
+#undef PTAKOPYSK_ALLOCATION_HOOKS
+#endif
+
+namespace Ptakopysk
+{
+
+    class Allocations
+    {
+    public:
+        enum Subsystem
+        {
+            sGeneral,
+            sScene,
+            sAssets,
+            sPhysics,
+            sNetwork,
+            sUpdate,
+            sRender,
+            sCount
+        };
+
+        struct Stats
+        {
+            unsigned int allocations;
+            unsigned int deallocations;
+            unsigned long long allocatedBytes;
+            unsigned long long liveBytes;
+            unsigned long long peakLiveBytes;
+            unsigned int peakFrameAllocations;
+            unsigned long long peakFrameBytes;
+        };
+
+        struct FrameStats
+        {
+            unsigned int allocations;
+            unsigned int deallocations;
+            unsigned long long allocatedBytes;
+        };
+
+        static FORCEINLINE bool isHooked()
+        {
+#ifdef PTAKOPYSK_ALLOCATION_HOOKS
+            return true;
+#else
+            return false;
+#endif
+        };
+        static FORCEINLINE unsigned int framesCount() { return s_framesCount; };
+        static FORCEINLINE const Stats& getStats( Subsystem s ) { return s_stats[ s ]; };
+        static FORCEINLINE const FrameStats& getFrameStats( Subsystem s ) { return s_frame[ s ]; };
+        static FORCEINLINE const FrameStats& getLastFrameStats( Subsystem s ) { return s_lastFrame[ s ]; };
+        static Stats getTotalStats();
+        static FrameStats getTotalFrameStats();
+        static FrameStats getTotalLastFrameStats();
+        static const char* subsystemName( Subsystem s );
+        static Subsystem getSubsystem();
+        static Subsystem setSubsystem( Subsystem s );
+
+        static void* allocate( std::size_t size );
+        static void release( void* ptr );
+        static void beginFrame();
+        static void endFrame();
+        static void reset();
+        static Json::Value statsToJson();
+
+    private:
+        static Stats s_stats[ sCount ];
+        static FrameStats s_frame[ sCount ];
+        static FrameStats s_lastFrame[ sCount ];
+        static unsigned int s_framesCount;
+    };
+
+    class AllocationsScope
+    {
+    public:
+        FORCEINLINE AllocationsScope( Allocations::Subsystem s ) : m_previous( Allocations::setSubsystem( s ) ) {};
+        FORCEINLINE ~AllocationsScope() { Allocations::setSubsystem( m_previous ); };
+
+    private:
+        Allocations::Subsystem m_previous;
+    };
+
+    class AllocationsFrame
+    {
+    public:
+        FORCEINLINE AllocationsFrame() { Allocations::beginFrame(); };
+        FORCEINLINE ~AllocationsFrame() { Allocations::endFrame(); };
+    };
+
+}
+
+#define ALLOCATIONS_CONCAT_INNER( a, b ) a##b
+#define ALLOCATIONS_CONCAT( a, b ) ALLOCATIONS_CONCAT_INNER( a, b )
+#define ALLOCATIONS_FRAME() Ptakopysk::AllocationsFrame ALLOCATIONS_CONCAT( __allocationsFrame, __LINE__ )
+#define ALLOCATIONS_SCOPE( subsystem ) Ptakopysk::AllocationsScope ALLOCATIONS_CONCAT( __allocationsScope, __LINE__ )( Ptakopysk::Allocations::subsystem )
+
+#endif
@@ -10,11 +10,13 @@
 #include <json/json.h>
 #include <map>
 #include <sstream>
+#include "FactoryRegistry.h"
 
 namespace Ptakopysk
 {
 
     class Assets;
+    class SpriteAtlasAsset;
 
     class ICustomAsset
     : public virtual XeCore::Common::IRtti
@@ -92,6 +94,8 @@ namespace Ptakopysk
         FORCEINLINE AssetsLoadingMode getAssetsLoadingMode() { return m_loadingMode; };
         FORCEINLINE void setAssetsChangedListener( AssetsChangedListener* listener ) { m_assetsChangedListener = listener; };
         FORCEINLINE AssetsChangedListener* getAssetsChangedListener() { return m_assetsChangedListener; };
+        FORCEINLINE bool isHeadless() { return m_headless; };
+        FORCEINLINE void setHeadless( bool mode ) { m_headless = mode; }; // textures, shaders, fonts and atlas pages keep only metadata.
 
         void jsonToAssets( const Json::Value& root );
         void jsonToTextures( const Json::Value& root );
@@ -100,6 +104,7 @@ namespace Ptakopysk
         void jsonToMusics( const Json::Value& root );
         void jsonToFonts( const Json::Value& root );
         void jsonToCustomAssets( const Json::Value& root );
+        void jsonToAtlases( const Json::Value& root );
 
         sf::Texture* jsonToTexture( const Json::Value& root );
         sf::Shader* jsonToShader( const Json::Value& root );
@@ -107,6 +112,7 @@ namespace Ptakopysk
         sf::Music* jsonToMusic( const Json::Value& root );
         sf::Font* jsonToFont( const Json::Value& root );
         ICustomAsset* jsonToCustomAsset( const Json::Value& root );
+        SpriteAtlasAsset* jsonToAtlas( const Json::Value& root );
 
         Json::Value assetsToJson();
         Json::Value texturesToJson();
@@ -115,6 +121,7 @@ namespace Ptakopysk
         Json::Value musicsToJson();
         Json::Value fontsToJson();
         Json::Value customAssetsToJson();
+        Json::Value atlasesToJson();
 
         Json::Value textureToJson( const std::string& id );
         Json::Value shaderToJson( const std::string& id );
@@ -122,6 +129,7 @@ namespace Ptakopysk
         Json::Value musicToJson( const std::string& id );
         Json::Value fontToJson( const std::string& id );
         Json::Value customAssetToJson( const std::string& id );
+        Json::Value atlasToJson( const std::string& id );
 
         sf::Texture* addTexture( const std::string& id, const sf::Texture* ptr );
         sf::Shader* addShader( const std::string& id, const sf::Shader* ptr );
@@ -136,6 +144,7 @@ namespace Ptakopysk
         sf::Music* loadMusic( const std::string& id, const std::string& path );
         sf::Font* loadFont( const std::string& id, const std::string& path );
         ICustomAsset* loadCustomAsset( const std::string& id, const std::string& type, const std::string& path );
+        SpriteAtlasAsset* packAtlas( const std::string& id, const std::vector< std::string >& textures, unsigned int pageSize = 2048, unsigned int padding = 1, bool smooth = true );
 
         sf::Texture* getTexture( const std::string& id );
         sf::Shader* getShader( const std::string& id );
@@ -144,7 +153,10 @@ namespace Ptakopysk
         sf::Font* getFont( const std::string& id );
         ICustomAsset* getCustomAsset( const std::string& id );
 
-        FORCEINLINE sf::Texture* getDefaultTexture() { return m_defaultTexture; };
+        sf::Texture* getDefaultTexture();
+        sf::Vector2u getTextureSize( const std::string& id );
+        bool findTextureRegion( const sf::Texture* ptr, sf::Texture*& outPage, sf::IntRect& outRect );
+        void setTextureRegion( const sf::Texture* ptr, sf::Texture* page, const sf::IntRect& rect );
         bool shadersAvailable();
 
         std::string findTexture( const sf::Texture* ptr );
@@ -204,20 +216,23 @@ namespace Ptakopysk
         void freeAll();
 
     private:
-        struct CustomAssetFactoryData
+        typedef FactoryRegistry< ICustomAsset::OnBuildCustomAssetCallback > CustomAssetsFactory;
+
+        struct TextureRegion
         {
-            XeCore::Common::IRtti::Derivation type;
-            ICustomAsset::OnBuildCustomAssetCallback builder;
+            sf::Texture* page;
+            sf::IntRect rect;
         };
 
         void parseTags( const Json::Value& inRoot, std::vector< std::string >& outArray );
         Json::Value jsonTags( std::vector< std::string >& inArray );
         bool fileExists( const std::string& path );
+        void freeAtlasPages( ICustomAsset* asset );
 
         static std::string s_fileSystemRoot;
 
         AssetsLoadingMode m_loadingMode;
-        std::map< std::string, CustomAssetFactoryData > m_customFactory;
+        CustomAssetsFactory m_customFactory;
         std::map< std::string, sf::Texture* > m_textures;
         std::map< std::string, sf::Shader* > m_shaders;
         std::map< std::string, sf::Sound* > m_sounds;
@@ -238,8 +253,12 @@ namespace Ptakopysk
         std::map< std::string, std::vector< std::string > > m_tagsFonts;
         std::map< std::string, std::vector< std::string > > m_tagsCustom;
         std::map< std::string, std::vector< std::string > > m_uniformsShaders;
+        std::map< std::string, Json::Value > m_metaAtlases;
+        std::map< const sf::Texture*, TextureRegion > m_textureRegions;
+        std::map< std::string, sf::Vector2u > m_sizesTextures;
         sf::Texture* m_defaultTexture;
         AssetsChangedListener* m_assetsChangedListener;
+        bool m_headless;
     };
 
 }
@@ -0,0 +1,55 @@
+#ifndef __PTAKOPYSK__FACTORY_REGISTRY__
+#define __PTAKOPYSK__FACTORY_REGISTRY__
+
+#include <XeCore/Common/Base.h>
+#include <XeCore/Common/IRtti.h>
+#include <string>
+#include <map>
+#include <tr1/unordered_map>
+
+namespace Ptakopysk
+{
+
+    template< typename B >
+    class FactoryRegistry
+    {
+    public:
+        struct Entry
+        {
+            std::string id;
+            XeCore::Common::IRtti::Derivation type;
+            B builder;
+        };
+
+        typedef std::tr1::unordered_map< std::string, Entry > EntriesById;
+
+        FactoryRegistry() {};
+        ~FactoryRegistry() {};
+
+        bool add( const std::string& id, XeCore::Common::IRtti::Derivation type, B builder );
+        bool removeById( const std::string& id );
+        bool removeByType( XeCore::Common::IRtti::Derivation type );
+        bool removeByBuilder( B builder );
+        void clear();
+        const Entry* findById( const std::string& id ) const;
+        const Entry* findByType( XeCore::Common::IRtti::Derivation type ) const;
+        const Entry* findByBuilder( B builder ) const;
+        FORCEINLINE const EntriesById& getEntries() const { return m_byId; };
+        FORCEINLINE unsigned int count() const { return m_byId.size(); };
+
+    private:
+        typedef std::tr1::unordered_map< XeCore::Common::IRtti::Derivation, Entry* > EntriesByType;
+        typedef std::map< B, Entry* > EntriesByBuilder;
+
+        void remove( typename EntriesById::iterator it );
+
+        EntriesById m_byId;
+        EntriesByType m_byType;
+        EntriesByBuilder m_byBuilder;
+    };
+
+}
+
+#include "FactoryRegistry.inl"
+
+#endif
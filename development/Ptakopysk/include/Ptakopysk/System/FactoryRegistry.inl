@@ -0,0 +1,121 @@
+#ifndef __PTAKOPYSK__FACTORY_REGISTRY__INLINE__
+#define __PTAKOPYSK__FACTORY_REGISTRY__INLINE__
+
+#include <XeCore/Common/Base.h>
+
+namespace Ptakopysk
+{
+
+    template< typename B >
+    bool FactoryRegistry< B >::add( const std::string& id, XeCore::Common::IRtti::Derivation type, B builder )
+    {
+        if( id.empty() || !type || !builder )
+            return false;
+        std::pair< typename EntriesById::iterator, bool > r = m_byId.insert( std::make_pair( id, Entry() ) );
+        if( !r.second )
+            return false;
+        Entry* e = &r.first->second;
+        e->id = id;
+        e->type = type;
+        e->builder = builder;
+        m_byType.insert( std::make_pair( type, e ) );
+        m_byBuilder.insert( std::make_pair( builder, e ) );
+        return true;
+    }
+
+    template< typename B >
+    bool FactoryRegistry< B >::removeById( const std::string& id )
+    {
+        typename EntriesById::iterator it = m_byId.find( id );
+        if( it == m_byId.end() )
+            return false;
+        remove( it );
+        return true;
+    }
+
+    template< typename B >
+    bool FactoryRegistry< B >::removeByType( XeCore::Common::IRtti::Derivation type )
+    {
+        typename EntriesByType::iterator it = m_byType.find( type );
+        if( it == m_byType.end() )
+            return false;
+        remove( m_byId.find( it->second->id ) );
+        return true;
+    }
+
+    template< typename B >
+    bool FactoryRegistry< B >::removeByBuilder( B builder )
+    {
+        typename EntriesByBuilder::iterator it = m_byBuilder.find( builder );
+        if( it == m_byBuilder.end() )
+            return false;
+        remove( m_byId.find( it->second->id ) );
+        return true;
+    }
+
+    template< typename B >
+    void FactoryRegistry< B >::clear()
+    {
+        m_byType.clear();
+        m_byBuilder.clear();
+        m_byId.clear();
+    }
+
+    template< typename B >
+    const typename FactoryRegistry< B >::Entry* FactoryRegistry< B >::findById( const std::string& id ) const
+    {
+        typename EntriesById::const_iterator it = m_byId.find( id );
+        return it == m_byId.end() ? 0 : &it->second;
+    }
+
+    template< typename B >
+    const typename FactoryRegistry< B >::Entry* FactoryRegistry< B >::findByType( XeCore::Common::IRtti::Derivation type ) const
+    {
+        typename EntriesByType::const_iterator it = m_byType.find( type );
+        return it == m_byType.end() ? 0 : it->second;
+    }
+
+    template< typename B >
+    const typename FactoryRegistry< B >::Entry* FactoryRegistry< B >::findByBuilder( B builder ) const
+    {
+        typename EntriesByBuilder::const_iterator it = m_byBuilder.find( builder );
+        return it == m_byBuilder.end() ? 0 : it->second;
+    }
+
+    template< typename B >
+    void FactoryRegistry< B >::remove( typename EntriesById::iterator it )
+    {
+        Entry* e = &it->second;
+        XeCore::Common::IRtti::Derivation type = e->type;
+        B builder = e->builder;
+        typename EntriesByType::iterator itt = m_byType.find( type );
+        bool retype = itt != m_byType.end() && itt->second == e;
+        if( retype )
+            m_byType.erase( itt );
+        typename EntriesByBuilder::iterator itb = m_byBuilder.find( builder );
+        bool rebuilder = itb != m_byBuilder.end() && itb->second == e;
+        if( rebuilder )
+            m_byBuilder.erase( itb );
+        m_byId.erase( it );
+        if( !retype && !rebuilder )
+            return;
+        for( typename EntriesById::iterator ite = m_byId.begin(); ite != m_byId.end(); ite++ )
+        {
+            if( retype && ite->second.type == type )
+            {
+                m_byType.insert( std::make_pair( type, &ite->second ) );
+                retype = false;
+            }
+            if( rebuilder && ite->second.builder == builder )
+            {
+                m_byBuilder.insert( std::make_pair( builder, &ite->second ) );
+                rebuilder = false;
+            }
+            if( !retype && !rebuilder )
+                break;
+        }
+    }
+
+}
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef __PTAKOPYSK__FRAME_ALLOCATOR__
+#define __PTAKOPYSK__FRAME_ALLOCATOR__
+
+#include <XeCore/Common/Base.h>
+#include <XeCore/Common/IRtti.h>
+#include <XeCore/Common/MemoryManager.h>
+#include <json/json.h>
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <new>
+
+namespace Ptakopysk
+{
+
+    class FrameAllocator
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    {
+        RTTI_CLASS_DECLARE( FrameAllocator );
+
+    public:
+        static const unsigned int DEFAULT_CAPACITY = 256 * 1024;
+        static const unsigned int DEFAULT_ALIGNMENT = 16;
+
+        FrameAllocator( unsigned int capacity = DEFAULT_CAPACITY );
+        ~FrameAllocator();
+
+        FORCEINLINE unsigned int getCapacity() { return m_capacity; };
+        FORCEINLINE unsigned int getUsed() { return m_used + m_overflowBytes; };
+        FORCEINLINE unsigned int getLastFrameUsed() { return m_lastFrameUsed; };
+        FORCEINLINE unsigned int getPeakUsed() { return m_peakUsed; };
+        FORCEINLINE unsigned int getOverflowsCount() { return m_overflowsCount; };
+        FORCEINLINE unsigned int framesCount() { return m_framesCount; };
+        FORCEINLINE unsigned int getMarker() { return m_used; };
+        FORCEINLINE bool owns( const void* ptr ) { return ptr >= m_buffer && ptr < m_buffer + m_capacity; };
+        void* allocate( unsigned int size, unsigned int alignment = DEFAULT_ALIGNMENT );
+        void deallocate( void* ptr, unsigned int size );
+        void rewind( unsigned int marker );
+        void reset();
+        void reserve( unsigned int capacity );
+        Json::Value statsToJson();
+
+        template< typename T >
+        FORCEINLINE T* allocateArray( unsigned int count ) { return (T*)allocate( count * sizeof( T ) ); };
+
+    private:
+        unsigned char* m_buffer;
+        unsigned int m_capacity;
+        unsigned int m_used;
+        unsigned int m_lastFrameUsed;
+        unsigned int m_peakUsed;
+        unsigned int m_framesCount;
+        unsigned int m_overflowsCount;
+        unsigned int m_overflowBytes;
+        std::vector< void* > m_overflows;
+    };
+
+    template< typename T >
+    class FrameAllocatorAdapter
+    {
+        template< typename U >
+        friend class FrameAllocatorAdapter;
+
+    public:
+        typedef T value_type;
+        typedef T* pointer;
+        typedef const T* const_pointer;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef std::size_t size_type;
+        typedef std::ptrdiff_t difference_type;
+
+        template< typename U >
+        struct rebind
+        {
+            typedef FrameAllocatorAdapter< U > other;
+        };
+
+        FrameAllocatorAdapter( FrameAllocator* allocator = 0 ) : m_allocator( allocator ) {};
+        FrameAllocatorAdapter( const FrameAllocatorAdapter& other ) : m_allocator( other.m_allocator ) {};
+        template< typename U >
+        FrameAllocatorAdapter( const FrameAllocatorAdapter< U >& other ) : m_allocator( other.m_allocator ) {};
+
+        FORCEINLINE FrameAllocator* getAllocator() const { return m_allocator; };
+        FORCEINLINE pointer address( reference v ) const { return &v; };
+        FORCEINLINE const_pointer address( const_reference v ) const { return &v; };
+        FORCEINLINE size_type max_size() const { return 0xFFFFFFFFu / sizeof( T ); };
+        FORCEINLINE pointer allocate( size_type count, const void* hint = 0 ) { return (pointer)( m_allocator ? m_allocator->allocate( count * sizeof( T ) ) : ::operator new( count * sizeof( T ) ) ); };
+        FORCEINLINE void deallocate( pointer ptr, size_type count ) { if( m_allocator ) m_allocator->deallocate( ptr, count * sizeof( T ) ); else ::operator delete( ptr ); };
+        FORCEINLINE void construct( pointer ptr, const T& v ) { ::new( ptr ) T( v ); };
+        FORCEINLINE void destroy( pointer ptr ) { ptr->~T(); };
+
+        template< typename U >
+        FORCEINLINE bool operator==( const FrameAllocatorAdapter< U >& other ) const { return m_allocator == other.m_allocator; };
+        template< typename U >
+        FORCEINLINE bool operator!=( const FrameAllocatorAdapter< U >& other ) const { return m_allocator != other.m_allocator; };
+
+    private:
+        FrameAllocator* m_allocator;
+    };
+
+    typedef std::basic_string< char, std::char_traits< char >, FrameAllocatorAdapter< char > > FrameString;
+
+}
+
+#endif
@@ -6,10 +6,15 @@
 #include <XeCore/Common/MemoryManager.h>
 #include <json/json.h>
 #include <list>
+#include <vector>
 #include <string>
 #include <Box2D/Box2D.h>
 #include <SFML/Graphics/RenderWindow.hpp>
+#include <SFML/System/Clock.hpp>
 #include "GameObject.h"
+#include "FactoryRegistry.h"
+#include "Jobs.h"
+#include "FrameAllocator.h"
 #include "../Components/Component.h"
 
 namespace Ptakopysk
@@ -18,6 +23,15 @@ namespace Ptakopysk
     class AssetsListener;
     class DestructionListener;
     class ContactListener;
+    class ParallelUpdateJob;
+    class RenderThread;
+    class RenderSnapshot;
+    class SpriteBatch;
+    class GlyphRunCache;
+    class SpatialGrid;
+    class RenderQueue;
+    class StateBuffer;
+    class Transform;
 
     class GameManager
         : public virtual XeCore::Common::IRtti
@@ -26,6 +40,9 @@ namespace Ptakopysk
         friend class AssetsListener;
         friend class DestructionListener;
         friend class ContactListener;
+        friend class ParallelUpdateJob;
+        friend class GameObject;
+        friend class Transform;
 
         RTTI_CLASS_DECLARE( GameManager );
 
@@ -47,9 +64,18 @@ namespace Ptakopysk
 
         typedef std::map< std::string, b2Filter > FiltersMap;
         typedef std::map< std::string, std::string > ScenesList;
+        typedef std::vector< Component* > ComponentsPool;
 
         static const int DEFAULT_VEL_ITERS = 8;
         static const int DEFAULT_POS_ITERS = 3;
+        static const unsigned int DEFAULT_MAX_SUB_STEPS = 5;
+        static const unsigned int DEFAULT_HEADLESS_FPS = 60;
+        static const unsigned int DEFAULT_RENDER_CULLING_CELL_SIZE = 256;
+        static const unsigned int STATE_SIGNATURE = 0x534B5450;
+        static const unsigned int STATE_VERSION = 1;
+        static const unsigned int HANDLE_INDEX_BITS = 20;
+        static const unsigned int HANDLE_INDEX_MASK = ( 1 << HANDLE_INDEX_BITS ) - 1;
+        static const unsigned int HANDLE_GENERATION_MASK = ( 1 << ( 31 - HANDLE_INDEX_BITS ) ) - 1;
 
         GameManager( const Json::Value& config = Json::Value::null );
         ~GameManager();
@@ -74,6 +100,16 @@ namespace Ptakopysk
         static unsigned int getComponentsIds( std::vector< std::string >& result );
         static unsigned int getComponentsTypes( std::vector< XeCore::Common::IRtti::Derivation >& result );
         static unsigned int getComponentsBuilders( std::vector< Component::OnBuildComponentCallback >& result );
+        static GameObject* buildGameObject();
+        static void recycleGameObject( GameObject* go );
+        static void recycleComponent( Component* c );
+        static void releaseRecycled();
+        static void waitForAllRenders();
+        FORCEINLINE static unsigned int getGameObjectsRecycleLimit() { return s_gameObjectsRecycleLimit; };
+        FORCEINLINE static void setGameObjectsRecycleLimit( unsigned int v ) { s_gameObjectsRecycleLimit = v; };
+        FORCEINLINE static unsigned int getComponentsRecycleLimit() { return s_componentsRecycleLimit; };
+        FORCEINLINE static void setComponentsRecycleLimit( unsigned int v ) { s_componentsRecycleLimit = v; };
+        FORCEINLINE static unsigned int recycledGameObjectsCount() { return s_gameObjectsRecycled.size(); };
 
         FORCEINLINE b2World* getPhysicsWorld() { return m_world; };
 
@@ -92,6 +128,8 @@ namespace Ptakopysk
         Json::Value sceneToJson( SceneContentType contentFlags = All, bool omitDefaultValues = false );
         Json::Value gameObjectsToJson( bool prefab = false, bool omitDefaultValues = false );
         void removeScene( SceneContentType contentFlags = All );
+        void snapshot( StateBuffer& state );
+        bool restore( StateBuffer& state );
 
         void addGameObject( GameObject* go, bool prefab = false );
         void removeGameObject( GameObject* go, bool prefab = false );
@@ -101,7 +139,9 @@ namespace Ptakopysk
         bool hasGameObject( const std::string& id, bool prefab = false );
         bool containsGameObject( GameObject* go, bool prefab = false );
         GameObject* getGameObject( const std::string& id, bool prefab = false );
+        GameObject* getGameObject( const std::string& str, unsigned int from, unsigned int length, unsigned int hash, bool prefab = false );
         GameObject* findGameObject( const std::string& path );
+        GameObject* findGameObject( const GameObjectPath& path );
         FORCEINLINE unsigned int gameObjectsCount( bool prefab = false ) { return prefab ? m_prefabGameObjects.size() : m_gameObjects.size(); };
         GameObject::List::iterator gameObjectAtBegin( bool prefab = false );
         GameObject::List::reverse_iterator gameObjectAtReversedBegin( bool prefab = false );
@@ -109,6 +149,11 @@ namespace Ptakopysk
         GameObject::List::reverse_iterator gameObjectAtReversedEnd( bool prefab = false );
         GameObject* gameObjectAt( unsigned int index );
         GameObject* instantiatePrefab( const std::string& id );
+        unsigned int instantiatePrefab( const std::string& id, unsigned int count, std::vector< GameObject* >& result );
+        GameObject::Handle getHandle( GameObject* go );
+        FORCEINLINE GameObject* resolve( GameObject::Handle handle ) { unsigned int i = handle & HANDLE_INDEX_MASK; return handle && i < m_handleSlots.size() && m_handleSlots[ i ].generation == ( handle >> HANDLE_INDEX_BITS ) ? m_handleSlots[ i ].object : 0; };
+        FORCEINLINE bool isHandleValid( GameObject::Handle handle ) { return resolve( handle ) != 0; };
+        FORCEINLINE unsigned int handlesCount() { return m_handleSlots.size() - m_handleFreeSlots.size(); };
 
         FORCEINLINE b2Vec2 getWorldGravity() { return m_world->GetGravity(); };
         FORCEINLINE void setWorldGravity( b2Vec2 v ) { m_world->SetGravity( v ); };
@@ -117,29 +162,110 @@ namespace Ptakopysk
         FORCEINLINE FiltersMap& accessFilters() { return m_filters; }
 
         void processLifeCycle();
+        void stopLifeCycle();
+        FORCEINLINE bool isRunning() { return m_running; };
         void processRunningScene();
         void processEvents( const sf::Event& event );
         void processPhysics( float dt, int velIters = DEFAULT_VEL_ITERS, int posIters = DEFAULT_POS_ITERS );
         void processUpdate( float dt, bool sort = true );
         void processRender( sf::RenderTarget* target = 0 );
         void processRenderEditor( sf::View& view, sf::RenderTarget* target = 0 );
+        void processRenderSnapshot( RenderSnapshot& snapshot );
+        void waitForRender();
         void processAdding();
         void processRemoving();
+        void sortGameObjects();
         bool isWaitingToAdd( GameObject* go );
         bool isWaitingToRemove( GameObject* go );
         FORCEINLINE float getFixedStep() { return m_fixedStep; };
         FORCEINLINE void setFixedStep( float v ) { m_fixedStep = v; };
+        FORCEINLINE float getTargetFrameStep() { return m_targetFrameStep; };
+        FORCEINLINE void setTargetFrameStep( float v ) { m_targetFrameStep = v; };
+        FORCEINLINE unsigned int getMaxSubSteps() { return m_maxSubSteps; };
+        FORCEINLINE void setMaxSubSteps( unsigned int v ) { m_maxSubSteps = v; };
+        FORCEINLINE bool isInterpolating() { return m_interpolating; };
+        FORCEINLINE void setInterpolating( bool mode ) { m_interpolating = mode; };
+        FORCEINLINE float getInterpolationAlpha() { return m_interpolationAlpha; };
+        FORCEINLINE bool isDeterministic() { return m_deterministic; };
+        void setDeterministic( bool mode );
+        FORCEINLINE bool isHeadless() { return m_headless; };
+        FORCEINLINE void setHeadless( bool mode ) { m_headless = mode; Assets::use().setHeadless( mode ); };
+        FORCEINLINE bool isHeadlessRealTime() { return m_headlessRealTime; };
+        FORCEINLINE void setHeadlessRealTime( bool mode ) { m_headlessRealTime = mode; };
+        FORCEINLINE unsigned int getMaxSteps() { return m_maxSteps; };
+        FORCEINLINE void setMaxSteps( unsigned int v ) { m_maxSteps = v; };
+        FORCEINLINE unsigned int getStepsCount() { return m_stepsCount; };
+        FORCEINLINE Jobs* getJobs() { return m_jobs; };
+        FORCEINLINE bool isPipelined() { return m_pipelined; };
+        FORCEINLINE void setPipelined( bool mode ) { m_pipelined = mode; };
+        FORCEINLINE bool isSpriteBatching() { return m_spriteBatching; };
+        FORCEINLINE void setSpriteBatching( bool mode ) { m_spriteBatching = mode; };
+        FORCEINLINE SpriteBatch* getSpriteBatch() { return m_spriteBatch; };
+        FORCEINLINE GlyphRunCache* getGlyphRunCache() { return m_glyphRunCache; };
+        FORCEINLINE bool isRenderSorting() { return m_renderSorting; };
+        FORCEINLINE void setRenderSorting( bool mode ) { m_renderSorting = mode; };
+        FORCEINLINE RenderQueue* getRenderQueue() { return m_renderQueue; };
+        FORCEINLINE bool isRenderCulling() { return m_spatialGrid != 0; };
+        void setRenderCulling( bool mode );
+        FORCEINLINE SpatialGrid* getSpatialGrid() { return m_spatialGrid; };
+        FORCEINLINE bool isParallelUpdate() { return m_parallelUpdate; };
+        FORCEINLINE void setParallelUpdate( bool mode ) { m_parallelUpdate = mode; };
+        FORCEINLINE unsigned int getParallelUpdateBatch() { return m_parallelUpdateBatch; };
+        FORCEINLINE void setParallelUpdateBatch( unsigned int v ) { m_parallelUpdateBatch = v; };
+        FORCEINLINE JobsFence* getFrameFence() { return &m_frameFence; };
+        FORCEINLINE bool submitFrameJob( Job* job ) { return m_jobs->submit( job, &m_frameFence ); };
+        FORCEINLINE FrameAllocator* getFrameAllocator() { return m_frameAllocator; };
+        void processInterpolation( float alpha );
+        /// Components pooling updates components per type instead of per game object:
+        /// pending adds and removes of the whole tree are applied before any onUpdate,
+        /// so objects queued before the update pass are updated in that same frame and
+        /// objects queued during it are updated in the next one;
+        /// all onUpdate calls run before world transforms are propagated, so onUpdate
+        /// sees world transforms of the previous frame.
+        FORCEINLINE bool isComponentsPooling() { return m_componentsPooling; };
+        void setComponentsPooling( bool mode );
+        ComponentsPool* getComponentsPool( XeCore::Common::IRtti::Derivation type );
+        template< typename T >
+        FORCEINLINE ComponentsPool* getComponentsPool() { return getComponentsPool( RTTI_CLASS_TYPE( T ) ); };
+        FORCEINLINE unsigned int componentsPoolsCount() { return m_componentsPools.size(); };
+        FORCEINLINE ComponentsPool* componentsPoolAt( unsigned int slot ) { return slot < m_componentsPools.size() ? &m_componentsPools[ slot ] : 0; };
 
         XeCore::Common::Property< b2Vec2, GameManager > PhysicsGravity;
         XeCore::Common::Property< sf::RenderWindow*, GameManager > RenderWindow;
 
     private:
-        struct ComponentFactoryData
+        typedef FactoryRegistry< Component::OnBuildComponentCallback > ComponentsFactory;
+
+        /// Component values are copied with source->onDuplicate(), not as a raw blob:
+        /// components own strings, SFML drawables and Box2D bodies, none of which are POD.
+        struct PrefabTemplateComponent
         {
+            Component* source;
             XeCore::Common::IRtti::Derivation type;
             Component::OnBuildComponentCallback builder;
         };
 
+        struct PrefabTemplateNode
+        {
+            GameObject* source;
+            int parent;
+            unsigned int componentsBegin;
+            unsigned int componentsEnd;
+        };
+
+        struct PrefabTemplate
+        {
+            unsigned int revision;
+            std::vector< PrefabTemplateNode > nodes;
+            std::vector< PrefabTemplateComponent > components;
+        };
+
+        struct HandleSlot
+        {
+            GameObject* object;
+            unsigned int generation;
+        };
+
         void setupFromConfig( const Json::Value& config );
         void processContact( bool beginOrEnd, GameObject* a, GameObject* b, b2Contact* contact );
         void processJointGoodbye( GameObject* o, b2Joint* joint );
@@ -150,9 +276,41 @@ namespace Ptakopysk
         void processMusicChanged( const sf::Music* p, bool addedOrRemoved );
         void processFontChanged( const sf::Font* p, bool addedOrRemoved );
         void processCustomAssetChanged( const ICustomAsset* p, bool addedOrRemoved );
+        void registerComponentInPool( Component* c );
+        void unregisterComponentFromPool( Component* c );
+        void registerInterpolatedTransform( Transform* t );
+        void unregisterInterpolatedTransform( Transform* t );
+        void attachComponentsPools( GameObject::List& list, bool mode );
+        void processUpdatePools( float dt, bool sort );
+        void compactComponentsPools();
+        void processParallelUpdate( float dt );
+        void processParallelUpdate( unsigned int from, unsigned int to );
+        void processHeadlessLifeCycle();
+        void processSteps( float dt );
+        void processStep( float dt );
+        void processPending();
+        void saveGameObjectsState( StateBuffer& state, GameObject::List& list );
+        bool validateGameObjectsStructure( StateBuffer& state, GameObject::List& list );
+        void updateGameObjectsCulling( GameObject::List& list );
+        bool restoreGameObjectsStructure( StateBuffer& state, GameObject* parent );
+        void restoreGameObjectsState( StateBuffer& state, GameObject::List& list );
+        static bool skipComponentsState( StateBuffer& state );
+        void waitForDeadline( sf::Clock& clock, sf::Time& deadline );
+        void startRenderPipeline();
+        void stopRenderPipeline();
+        void releaseHandle( GameObject* go );
+        PrefabTemplate& compilePrefab( GameObject* prefab );
+        void compilePrefabNode( PrefabTemplate& result, GameObject* source, int parent );
+        GameObject* instantiatePrefabTemplate( PrefabTemplate& t );
+        static Component* reuseComponent( XeCore::Common::IRtti::Derivation type );
 
-        static std::map< std::string, ComponentFactoryData > s_componentsFactory;
+        static ComponentsFactory s_componentsFactory;
         static bool s_editMode;
+        static std::vector< GameObject* > s_gameObjectsRecycled;
+        static std::map< XeCore::Common::IRtti::Derivation, std::vector< Component* > > s_componentsRecycled;
+        static unsigned int s_gameObjectsRecycleLimit;
+        static unsigned int s_componentsRecycleLimit;
+        static std::vector< RenderThread* > s_renderThreads;
 
         b2World* m_world;
         sf::RenderWindow* m_renderWindow;
@@ -163,9 +321,54 @@ namespace Ptakopysk
         GameObject::List m_gameObjects;
         GameObject::List m_gameObjectsToCreate;
         GameObject::List m_gameObjectsToDestroy;
+        GameObject::IdsIndex m_prefabGameObjectsIndex;
+        GameObject::IdsIndex m_gameObjectsIndex;
         FiltersMap m_filters;
         sf::Color m_bgColor;
         float m_fixedStep;
+        float m_targetFrameStep;
+        unsigned int m_maxSubSteps;
+        bool m_interpolating;
+        float m_interpolationAlpha;
+        std::vector< Transform* > m_interpolatedTransforms;
+        float m_fixedStepAccum;
+        bool m_deterministic;
+        bool m_headless;
+        bool m_headlessRealTime;
+        bool m_running;
+        unsigned int m_maxSteps;
+        unsigned int m_stepsCount;
+        unsigned int m_jobsWorkers;
+        Jobs* m_jobs;
+        JobsFence m_frameFence;
+        FrameAllocator* m_frameAllocator;
+        unsigned int m_frameAllocatorCapacity;
+        bool m_parallelUpdate;
+        unsigned int m_parallelUpdateBatch;
+        std::vector< Component* > m_parallelUpdateComponents;
+        float m_parallelUpdateDt;
+        bool m_pipelined;
+        RenderThread* m_renderThread;
+        RenderSnapshot* m_renderSnapshots[ 2 ];
+        unsigned int m_renderSnapshotIndex;
+        bool m_spriteBatching;
+        SpriteBatch* m_spriteBatch;
+        GlyphRunCache* m_glyphRunCache;
+        bool m_renderSorting;
+        RenderQueue* m_renderQueue;
+        bool m_renderCulling;
+        float m_renderCullingCellSize;
+        SpatialGrid* m_spatialGrid;
+        bool m_componentsPooling;
+        std::vector< ComponentsPool > m_componentsPools;
+        bool m_componentsPoolsSweeping;
+        bool m_componentsPoolsDirty;
+        unsigned int m_updateFrame;
+        bool m_gameObjectsOrderDirty;
+        std::vector< HandleSlot > m_handleSlots;
+        std::vector< unsigned int > m_handleFreeSlots;
+        std::map< GameObject*, PrefabTemplate > m_prefabTemplates;
+        std::vector< GameObject* > m_prefabInstanceNodes;
         ScenesList m_scenes;
         std::string m_sceneToRun;
     };
@@ -4,6 +4,7 @@
 #include <XeCore/Common/Property.h>
 #include <XeCore/Common/IRtti.h>
 #include <XeCore/Common/MemoryManager.h>
+#include <XeCore/Common/Concurrent/Thread.h>
 #include <json/json.h>
 #include <SFML/Graphics/RenderTarget.hpp>
 #include <SFML/Audio/Sound.hpp>
@@ -11,9 +12,13 @@
 #include <SFML/Graphics/Font.hpp>
 #include <SFML/Window/Event.hpp>
 #include <list>
+#include <vector>
+#include <map>
+#include <tr1/unordered_map>
 #include <string>
 #include "../Serialization/Serialized.h"
 #include "Assets.h"
+#include "GameObjectPath.h"
 
 class b2Contact;
 class b2Joint;
@@ -24,6 +29,8 @@ namespace Ptakopysk
 
     class Component;
     class GameManager;
+    class RenderSnapshot;
+    class RenderQueue;
 
     class GameObject
     : public virtual XeCore::Common::IRtti
@@ -37,6 +44,14 @@ namespace Ptakopysk
         typedef std::list< GameObject* > List;
         typedef std::pair< XeCore::Common::IRtti::Derivation, Component* > ComponentDataPair;
         typedef std::list< ComponentDataPair > Components;
+        struct IdsIndexEntry
+        {
+            GameObject* object;
+            unsigned int count;
+        };
+        typedef std::tr1::unordered_map< unsigned int, IdsIndexEntry > IdsIndex;
+        typedef unsigned int Handle;
+        typedef std::map< XeCore::Common::IRtti::Derivation, unsigned int > ComponentsTypeSlots;
 
         GameObject( const std::string& id = "" );
         virtual ~GameObject();
@@ -45,16 +60,20 @@ namespace Ptakopysk
         FORCEINLINE bool isPrefab() { return m_prefab; };
         FORCEINLINE GameObject* getPrefab() { return m_instanceOf; };
         FORCEINLINE std::string getId() { return m_id; };
-        FORCEINLINE void setId( std::string id ) { m_id = id; };
+        void setId( std::string id );
         FORCEINLINE bool isActive() { return m_active; };
-        FORCEINLINE void setActive( bool mode = true ) { m_active = mode; };
+        FORCEINLINE void setActive( bool mode = true ) { m_active = mode; invalidateTransform(); };
         FORCEINLINE int getOrder() { return m_order; };
-        FORCEINLINE void setOrder( int order ) { m_order = order; };
+        void setOrder( int order );
         FORCEINLINE const Json::Value& getMetaData() { return m_metaData; };
         FORCEINLINE void setMetaData( const Json::Value& meta ) { m_metaData = meta; };
         FORCEINLINE GameManager* getGameManager() { return m_gameManager; };
         FORCEINLINE GameObject* getParent() { return m_parent; };
         GameManager* getGameManagerRoot();
+        Handle getHandle();
+        FORCEINLINE const sf::Transform& getWorldTransform() { return m_worldTransform; };
+        FORCEINLINE bool isTransformDirty() { return m_transformDirty; };
+        void invalidateTransform();
 
         void fromJson( const Json::Value& root );
         Json::Value toJson( bool omitDefaultValues = false );
@@ -69,10 +88,14 @@ namespace Ptakopysk
         bool hasComponent( Component* c );
         bool hasComponent( XeCore::Common::IRtti::Derivation d );
         template< typename T >
-        FORCEINLINE bool hasComponent() { return hasComponent( RTTI_CLASS_TYPE( T ) ); };
+        FORCEINLINE bool hasComponent() { return getComponent< T >() != 0; };
         Component* getComponent( XeCore::Common::IRtti::Derivation d );
         template< typename T >
-        FORCEINLINE T* getComponent() { return (T*)getComponent( RTTI_CLASS_TYPE( T ) ); };
+        FORCEINLINE T* getComponent() { static const unsigned int slot = componentTypeSlot( RTTI_CLASS_TYPE( T ) ); return (T*)getComponentAtSlot( slot ); };
+        FORCEINLINE Component* getComponentAtSlot( unsigned int slot ) { return slot < m_componentsSlots.size() ? m_componentsSlots[ slot ] : 0; };
+        static unsigned int componentTypeSlot( XeCore::Common::IRtti::Derivation d );
+        static unsigned int componentTypesCount();
+        FORCEINLINE static unsigned int getPrefabsRevision() { return s_prefabsRevision; };
         Component* getOrCreateComponent( XeCore::Common::IRtti::Derivation d );
         template< typename T >
         FORCEINLINE T* getOrCreateComponent() { return (T*)getOrCreateComponent( RTTI_CLASS_TYPE( T ) ); };
@@ -96,7 +119,9 @@ namespace Ptakopysk
         bool hasGameObject( const std::string& id );
         bool containsGameObject( GameObject* go );
         GameObject* getGameObject( const std::string& id );
+        GameObject* getGameObject( const std::string& str, unsigned int from, unsigned int length, unsigned int hash );
         GameObject* findGameObject( const std::string& path );
+        GameObject* findGameObject( const GameObjectPath& path );
         FORCEINLINE unsigned int gameObjectsCount() { return m_gameObjects.size(); };
         FORCEINLINE List::iterator gameObjectAtBegin() { return m_gameObjects.begin(); };
         FORCEINLINE List::reverse_iterator gameObjectAtReversedBegin() { return m_gameObjects.rbegin(); };
@@ -104,6 +129,7 @@ namespace Ptakopysk
         FORCEINLINE List::reverse_iterator gameObjectAtReversedEnd() { return m_gameObjects.rend(); };
         void processAdding();
         void processRemoving();
+        void sortGameObjects();
         bool isWaitingToAdd( GameObject* go );
         bool isWaitingToRemove( GameObject* go );
 
@@ -121,8 +147,15 @@ namespace Ptakopysk
         void onDestroy();
         void onDuplicate( GameObject* dst );
         void onEvent( const sf::Event& event );
-        void onUpdate( float dt, const sf::Transform& trans, bool sort = true );
+        void onUpdate( float dt, const sf::Transform& trans, bool sort = true, bool transformDirty = false, unsigned int parallelFrame = 0 );
+        void onCollectParallelUpdate( std::vector< Component* >& result, unsigned int frame );
+        void onUpdatePrepare( unsigned int frame, bool sort = true );
+        void onUpdateTransform( const sf::Transform& trans, bool transformDirty = false );
+        void onFlushPending();
         void onRender( sf::RenderTarget*& target );
+        void onRenderSnapshot( RenderSnapshot& snapshot );
+        void onRenderQueue( RenderQueue& queue );
+        static void onRenderQueueList( List::iterator begin, List::iterator end, RenderQueue& queue );
         void onRenderEditor( sf::RenderTarget* target );
         void onCollide( GameObject* other, bool beginOrEnd, b2Contact* contact );
         void onJointGoodbye( b2Joint* joint );
@@ -135,27 +168,61 @@ namespace Ptakopysk
         void onCustomAssetChanged( const ICustomAsset* a, bool addedOrRemoved );
 
     private:
+        enum MembershipState
+        {
+            msNone,
+            msWaitingToAdd,
+            msAdded,
+            msWaitingToRemove
+        };
+
         FORCEINLINE void setGameManager( GameManager* gm ) { m_gameManager = gm; };
-        FORCEINLINE void setParent( GameObject* go ) { m_parent = go; };
+        FORCEINLINE void setParent( GameObject* go ) { m_parent = go; m_transformDirty = true; };
         FORCEINLINE void setInstanceOf( GameObject* go ) { m_instanceOf = go; };
         void setPrefab( bool mode );
         void setDestroying( bool mode );
-        GameObject* findGameObjectInPartOfPath( const std::string& path, unsigned int from );
+        void reset();
+        void attachComponentsToPools( GameManager* gm );
+        void detachComponentsFromPools();
+        void destroyComponent( Component* c );
+        bool processTransform( const sf::Transform& trans, bool transformDirty );
+        FORCEINLINE bool isAddedTo( GameObject* parent ) { return m_parent == parent && ( m_membership == msAdded || m_membership == msWaitingToRemove ); };
+        static void indexGameObject( IdsIndex& index, GameObject* go );
+        static void unindexGameObject( IdsIndex& index, GameObject* go );
+        static GameObject* findIndexedGameObject( IdsIndex& index, List& list, const std::string& str, unsigned int from, unsigned int length, unsigned int hash );
+        static void releaseRetiredComponentTypeSlots();
 
         GameManager* m_gameManager;
         GameObject* m_parent;
         GameObject* m_instanceOf;
         bool m_prefab;
         std::string m_id;
+        unsigned int m_idHash;
+        Handle m_handle;
+        GameManager* m_handleOwner;
         bool m_active;
         int m_order;
         bool m_isDestroying;
+        MembershipState m_membership;
         Json::Value m_metaData;
         Components m_components;
         Components m_componentsToDestroyDelayed;
+        std::vector< Component* > m_componentsSlots;
+        GameManager* m_componentsPoolsOwner;
+        unsigned int m_updateFrame;
+        sf::Transform m_worldTransform;
+        bool m_transformDirty;
+        bool m_transformChildDirty;
+        bool m_gameObjectsOrderDirty;
         List m_gameObjects;
         List m_gameObjectsToCreate;
         List m_gameObjectsToDestroy;
+        IdsIndex m_gameObjectsIndex;
+
+        static const ComponentsTypeSlots* volatile s_componentsTypeSlots;
+        static std::vector< const ComponentsTypeSlots* > s_componentsTypeSlotsRetired;
+        static tthread::mutex s_componentsTypeSlotsMutex;
+        static unsigned int s_prefabsRevision;
     };
 
 }
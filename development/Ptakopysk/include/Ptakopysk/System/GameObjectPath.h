@@ -0,0 +1,66 @@
+#ifndef __PTAKOPYSK__GAME_OBJECT_PATH__
+#define __PTAKOPYSK__GAME_OBJECT_PATH__
+
+#include <XeCore/Common/Base.h>
+#include <XeCore/Common/IRtti.h>
+#include <XeCore/Common/MemoryManager.h>
+#include <string>
+#include <vector>
+
+namespace Ptakopysk
+{
+
+    class GameObject;
+    class GameManager;
+
+    class GameObjectPath
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    {
+        RTTI_CLASS_DECLARE( GameObjectPath );
+
+    public:
+        enum SegmentType
+        {
+            stName,
+            stCurrent,
+            stParent
+        };
+
+        struct Segment
+        {
+            SegmentType type;
+            unsigned int from;
+            unsigned int length;
+            unsigned int hash;
+        };
+
+        GameObjectPath( const std::string& path = "" );
+        GameObjectPath( const GameObjectPath& path );
+        ~GameObjectPath();
+
+        GameObjectPath& operator=( const GameObjectPath& path );
+
+        static unsigned int hash( const std::string& str, std::string::size_type from = 0, std::string::size_type length = std::string::npos );
+        static bool isValid( const std::string& path );
+        static bool nextSegment( const std::string& path, unsigned int& from, Segment& result );
+        static GameObject* resolve( const std::string& path, GameObject* go, GameManager* gm );
+        static GameObject* resolve( const GameObjectPath& path, GameObject* go, GameManager* gm );
+
+        void compile( const std::string& path );
+        FORCEINLINE const std::string& getPath() const { return m_path; };
+        FORCEINLINE bool isValid() const { return m_valid; };
+        FORCEINLINE bool isAbsolute() const { return m_absolute; };
+        FORCEINLINE unsigned int segmentsCount() const { return m_segments.size(); };
+        FORCEINLINE const Segment& segmentAt( unsigned int index ) const { return m_segments[ index ]; };
+
+    private:
+        std::string m_path;
+        bool m_valid;
+        bool m_absolute;
+        std::vector< Segment > m_segments;
+    };
+
+}
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef __PTAKOPYSK__GLYPH_RUN_CACHE__
+#define __PTAKOPYSK__GLYPH_RUN_CACHE__
+
+#include <XeCore/Common/Base.h>
+#include <XeCore/Common/IRtti.h>
+#include <XeCore/Common/MemoryManager.h>
+#include <XeCore/Common/Concurrent/Thread.h>
+#include <SFML/Graphics/Font.hpp>
+#include <SFML/Graphics/Vertex.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/String.hpp>
+#include <vector>
+#include <map>
+#include <string>
+
+namespace Ptakopysk
+{
+
+    class GlyphRunCache
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    {
+        RTTI_CLASS_DECLARE( GlyphRunCache );
+
+    public:
+        static const unsigned int DEFAULT_CAPACITY = 2048;
+
+        struct Run
+        {
+            std::vector< sf::Vertex > vertices;
+            sf::FloatRect bounds;
+            const sf::Texture* texture;
+            unsigned int lastFrame;
+        };
+
+        GlyphRunCache( unsigned int capacity = DEFAULT_CAPACITY );
+        ~GlyphRunCache();
+
+        /// shared cache for text renderers outside of any game manager.
+        static GlyphRunCache& use();
+        static void removeFontFromAll( const sf::Font* font );
+        /// guards sf::Font glyph pages shared with the render thread.
+        static tthread::mutex& fontsMutex();
+        static void layout( Run& run, const std::basic_string< sf::Uint32 >& text, const sf::Font& font, unsigned int size, unsigned int style );
+
+        FORCEINLINE unsigned int getCapacity() { return m_capacity; };
+        FORCEINLINE void setCapacity( unsigned int v ) { m_capacity = v; };
+        FORCEINLINE unsigned int getRevision() { return m_revision; };
+        FORCEINLINE unsigned int runsCount() { return m_runs.size(); };
+        FORCEINLINE unsigned int getHitsCount() { return m_hits; };
+        FORCEINLINE unsigned int getMissesCount() { return m_misses; };
+        FORCEINLINE void touch( Run* run ) { run->lastFrame = m_frame; m_hits++; };
+        Run* acquire( const sf::String& text, const sf::Font* font, unsigned int size, unsigned int style );
+        void removeFont( const sf::Font* font );
+        void endFrame();
+        void clear();
+
+    private:
+        struct Key
+        {
+            std::basic_string< sf::Uint32 > text;
+            const sf::Font* font;
+            unsigned int size;
+            unsigned int style;
+
+            bool operator<( const Key& other ) const;
+        };
+
+        typedef std::map< Key, Run > Runs;
+
+        static std::vector< GlyphRunCache* >& caches();
+        static unsigned int nextRevision();
+
+        Runs m_runs;
+        unsigned int m_capacity;
+        unsigned int m_frame;
+        unsigned int m_revision;
+        unsigned int m_hits;
+        unsigned int m_misses;
+    };
+
+}
+
+#endif
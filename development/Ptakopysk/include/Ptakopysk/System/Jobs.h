@@ -0,0 +1,113 @@
+#ifndef __PTAKOPYSK__JOBS__
+#define __PTAKOPYSK__JOBS__
+
+#include <XeCore/Common/Base.h>
+#include <XeCore/Common/IRtti.h>
+#include <XeCore/Common/MemoryManager.h>
+#include <XeCore/Common/Concurrent/Thread.h>
+#include <vector>
+#include <deque>
+
+namespace Ptakopysk
+{
+
+    class FrameAllocator;
+
+    class JobsFence
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    {
+        RTTI_CLASS_DECLARE( JobsFence );
+        friend class Jobs;
+
+    public:
+        JobsFence();
+        ~JobsFence();
+
+        FORCEINLINE bool isSignaled() { return !__sync_fetch_and_add( &m_pending, 0 ); };
+
+    private:
+        volatile unsigned int m_pending;
+    };
+
+    class Job
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    {
+        RTTI_CLASS_DECLARE( Job );
+        friend class Jobs;
+
+    public:
+        Job();
+        virtual ~Job();
+
+        FORCEINLINE bool isDone() { return __sync_fetch_and_add( &m_done, 0 ) != 0; };
+
+    protected:
+        virtual void onExecute() = 0;
+
+    private:
+        volatile unsigned int m_done;
+        bool m_submitted;
+        unsigned int m_waiting;
+        JobsFence* m_fence;
+        std::vector< Job* > m_continuations;
+    };
+
+    class IParallelForJob
+    {
+        friend class Jobs;
+
+    public:
+        virtual ~IParallelForJob() {};
+
+    protected:
+        virtual void onExecute( unsigned int from, unsigned int to ) = 0;
+    };
+
+    class Jobs
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    {
+        RTTI_CLASS_DECLARE( Jobs );
+
+    public:
+        Jobs( unsigned int workersCount = 0 );
+        ~Jobs();
+
+        static unsigned int autoWorkersCount();
+
+        FORCEINLINE unsigned int workersCount() { return m_workers.size(); };
+        bool addDependency( Job* job, Job* dependency );
+        bool submit( Job* job, JobsFence* fence = 0 );
+        void wait( JobsFence* fence );
+        void wait( Job* job );
+        void parallelFor( IParallelForJob* job, unsigned int count, unsigned int batchSize = 0, FrameAllocator* scratch = 0 );
+        bool processJob();
+
+    private:
+        class Worker;
+        class ParallelForBatch;
+        typedef std::deque< Job* > Queue;
+
+        void processWorker( unsigned int index );
+        void help( JobsFence* fence, Job* job );
+        void enqueue( Job* job );
+        Job* takeJob( unsigned int queue );
+        void execute( Job* job );
+
+        tthread::mutex m_stateMutex;
+        tthread::condition_variable m_workCondition;
+        tthread::condition_variable m_doneCondition;
+        std::vector< Worker* > m_workers;
+        std::vector< Queue > m_queues;
+        std::vector< XeCore::Common::Concurrent::Synchronized* > m_queuesSync;
+        volatile unsigned int m_nextQueue;
+        volatile unsigned int m_queued;
+        volatile unsigned int m_sleeping;
+        volatile bool m_working;
+    };
+
+}
+
+#endif
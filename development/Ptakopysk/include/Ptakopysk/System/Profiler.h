@@ -0,0 +1,147 @@
+#ifndef __PTAKOPYSK__PROFILER__
+#define __PTAKOPYSK__PROFILER__
+
+#include <XeCore/Common/Base.h>
+#include <XeCore/Common/IRtti.h>
+#include <XeCore/Common/MemoryManager.h>
+#include <XeCore/Common/Singleton.h>
+#include <SFML/System/Clock.hpp>
+#include <json/json.h>
+#include <vector>
+#include <deque>
+#include <map>
+#include <string>
+
+namespace Ptakopysk
+{
+
+    class Profiler
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    , public XeCore::Common::Singleton< Profiler >
+    {
+        RTTI_CLASS_DECLARE( Profiler );
+
+    public:
+        enum ComponentPhase
+        {
+            cpUpdate,
+            cpRender,
+            cpCount
+        };
+
+        struct Zone
+        {
+            const char* name;
+            int parent;
+            unsigned int depth;
+            sf::Int64 start;
+            sf::Int64 duration;
+        };
+
+        struct Frame
+        {
+            unsigned int index;
+            sf::Int64 start;
+            sf::Int64 duration;
+            std::vector< Zone > zones;
+        };
+
+        struct Stats
+        {
+            unsigned int calls;
+            sf::Int64 time;
+            sf::Int64 maxTime;
+        };
+
+        typedef std::map< std::string, Stats > ZonesStats;
+        typedef std::map< XeCore::Common::IRtti::Derivation, Stats > ComponentsStats;
+
+        static const unsigned int DEFAULT_TRACE_FRAMES_LIMIT = 300;
+
+        Profiler();
+        ~Profiler();
+
+        FORCEINLINE bool isEnabled() { return m_enabled; };
+        FORCEINLINE void setEnabled( bool mode ) { m_enabled = mode; };
+        FORCEINLINE unsigned int getTraceFramesLimit() { return m_traceFramesLimit; };
+        FORCEINLINE void setTraceFramesLimit( unsigned int v ) { m_traceFramesLimit = v; };
+        FORCEINLINE sf::Int64 now() { return m_clock.getElapsedTime().asMicroseconds(); };
+        FORCEINLINE unsigned int framesCount() { return m_framesCount; };
+        FORCEINLINE const Frame& getLastFrame() { return m_lastFrame; };
+        FORCEINLINE unsigned int traceFramesCount() { return m_trace.size(); };
+        FORCEINLINE const Frame& traceFrameAt( unsigned int index ) { return m_trace[ index ]; };
+        FORCEINLINE const ZonesStats& getZonesStats() { return m_zonesStats; };
+        FORCEINLINE const ComponentsStats& getComponentsStats( ComponentPhase phase ) { return m_componentsStats[ phase ]; };
+        Stats getZoneStats( const std::string& name );
+        Stats getComponentStats( XeCore::Common::IRtti::Derivation type, ComponentPhase phase );
+
+        void beginFrame();
+        void endFrame();
+        int beginZone( const char* name );
+        void endZone( int index );
+        void addComponentSample( XeCore::Common::IRtti::Derivation type, ComponentPhase phase, sf::Int64 time );
+        void reset();
+        Json::Value statsToJson();
+        bool saveChromeTrace( const std::string& path );
+
+    private:
+        static void accumulate( Stats& stats, sf::Int64 time );
+
+        sf::Clock m_clock;
+        bool m_enabled;
+        bool m_frameActive;
+        unsigned int m_framesCount;
+        unsigned int m_traceFramesLimit;
+        int m_currentZone;
+        Frame m_frame;
+        Frame m_lastFrame;
+        std::deque< Frame > m_trace;
+        ZonesStats m_zonesStats;
+        ComponentsStats m_componentsStats[ cpCount ];
+    };
+
+    class ProfilerFrame
+    {
+    public:
+        FORCEINLINE ProfilerFrame() { Profiler::use().beginFrame(); };
+        FORCEINLINE ~ProfilerFrame() { Profiler::use().endFrame(); };
+    };
+
+    class ProfilerZone
+    {
+    public:
+        FORCEINLINE ProfilerZone( const char* name ) : m_index( Profiler::use().beginZone( name ) ) {};
+        FORCEINLINE ~ProfilerZone() { Profiler::use().endZone( m_index ); };
+
+    private:
+        int m_index;
+    };
+
+    class ProfilerComponent
+    {
+    public:
+        FORCEINLINE ProfilerComponent( XeCore::Common::IRtti* object, Profiler::ComponentPhase phase ) : m_object( object ), m_phase( phase ), m_start( Profiler::use().isEnabled() ? Profiler::use().now() : -1 ) {};
+        FORCEINLINE ~ProfilerComponent() { if( m_start >= 0 ) Profiler::use().addComponentSample( m_object->getType(), m_phase, Profiler::use().now() - m_start ); };
+
+    private:
+        XeCore::Common::IRtti* m_object;
+        Profiler::ComponentPhase m_phase;
+        sf::Int64 m_start;
+    };
+
+}
+
+#ifdef PTAKOPYSK_PROFILER
+#define PROFILE_CONCAT_INNER( a, b ) a##b
+#define PROFILE_CONCAT( a, b ) PROFILE_CONCAT_INNER( a, b )
+#define PROFILE_FRAME() Ptakopysk::ProfilerFrame PROFILE_CONCAT( __profilerFrame, __LINE__ )
+#define PROFILE_ZONE( name ) Ptakopysk::ProfilerZone PROFILE_CONCAT( __profilerZone, __LINE__ )( name )
+#define PROFILE_COMPONENT( component, phase ) Ptakopysk::ProfilerComponent PROFILE_CONCAT( __profilerComponent, __LINE__ )( component, Ptakopysk::Profiler::phase )
+#else
+#define PROFILE_FRAME()
+#define PROFILE_ZONE( name )
+#define PROFILE_COMPONENT( component, phase )
+#endif
+
+#endif
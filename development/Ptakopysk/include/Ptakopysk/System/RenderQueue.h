@@ -0,0 +1,76 @@
+#ifndef __PTAKOPYSK__RENDER_QUEUE__
+#define __PTAKOPYSK__RENDER_QUEUE__
+
+#include <XeCore/Common/Base.h>
+#include <XeCore/Common/IRtti.h>
+#include <XeCore/Common/MemoryManager.h>
+#include <SFML/Config.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/Shader.hpp>
+#include <SFML/Graphics/Texture.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <vector>
+#include <map>
+
+namespace Ptakopysk
+{
+
+    class Component;
+    class SpriteBatch;
+
+    class RenderQueue
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    {
+        RTTI_CLASS_DECLARE( RenderQueue );
+
+    public:
+        static const unsigned int PASS_BITS = 8;
+        static const unsigned int RANK_BITS = 24;
+        static const unsigned int SHADER_BITS = 16;
+        static const unsigned int TEXTURE_BITS = 16;
+
+        RenderQueue();
+        ~RenderQueue();
+
+        static sf::Uint64 makeKey( unsigned int pass, unsigned int rank, unsigned int shader, unsigned int texture );
+
+        FORCEINLINE unsigned int getRanksCount() { return m_ranks.size(); };
+        FORCEINLINE unsigned int getPassesCount() { return m_pass + 1; };
+        FORCEINLINE unsigned int getPacketsCount() { return m_packets.size(); };
+        FORCEINLINE unsigned int getLastPacketsCount() { return m_lastPackets; };
+        FORCEINLINE unsigned int getLastStateChangesCount() { return m_lastStateChanges; };
+        void begin();
+        void submit( Component* component, const sf::Shader* shader = 0, const sf::Texture* texture = 0 );
+        void submitPass( Component* component );
+        void sort();
+        void execute( sf::RenderTarget*& target, SpriteBatch* batch = 0 );
+        void end();
+
+    private:
+        struct Packet
+        {
+            sf::Uint64 key;
+            Component* component;
+        };
+
+        typedef std::map< const void*, unsigned int > StateIds;
+
+        static unsigned int stateId( StateIds& ids, const void* state, unsigned int bits );
+
+        std::vector< Packet > m_packets;
+        std::vector< Packet > m_sorted;
+        StateIds m_shaders;
+        StateIds m_textures;
+        /// union bounds of packets per rank in current pass; packets that overlap
+        /// nothing in a rank share it, so sorting by state keeps painter's order.
+        std::vector< sf::FloatRect > m_ranks;
+        unsigned int m_pass;
+        unsigned int m_stateChanges;
+        unsigned int m_lastPackets;
+        unsigned int m_lastStateChanges;
+    };
+
+}
+
+#endif
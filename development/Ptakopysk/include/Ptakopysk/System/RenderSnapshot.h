@@ -0,0 +1,66 @@
+#ifndef __PTAKOPYSK__RENDER_SNAPSHOT__
+#define __PTAKOPYSK__RENDER_SNAPSHOT__
+
+#include <XeCore/Common/Base.h>
+#include <XeCore/Common/IRtti.h>
+#include <XeCore/Common/MemoryManager.h>
+#include <SFML/Graphics.hpp>
+#include "RenderMaterial.h"
+#include <vector>
+
+namespace Ptakopysk
+{
+
+    class RenderSnapshot
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    {
+        RTTI_CLASS_DECLARE( RenderSnapshot );
+
+    public:
+        enum CommandType
+        {
+            ctQuads,
+            ctCamera
+        };
+
+        RenderSnapshot();
+        ~RenderSnapshot();
+
+        FORCEINLINE const sf::Color& getClearColor() { return m_clearColor; };
+        FORCEINLINE void setClearColor( const sf::Color& v ) { m_clearColor = v; };
+        FORCEINLINE unsigned int commandsCount() { return m_commands.size(); };
+        void clear();
+        void addShape( const sf::RectangleShape& shape, const sf::RenderStates& states, RenderMaterial* material = 0, bool materialValidation = false );
+        void addQuads( const sf::Vertex* vertices, unsigned int count, const sf::Color& color, const sf::RenderStates& states, RenderMaterial* material = 0, bool materialValidation = false );
+        void addCamera( sf::RenderTexture* renderTexture, const sf::View& view, bool applyViewToRenderTexture );
+        void render( sf::RenderTarget* target );
+
+    private:
+        struct Command
+        {
+            CommandType type;
+            unsigned int index;
+            unsigned int count;
+            sf::RenderStates states;
+            RenderMaterial* material;
+            bool materialValidation;
+            sf::RenderTexture* renderTexture;
+            bool applyView;
+        };
+
+        RenderMaterial* storeMaterial( RenderMaterial* material );
+        void pushQuads( unsigned int first, const sf::RenderStates& states, RenderMaterial* material, bool materialValidation );
+        void addRect( const sf::Transform& transform, float left, float top, float right, float bottom, const sf::Color& color );
+
+        sf::Color m_clearColor;
+        std::vector< Command > m_commands;
+        std::vector< sf::Vertex > m_vertices;
+        std::vector< sf::View > m_views;
+        std::vector< RenderMaterial* > m_materials;
+        unsigned int m_materialsUsed;
+    };
+
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef __PTAKOPYSK__SPATIAL_GRID__
+#define __PTAKOPYSK__SPATIAL_GRID__
+
+#include <XeCore/Common/Base.h>
+#include <XeCore/Common/IRtti.h>
+#include <XeCore/Common/MemoryManager.h>
+#include <SFML/Config.hpp>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/Graphics/View.hpp>
+#include <vector>
+#include <map>
+
+namespace Ptakopysk
+{
+
+    class SpatialGrid
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    {
+        RTTI_CLASS_DECLARE( SpatialGrid );
+        friend class GameManager;
+
+    public:
+        static const unsigned int MAX_PROXY_CELLS = 64;
+
+        SpatialGrid( float cellSize = 256.0f );
+        ~SpatialGrid();
+
+        FORCEINLINE static SpatialGrid* current() { return s_current; };
+        static sf::FloatRect viewBounds( const sf::View& view );
+
+        FORCEINLINE float getCellSize() { return m_cellSize; };
+        FORCEINLINE unsigned int proxiesCount() { return m_proxiesCount; };
+        FORCEINLINE unsigned int cellsCount() { return m_cells.size(); };
+        FORCEINLINE unsigned int getVisibleCount() { return m_visibleCount; };
+        FORCEINLINE bool isVisible( int proxy ) { return proxy >= 0 && proxy < (int)m_proxies.size() && m_proxies[ proxy ].stamp == m_stamp; };
+        FORCEINLINE void* getUserData( int proxy ) { return proxy >= 0 && proxy < (int)m_proxies.size() ? m_proxies[ proxy ].userData : 0; };
+        int createProxy( const sf::FloatRect& bounds, void* userData );
+        void moveProxy( int proxy, const sf::FloatRect& bounds );
+        void destroyProxy( int proxy );
+        unsigned int markVisible( const sf::FloatRect& rect );
+        unsigned int query( const sf::FloatRect& rect, std::vector< void* >& result );
+        unsigned int getAllUserData( std::vector< void* >& result );
+        void clear();
+
+    private:
+        struct Proxy
+        {
+            sf::FloatRect bounds;
+            int minX;
+            int minY;
+            int maxX;
+            int maxY;
+            void* userData;
+            unsigned int stamp;
+            unsigned int mark;
+            bool alive;
+            bool large;
+        };
+
+        typedef std::map< sf::Uint64, std::vector< int > > Cells;
+
+        FORCEINLINE static sf::Uint64 cellKey( int x, int y ) { return ( (sf::Uint64)(unsigned int)x << 32 ) | (sf::Uint64)(unsigned int)y; };
+        FORCEINLINE static int cellKeyX( sf::Uint64 key ) { return (int)(unsigned int)( key >> 32 ); };
+        FORCEINLINE static int cellKeyY( sf::Uint64 key ) { return (int)(unsigned int)( key & 0xFFFFFFFFu ); };
+        FORCEINLINE static bool overlaps( const sf::FloatRect& a, const sf::FloatRect& b ) { return a.left <= b.left + b.width && b.left <= a.left + a.width && a.top <= b.top + b.height && b.top <= a.top + a.height; };
+        void cellsRange( const sf::FloatRect& rect, int& minX, int& minY, int& maxX, int& maxY );
+        void insert( int proxy );
+        void remove( int proxy );
+        unsigned int visit( const sf::FloatRect& rect, unsigned int Proxy::* field, unsigned int value, std::vector< void* >* result );
+        unsigned int visitList( std::vector< int >& list, const sf::FloatRect& rect, unsigned int Proxy::* field, unsigned int value, std::vector< void* >* result );
+
+        static SpatialGrid* s_current;
+
+        float m_cellSize;
+        float m_cellSizeInv;
+        std::vector< Proxy > m_proxies;
+        std::vector< int > m_freeProxies;
+        std::vector< int > m_largeProxies;
+        Cells m_cells;
+        unsigned int m_proxiesCount;
+        unsigned int m_stamp;
+        unsigned int m_mark;
+        unsigned int m_visibleCount;
+    };
+
+}
+
+#endif
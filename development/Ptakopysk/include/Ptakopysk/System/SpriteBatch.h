@@ -0,0 +1,58 @@
+#ifndef __PTAKOPYSK__SPRITE_BATCH__
+#define __PTAKOPYSK__SPRITE_BATCH__
+
+#include <XeCore/Common/Base.h>
+#include <XeCore/Common/IRtti.h>
+#include <XeCore/Common/MemoryManager.h>
+#include <SFML/Graphics/VertexArray.hpp>
+#include <SFML/Graphics/RenderTarget.hpp>
+#include <SFML/Graphics/RenderStates.hpp>
+
+namespace Ptakopysk
+{
+
+    class RenderMaterial;
+
+    class SpriteBatch
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    {
+        RTTI_CLASS_DECLARE( SpriteBatch );
+        friend class GameManager;
+
+    public:
+        SpriteBatch();
+        ~SpriteBatch();
+
+        FORCEINLINE static SpriteBatch* current() { return s_current; };
+
+        FORCEINLINE unsigned int getDrawCallsCount() { return m_drawCalls; };
+        FORCEINLINE unsigned int getSpritesCount() { return m_sprites; };
+        FORCEINLINE unsigned int getLastDrawCallsCount() { return m_lastDrawCalls; };
+        FORCEINLINE unsigned int getLastSpritesCount() { return m_lastSprites; };
+        void begin();
+        void end();
+        void add( sf::RenderTarget* target, const sf::Vertex* quad, const sf::RenderStates& states, RenderMaterial* material = 0, bool materialValidation = false );
+        void add( sf::RenderTarget* target, const sf::Vertex* vertices, unsigned int count, const sf::Transform& transform, const sf::Color& color, const sf::RenderStates& states, RenderMaterial* material = 0, bool materialValidation = false );
+        void flush();
+        static bool isSameMaterial( RenderMaterial* a, RenderMaterial* b );
+
+    private:
+        void prepare( sf::RenderTarget* target, const sf::RenderStates& states, RenderMaterial* material, bool materialValidation );
+
+        static SpriteBatch* s_current;
+
+        sf::VertexArray m_vertices;
+        sf::RenderTarget* m_target;
+        sf::RenderStates m_states;
+        RenderMaterial* m_material;
+        bool m_materialValidation;
+        unsigned int m_drawCalls;
+        unsigned int m_sprites;
+        unsigned int m_lastDrawCalls;
+        unsigned int m_lastSprites;
+    };
+
+}
+
+#endif
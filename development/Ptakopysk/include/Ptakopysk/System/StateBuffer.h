@@ -0,0 +1,57 @@
+#ifndef __PTAKOPYSK__STATE_BUFFER__
+#define __PTAKOPYSK__STATE_BUFFER__
+
+#include <XeCore/Common/Base.h>
+#include <XeCore/Common/IRtti.h>
+#include <XeCore/Common/MemoryManager.h>
+#include <vector>
+#include <string>
+
+namespace Ptakopysk
+{
+
+    class StateBuffer
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    {
+        RTTI_CLASS_DECLARE( StateBuffer );
+
+    public:
+        typedef std::vector< unsigned char > Data;
+
+        StateBuffer();
+        StateBuffer( const void* data, unsigned int size );
+        ~StateBuffer();
+
+        FORCEINLINE const Data& getData() { return m_data; };
+        FORCEINLINE Data& accessData() { return m_data; };
+        FORCEINLINE unsigned int size() { return m_data.size(); };
+        FORCEINLINE unsigned int getPosition() { return m_position; };
+        FORCEINLINE void setPosition( unsigned int v ) { m_position = v < m_data.size() ? v : m_data.size(); };
+        FORCEINLINE bool isEof() { return m_position >= m_data.size(); };
+        FORCEINLINE bool isValid() { return m_valid; };
+        FORCEINLINE void rewind() { m_position = 0; m_valid = true; };
+        void clear();
+        void assign( const void* data, unsigned int size );
+
+        void writeBytes( const void* data, unsigned int size );
+        bool readBytes( void* data, unsigned int size );
+        bool skip( unsigned int size );
+        unsigned int beginBlock();
+        void endBlock( unsigned int block );
+        template< typename T >
+        FORCEINLINE void write( const T& v ) { writeBytes( &v, sizeof( T ) ); };
+        FORCEINLINE void write( const std::string& v ) { write( (unsigned int)v.size() ); writeBytes( v.c_str(), v.size() ); };
+        template< typename T >
+        FORCEINLINE bool read( T& v ) { return readBytes( &v, sizeof( T ) ); };
+        bool read( std::string& v );
+
+    private:
+        Data m_data;
+        unsigned int m_position;
+        bool m_valid;
+    };
+
+}
+
+#endif
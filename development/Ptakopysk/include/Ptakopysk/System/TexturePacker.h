@@ -0,0 +1,76 @@
+#ifndef __PTAKOPYSK__TEXTURE_PACKER__
+#define __PTAKOPYSK__TEXTURE_PACKER__
+
+#include <XeCore/Common/Base.h>
+#include <XeCore/Common/IRtti.h>
+#include <XeCore/Common/MemoryManager.h>
+#include <SFML/Graphics/Rect.hpp>
+#include <SFML/System/Vector2.hpp>
+#include <vector>
+
+namespace Ptakopysk
+{
+
+    class TexturePacker
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    {
+        RTTI_CLASS_DECLARE( TexturePacker );
+
+    public:
+        static const unsigned int DEFAULT_PAGE_SIZE = 2048;
+
+        TexturePacker( unsigned int pageWidth = DEFAULT_PAGE_SIZE, unsigned int pageHeight = DEFAULT_PAGE_SIZE, unsigned int padding = 0 );
+        ~TexturePacker();
+
+        FORCEINLINE unsigned int itemsCount() { return m_items.size(); };
+        FORCEINLINE unsigned int pagesCount() { return m_pages.size(); };
+        sf::Vector2u getPageSize( unsigned int page );
+        unsigned int add( const sf::Vector2u& size );
+        bool pack();
+        bool getItem( unsigned int index, unsigned int& outPage, sf::IntRect& outRect );
+        void clear();
+
+    private:
+        struct Item
+        {
+            sf::Vector2u size;
+            sf::IntRect rect;
+            unsigned int page;
+            bool packed;
+        };
+
+        struct Node
+        {
+            int x;
+            int y;
+            int width;
+        };
+
+        struct Page
+        {
+            std::vector< Node > skyline;
+            sf::Vector2u used;
+        };
+
+        struct CompareItems
+        {
+            CompareItems( std::vector< Item >& items ) : m_items( items ) {};
+            bool operator() ( unsigned int a, unsigned int b );
+            std::vector< Item >& m_items;
+        };
+
+        bool fit( Page& page, unsigned int node, int width, int height, int& outY );
+        bool findPosition( Page& page, int width, int height, unsigned int& outNode, int& outY );
+        void place( Page& page, unsigned int node, int width, int height, int y );
+
+        unsigned int m_pageWidth;
+        unsigned int m_pageHeight;
+        unsigned int m_padding;
+        std::vector< Item > m_items;
+        std::vector< Page > m_pages;
+    };
+
+}
+
+#endif
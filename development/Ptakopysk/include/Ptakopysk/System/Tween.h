@@ -7,6 +7,7 @@
 #include <XeCore/Common/Singleton.h>
 #include <XeCore/Common/Property.h>
 #include "Math.h"
+#include "StateBuffer.h"
 #include <list>
 #include <vector>
 
@@ -17,7 +18,7 @@ namespace Ptakopysk
     {
         friend class Tweener;
     public:
-        ITween() {};
+        ITween() : m_tweenId( 0 ) {};
         virtual ~ITween() {};
 
         virtual int getState() = 0;
@@ -31,6 +32,11 @@ namespace Ptakopysk
         virtual void onStop() = 0;
         virtual void onUpdate( float dt ) = 0;
         virtual dword getPropertyID() = 0;
+        virtual void onSaveState( StateBuffer& state ) {};
+        virtual void onLoadState( StateBuffer& state ) {};
+
+    private:
+        dword m_tweenId;
     };
 
     template< typename PT, typename OT, PT(*EF)(float,PT,PT,float) >
@@ -52,6 +58,8 @@ namespace Ptakopysk
         FORCEINLINE virtual void onStop();
         FORCEINLINE virtual void onUpdate( float dt );
         FORCEINLINE virtual dword getPropertyID();
+        FORCEINLINE virtual void onSaveState( StateBuffer& state );
+        FORCEINLINE virtual void onLoadState( StateBuffer& state );
 
     private:
         XeCore::Common::Property< PT, OT >& m_property;
@@ -82,6 +90,8 @@ namespace Ptakopysk
         virtual void onStop();
         virtual void onUpdate( float dt );
         virtual dword getPropertyID();
+        virtual void onSaveState( StateBuffer& state );
+        virtual void onLoadState( StateBuffer& state );
 
     private:
         std::vector< ITween* > m_tweens;
@@ -110,6 +120,8 @@ namespace Ptakopysk
         virtual void onStop();
         virtual void onUpdate( float dt );
         virtual dword getPropertyID();
+        virtual void onSaveState( StateBuffer& state );
+        virtual void onLoadState( StateBuffer& state );
 
     private:
         std::vector< ITween* > m_tweens;
@@ -139,9 +151,15 @@ namespace Ptakopysk
         ITween* getTween( dword id );
 
         void processTweens( float dt );
+        void saveState( StateBuffer& state );
+        bool loadState( StateBuffer& state );
+        bool skipState( StateBuffer& state );
 
     private:
+        std::list< ITween* >::iterator findTween( dword id );
+
         std::list< ITween* > m_tweens;
+        dword m_nextTweenId;
     };
 
 }
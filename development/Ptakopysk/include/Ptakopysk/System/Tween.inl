@@ -73,6 +73,24 @@ namespace Ptakopysk
         return (dword)&m_property;
     }
 
+    template< typename PT, typename OT, PT(*EF)(float,PT,PT,float) >
+    void Tween< PT, OT, EF >::onSaveState( StateBuffer& state )
+    {
+        state.write( m_from );
+        state.write( m_time );
+        state.write( m_state );
+        state.write( m_tweening );
+    }
+
+    template< typename PT, typename OT, PT(*EF)(float,PT,PT,float) >
+    void Tween< PT, OT, EF >::onLoadState( StateBuffer& state )
+    {
+        state.read( m_from );
+        state.read( m_time );
+        state.read( m_state );
+        state.read( m_tweening );
+    }
+
     template< typename PT, typename OT >
     void Tweener::killTweensOf( const XeCore::Common::Property< PT, OT >& p )
     {
@@ -4,6 +4,7 @@
 #include "../../include/Ptakopysk/Components/TextRenderer.h"
 #include "../../include/Ptakopysk/System/GameObject.h"
 #include "../../include/Ptakopysk/System/GameManager.h"
+#include "../../include/Ptakopysk/System/StateBuffer.h"
 #include <XeCore/Common/Logger.h>
 
 namespace Ptakopysk
@@ -206,6 +207,8 @@ namespace Ptakopysk
         m_fixtureDef.shape = m_shape;
         m_fixture = m_body->CreateFixture( &m_fixtureDef );
         m_fixture->SetUserData( getGameObject() );
+        if( trans )
+            trans->updateInterpolationTracking();
     }
 
     void Body::onDestroy()
@@ -384,4 +387,42 @@ namespace Ptakopysk
         return false;
     }
 
+    void Body::onSaveState( StateBuffer& state )
+    {
+        state.write( getPosition() );
+        state.write( getAngle() );
+        state.write( getLinearVelocity() );
+        state.write( getAngularVelocity() );
+        state.write( m_body ? m_body->IsAwake() : m_bodyDef.awake );
+    }
+
+    void Body::onLoadState( StateBuffer& state )
+    {
+        b2Vec2 position = getPosition();
+        float angle = getAngle();
+        b2Vec2 linearVelocity = getLinearVelocity();
+        float angularVelocity = getAngularVelocity();
+        bool awake = m_body ? m_body->IsAwake() : m_bodyDef.awake;
+        state.read( position );
+        state.read( angle );
+        state.read( linearVelocity );
+        state.read( angularVelocity );
+        state.read( awake );
+        if( m_body )
+        {
+            m_body->SetTransform( position, angle );
+            m_body->SetLinearVelocity( linearVelocity );
+            m_body->SetAngularVelocity( angularVelocity );
+            m_body->SetAwake( awake );
+        }
+        else
+        {
+            m_bodyDef.position = position;
+            m_bodyDef.angle = angle;
+            m_bodyDef.linearVelocity = linearVelocity;
+            m_bodyDef.angularVelocity = angularVelocity;
+            m_bodyDef.awake = awake;
+        }
+    }
+
 }
@@ -2,6 +2,9 @@
 #include "../../include/Ptakopysk/Components/Transform.h"
 #include "../../include/Ptakopysk/System/GameObject.h"
 #include "../../include/Ptakopysk/System/GameManager.h"
+#include "../../include/Ptakopysk/System/RenderSnapshot.h"
+#include "../../include/Ptakopysk/System/RenderQueue.h"
+#include "../../include/Ptakopysk/System/SpatialGrid.h"
 #include <SFML/Graphics/RenderWindow.hpp>
 #include <SFML/Graphics/RectangleShape.hpp>
 #include <SFML/Graphics/Color.hpp>
@@ -55,8 +58,22 @@ namespace Ptakopysk
     Camera::~Camera()
     {
         DELETE_OBJECT( m_view );
-        if( m_renderTextureMine )
+        if( m_renderTextureMine && m_renderTexture )
+        {
+            GameManager::waitForAllRenders();
             DELETE_OBJECT( m_renderTexture );
+        }
+    }
+
+    void Camera::setTargetTexture( sf::RenderTexture* v )
+    {
+        if( m_renderTexture != v && m_renderTextureMine )
+        {
+            m_renderTextureMine = false;
+            GameManager::waitForAllRenders();
+            DELETE_OBJECT( m_renderTexture );
+        }
+        m_renderTexture = v;
     }
 
     void Camera::setSize( sf::Vector2f v )
@@ -247,6 +264,22 @@ namespace Ptakopysk
             target = s_mainRT;
             target->setView( *m_view );
         }
+        if( SpatialGrid::current() )
+            SpatialGrid::current()->markVisible( SpatialGrid::viewBounds( target->getView() ) );
+    }
+
+    void Camera::onRenderSnapshot( RenderSnapshot& snapshot )
+    {
+        snapshot.addCamera( m_renderTexture, *m_view, m_applyViewToRT );
+        if( SpatialGrid::current() )
+            SpatialGrid::current()->markVisible( SpatialGrid::viewBounds( m_renderTexture && !m_applyViewToRT ? m_renderTexture->getView() : *m_view ) );
+    }
+
+    void Camera::onRenderQueue( RenderQueue& queue )
+    {
+        queue.submitPass( this );
+        if( SpatialGrid::current() )
+            SpatialGrid::current()->markVisible( SpatialGrid::viewBounds( m_renderTexture && !m_applyViewToRT ? m_renderTexture->getView() : *m_view ) );
     }
 
     void Camera::onRenderEditor( sf::RenderTarget* target )
@@ -277,7 +310,7 @@ namespace Ptakopysk
 
     void Camera::createRenderTexture()
     {
-        if( !m_isReady || m_generateRenderTextureMode == grtNone || GameManager::isEditMode() || !getGameObject() || getGameObject()->isPrefab() )
+        if( !m_isReady || m_generateRenderTextureMode == grtNone || GameManager::isEditMode() || !getGameObject() || getGameObject()->isPrefab() || Assets::use().isHeadless() )
             return;
         sf::RenderTexture* rt = xnew sf::RenderTexture();
         unsigned int w = m_renderTextureMineSize.x;
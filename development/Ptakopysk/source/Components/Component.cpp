@@ -1,6 +1,8 @@
 #include "../../include/Ptakopysk/Components/Component.h"
 #include "../../include/Ptakopysk/System/GameObject.h"
 #include "../../include/Ptakopysk/System/GameManager.h"
+#include "../../include/Ptakopysk/System/SpatialGrid.h"
+#include "../../include/Ptakopysk/System/RenderQueue.h"
 
 namespace Ptakopysk
 {
@@ -18,16 +20,29 @@ namespace Ptakopysk
     , m_typeFlags( typeFlags )
     , m_active( true )
     , m_gameObject( 0 )
+    , m_poolIndex( 0 )
+    , m_cullingGrid( 0 )
+    , m_cullingProxy( -1 )
     {
         serializableProperty( "Active" );
     }
 
     Component::~Component()
     {
+        releaseCulling();
         if( m_gameObject )
             m_gameObject->removeComponent( this );
     }
 
+    void Component::setActive( bool mode )
+    {
+        if( m_active == mode )
+            return;
+        m_active = mode;
+        if( m_gameObject && m_typeFlags & tTransform )
+            m_gameObject->invalidateTransform();
+    }
+
     void Component::fromJson( const Json::Value& root )
     {
         if( !root.isObject() )
@@ -63,7 +78,7 @@ namespace Ptakopysk
     void Component::onDeserialize( const std::string& property, const Json::Value& root )
     {
         if( property == "Active" && root.isBool() )
-            m_active = root.asBool();
+            setActive( root.asBool() );
     }
 
     void Component::onDuplicate( Component* dst )
@@ -73,11 +88,54 @@ namespace Ptakopysk
         dst->setActive( m_active );
     }
 
+    void Component::onRenderQueue( RenderQueue& queue )
+    {
+        queue.submit( this );
+    }
+
+    bool Component::recycle()
+    {
+        if( m_gameObject || !onRecycle() )
+            return false;
+        m_active = true;
+        m_poolIndex = 0;
+        return true;
+    }
+
     void Component::setGameObject( GameObject* gameObject )
     {
+        if( !gameObject )
+            releaseCulling();
         m_gameObject = gameObject;
     }
 
+    void Component::updateCulling()
+    {
+        sf::FloatRect bounds;
+        if( !m_cullingGrid )
+        {
+            GameManager* gm = m_gameObject ? m_gameObject->getGameManagerRoot() : 0;
+            SpatialGrid* grid = gm ? gm->getSpatialGrid() : 0;
+            if( grid && onCullingBounds( bounds ) )
+            {
+                m_cullingGrid = grid;
+                m_cullingProxy = grid->createProxy( bounds, this );
+            }
+        }
+        else if( onCullingBounds( bounds ) )
+            m_cullingGrid->moveProxy( m_cullingProxy, bounds );
+        else
+            releaseCulling();
+    }
+
+    void Component::releaseCulling()
+    {
+        if( m_cullingGrid )
+            m_cullingGrid->destroyProxy( m_cullingProxy );
+        m_cullingGrid = 0;
+        m_cullingProxy = -1;
+    }
+
     Component::Type operator|( Component::Type a, Component::Type b )
     {
         return (Component::Type)( (int)a | (int)b );
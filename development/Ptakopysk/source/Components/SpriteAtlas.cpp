@@ -1,6 +1,7 @@
 #include "../../include/Ptakopysk/Components/SpriteAtlas.h"
 #include "../../include/Ptakopysk/System/GameObject.h"
 #include "../../include/Ptakopysk/Components/SpriteRenderer.h"
+#include "../../include/Ptakopysk/System/StateBuffer.h"
 
 namespace Ptakopysk
 {
@@ -46,7 +47,7 @@ namespace Ptakopysk
         else
         {
             sf::Vector2f op = spr->getOriginPercent();
-            spr->getRenderer()->setTexture( spr->getRenderer()->getTexture(), true );
+            spr->setTexture( spr->getTexture() );
             spr->setSize( sf::Vector2f( -1.0f, -1.0f ) );
             spr->setOriginPercent( op );
         }
@@ -101,4 +102,16 @@ namespace Ptakopysk
             return false;
     }
 
+    void SpriteAtlas::onSaveState( StateBuffer& state )
+    {
+        state.write( m_subTexture );
+    }
+
+    void SpriteAtlas::onLoadState( StateBuffer& state )
+    {
+        std::string subTexture;
+        if( state.read( subTexture ) && subTexture != m_subTexture )
+            setSubTextureName( subTexture );
+    }
+
 }
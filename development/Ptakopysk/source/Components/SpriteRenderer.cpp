@@ -3,6 +3,10 @@
 #include "../../include/Ptakopysk/System/GameManager.h"
 #include "../../include/Ptakopysk/System/GameObject.h"
 #include "../../include/Ptakopysk/System/Assets.h"
+#include "../../include/Ptakopysk/System/RenderSnapshot.h"
+#include "../../include/Ptakopysk/System/RenderQueue.h"
+#include "../../include/Ptakopysk/System/SpriteBatch.h"
+#include "../../include/Ptakopysk/System/StateBuffer.h"
 
 namespace Ptakopysk
 {
@@ -23,6 +27,7 @@ namespace Ptakopysk
     , RenderStates( this, &SpriteRenderer::getRenderStates, &SpriteRenderer::setRenderStates )
     , Material( this, &SpriteRenderer::getMaterial, &SpriteRenderer::setMaterial )
     , MaterialValidation( this, &SpriteRenderer::getMaterialValidation, &SpriteRenderer::setMaterialValidation )
+    , m_sourceTexture( 0 )
     , m_renderStates( sf::RenderStates::Default )
     , m_materialValidation( false )
     {
@@ -45,6 +50,8 @@ namespace Ptakopysk
 
     sf::Texture* SpriteRenderer::getTexture()
     {
+        if( m_sourceTexture )
+            return m_sourceTexture;
         sf::Texture* t = (sf::Texture*)m_shape->getTexture();
         return t == Assets::use().getDefaultTexture() ? 0 : t;
     }
@@ -52,12 +59,22 @@ namespace Ptakopysk
     void SpriteRenderer::setTexture( sf::Texture* tex )
     {
         sf::Texture* t = tex ? tex : Assets::use().getDefaultTexture();
-        m_shape->setTexture( t );
-        if( t )
+        sf::Texture* page = 0;
+        sf::IntRect rect;
+        m_sourceTexture = 0;
+        if( tex && Assets::use().findTextureRegion( tex, page, rect ) )
+        {
+            m_sourceTexture = tex;
+            t = page;
+        }
+        else if( t )
         {
             sf::Vector2u s = t->getSize();
-            m_shape->setTextureRect( sf::IntRect( 0, 0, s.x, s.y ) );
+            rect = sf::IntRect( 0, 0, s.x, s.y );
         }
+        m_shape->setTexture( t );
+        if( t )
+            m_shape->setTextureRect( rect );
     }
 
     sf::Vector2f SpriteRenderer::getSize()
@@ -74,6 +91,7 @@ namespace Ptakopysk
         if( size.y < 0.0f )
             size.y = t ? t->getSize().y : 0.0f;
         m_shape->setSize( size );
+        invalidateCullingBounds();
     }
 
     sf::Vector2f SpriteRenderer::getOriginPercent()
@@ -223,6 +241,45 @@ namespace Ptakopysk
         target->draw( *m_shape, m_renderStates );
     }
 
+    bool SpriteRenderer::onCullingBounds( sf::FloatRect& result )
+    {
+        result = m_renderStates.transform.transformRect( m_shape->getGlobalBounds() );
+        return true;
+    }
+
+    void SpriteRenderer::onRenderSnapshot( RenderSnapshot& snapshot )
+    {
+        snapshot.addShape( *m_shape, m_renderStates, &m_material, m_materialValidation );
+    }
+
+    void SpriteRenderer::onRenderQueue( RenderQueue& queue )
+    {
+        queue.submit( this, m_renderStates.shader, m_shape->getTexture() );
+    }
+
+    bool SpriteRenderer::onRenderBatch( SpriteBatch& batch, sf::RenderTarget* target )
+    {
+        if( m_shape->getOutlineThickness() != 0.0f )
+            return false;
+        sf::Transform t = m_renderStates.transform * m_shape->getTransform();
+        sf::Vector2f s = m_shape->getSize();
+        sf::IntRect r = m_shape->getTextureRect();
+        sf::Color c = m_shape->getFillColor();
+        float left = (float)r.left;
+        float top = (float)r.top;
+        float right = left + (float)r.width;
+        float bottom = top + (float)r.height;
+        sf::Vertex quad[ 4 ] = {
+            sf::Vertex( t.transformPoint( 0.0f, 0.0f ), c, sf::Vector2f( left, top ) ),
+            sf::Vertex( t.transformPoint( s.x, 0.0f ), c, sf::Vector2f( right, top ) ),
+            sf::Vertex( t.transformPoint( s.x, s.y ), c, sf::Vector2f( right, bottom ) ),
+            sf::Vertex( t.transformPoint( 0.0f, s.y ), c, sf::Vector2f( left, bottom ) )
+        };
+        sf::RenderStates states( m_renderStates.blendMode, sf::Transform::Identity, m_shape->getTexture(), m_renderStates.shader );
+        batch.add( target, quad, states, &m_material, m_materialValidation );
+        return true;
+    }
+
     void SpriteRenderer::onRenderEditor( sf::RenderTarget* target )
     {
         const sf::Shader* s = m_renderStates.shader;
@@ -233,8 +290,15 @@ namespace Ptakopysk
 
     void SpriteRenderer::onTextureChanged( const sf::Texture* a, bool addedOrRemoved )
     {
-        if( m_shape && m_shape->getTexture() == a )
+        if( !m_shape )
+            return;
+        if( m_sourceTexture && m_sourceTexture != a && m_shape->getTexture() == a )
+            setTexture( m_sourceTexture );
+        else if( m_shape->getTexture() == a || m_sourceTexture == a )
+        {
             m_shape->setTexture( 0 );
+            m_sourceTexture = 0;
+        }
     }
 
     void SpriteRenderer::onShaderChanged( const sf::Shader* a, bool addedOrRemoved )
@@ -259,4 +323,31 @@ namespace Ptakopysk
         return m_shape->getGlobalBounds().contains( p );
     }
 
+    bool SpriteRenderer::onRecycle()
+    {
+        *m_shape = sf::RectangleShape();
+        setTexture( 0 );
+        m_size = sf::Vector2f( 0.0f, 0.0f );
+        m_renderStates = sf::RenderStates::Default;
+        m_material.clear();
+        m_materialValidation = false;
+        return true;
+    }
+
+    void SpriteRenderer::onSaveState( StateBuffer& state )
+    {
+        state.write( m_shape->getFillColor() );
+        state.write( m_shape->getTextureRect() );
+    }
+
+    void SpriteRenderer::onLoadState( StateBuffer& state )
+    {
+        sf::Color color = m_shape->getFillColor();
+        sf::IntRect rect = m_shape->getTextureRect();
+        state.read( color );
+        state.read( rect );
+        m_shape->setFillColor( color );
+        m_shape->setTextureRect( rect );
+    }
+
 }
@@ -1,7 +1,12 @@
 #include "../../include/Ptakopysk/Components/TextRenderer.h"
 #include "../../include/Ptakopysk/Components/Transform.h"
 #include "../../include/Ptakopysk/System/GameObject.h"
+#include "../../include/Ptakopysk/System/GameManager.h"
 #include "../../include/Ptakopysk/System/Assets.h"
+#include "../../include/Ptakopysk/System/RenderSnapshot.h"
+#include "../../include/Ptakopysk/System/RenderQueue.h"
+#include "../../include/Ptakopysk/System/SpriteBatch.h"
+#include "../../include/Ptakopysk/System/StateBuffer.h"
 
 namespace Ptakopysk
 {
@@ -24,6 +29,9 @@ namespace Ptakopysk
     , RenderStates( this, &TextRenderer::getRenderStates, &TextRenderer::setRenderStates )
     , Material( this, &TextRenderer::getMaterial, &TextRenderer::setMaterial )
     , MaterialValidation( this, &TextRenderer::getMaterialValidation, &TextRenderer::setMaterialValidation )
+    , m_textDirty( false )
+    , m_run( 0 )
+    , m_runRevision( 0 )
     , m_renderStates( sf::RenderStates::Default )
     , m_materialValidation( false )
     {
@@ -45,6 +53,57 @@ namespace Ptakopysk
         DELETE_OBJECT( m_text );
     }
 
+    void TextRenderer::setText( sf::String v )
+    {
+        if( v == getText() )
+            return;
+        m_string = v;
+        if( !m_textDirty )
+        {
+            m_textDirty = true;
+            m_text->setString( sf::String() );
+        }
+        m_run = 0;
+        invalidateCullingBounds();
+    }
+
+    void TextRenderer::setFont( sf::Font* v )
+    {
+        if( v )
+        {
+            tthread::lock_guard< tthread::mutex > guard( GlyphRunCache::fontsMutex() );
+            m_text->setFont( *v );
+        }
+        m_run = 0;
+        invalidateCullingBounds();
+    }
+
+    void TextRenderer::setSize( dword v )
+    {
+        {
+            tthread::lock_guard< tthread::mutex > guard( GlyphRunCache::fontsMutex() );
+            m_text->setCharacterSize( v );
+        }
+        m_run = 0;
+        invalidateCullingBounds();
+    }
+
+    void TextRenderer::setStyle( dword v )
+    {
+        {
+            tthread::lock_guard< tthread::mutex > guard( GlyphRunCache::fontsMutex() );
+            m_text->setStyle( v );
+        }
+        m_run = 0;
+        invalidateCullingBounds();
+    }
+
+    sf::FloatRect TextRenderer::measureText()
+    {
+        GlyphRunCache::Run* run = glyphRun();
+        return run ? run->bounds : sf::FloatRect();
+    }
+
     sf::Vector2f TextRenderer::getOriginPercent()
     {
         sf::Vector2f o = getOrigin();
@@ -203,13 +262,49 @@ namespace Ptakopysk
 
     void TextRenderer::onRender( sf::RenderTarget*& target )
     {
+        syncText();
         if( m_renderStates.shader )
             m_material.apply( (sf::Shader*)m_renderStates.shader );
         target->draw( *m_text, m_renderStates );
     }
 
+    bool TextRenderer::onCullingBounds( sf::FloatRect& result )
+    {
+        result = m_renderStates.transform.transformRect( m_text->getTransform().transformRect( measureText() ) );
+        return true;
+    }
+
+    void TextRenderer::onRenderSnapshot( RenderSnapshot& snapshot )
+    {
+        GlyphRunCache::Run* run = glyphRun();
+        if( !run || !run->texture || run->vertices.empty() )
+            return;
+        sf::RenderStates states( m_renderStates.blendMode, m_renderStates.transform * m_text->getTransform(), run->texture, m_renderStates.shader );
+        snapshot.addQuads( &run->vertices[ 0 ], run->vertices.size(), m_text->getColor(), states, &m_material, m_materialValidation );
+    }
+
+    void TextRenderer::onRenderQueue( RenderQueue& queue )
+    {
+        const sf::Font* font = m_text->getFont();
+        queue.submit( this, m_renderStates.shader, font ? &font->getTexture( m_text->getCharacterSize() ) : 0 );
+    }
+
+    bool TextRenderer::onRenderBatch( SpriteBatch& batch, sf::RenderTarget* target )
+    {
+        GlyphRunCache::Run* run = glyphRun();
+        if( !run || !run->texture )
+            return false;
+        if( !run->vertices.empty() )
+        {
+            sf::RenderStates states( m_renderStates.blendMode, sf::Transform::Identity, run->texture, m_renderStates.shader );
+            batch.add( target, &run->vertices[ 0 ], run->vertices.size(), m_renderStates.transform * m_text->getTransform(), m_text->getColor(), states, &m_material, m_materialValidation );
+        }
+        return true;
+    }
+
     void TextRenderer::onRenderEditor( sf::RenderTarget* target )
     {
+        syncText();
         const sf::Shader* s = m_renderStates.shader;
         m_renderStates.shader = 0;
         target->draw( *m_text, m_renderStates );
@@ -225,7 +320,11 @@ namespace Ptakopysk
     void TextRenderer::onFontChanged( const sf::Font* a, bool addedOrRemoved )
     {
         if( m_text && m_text->getFont() == a )
+        {
+            tthread::lock_guard< tthread::mutex > guard( GlyphRunCache::fontsMutex() );
             m_text->setFont( *a );
+            m_run = 0;
+        }
     }
 
     bool TextRenderer::onTriggerFunctionality( const std::string& name )
@@ -241,7 +340,7 @@ namespace Ptakopysk
     bool TextRenderer::onCheckContainsPoint( const sf::Vector2f& worldPos )
     {
         sf::Vector2f p = m_renderStates.transform.getInverse().transformPoint( worldPos );
-        return m_text->getGlobalBounds().contains( p );
+        return m_text->getTransform().transformRect( measureText() ).contains( p );
     }
 
     std::string TextRenderer::escapedString( std::string v )
@@ -298,4 +397,52 @@ namespace Ptakopysk
         return ss.str();
     }
 
+    void TextRenderer::syncText()
+    {
+        if( !m_textDirty )
+            return;
+        m_textDirty = false;
+        tthread::lock_guard< tthread::mutex > guard( GlyphRunCache::fontsMutex() );
+        m_text->setString( m_string );
+        m_string.clear();
+    }
+
+    GlyphRunCache::Run* TextRenderer::glyphRun()
+    {
+        GameManager* gm = getGameObject() ? getGameObject()->getGameManagerRoot() : 0;
+        GlyphRunCache& cache = gm ? *gm->getGlyphRunCache() : GlyphRunCache::use();
+        if( m_run && m_runRevision == cache.getRevision() )
+        {
+            cache.touch( m_run );
+            return m_run;
+        }
+        m_run = cache.acquire( getText(), m_text->getFont(), m_text->getCharacterSize(), m_text->getStyle() );
+        m_runRevision = cache.getRevision();
+        return m_run;
+    }
+
+    void TextRenderer::onSaveState( StateBuffer& state )
+    {
+        sf::String text = getText();
+        state.write( (unsigned int)text.getSize() );
+        state.writeBytes( text.getData(), text.getSize() * sizeof( sf::Uint32 ) );
+        state.write( m_text->getColor() );
+    }
+
+    void TextRenderer::onLoadState( StateBuffer& state )
+    {
+        unsigned int size = 0;
+        sf::Color color = m_text->getColor();
+        if( !state.read( size ) || size > ( state.size() - state.getPosition() ) / sizeof( sf::Uint32 ) )
+            return;
+        std::basic_string< sf::Uint32 > text( size, 0 );
+        if( size )
+            state.readBytes( &text[ 0 ], size * sizeof( sf::Uint32 ) );
+        state.read( color );
+        if( !state.isValid() )
+            return;
+        setText( sf::String( text ) );
+        m_text->setColor( color );
+    }
+
 }
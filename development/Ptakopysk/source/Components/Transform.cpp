@@ -1,5 +1,9 @@
 #include "../../include/Ptakopysk/Components/Transform.h"
+#include "../../include/Ptakopysk/Components/Body.h"
 #include "../../include/Ptakopysk/System/GameObject.h"
+#include "../../include/Ptakopysk/System/GameManager.h"
+#include "../../include/Ptakopysk/System/StateBuffer.h"
+#include <cmath>
 
 namespace Ptakopysk
 {
@@ -9,6 +13,8 @@ namespace Ptakopysk
                             RTTI_DERIVATIONS_END
                             )
 
+    float Transform::s_interpolationAlpha = 1.0f;
+
     Transform::Transform()
     : RTTI_CLASS_DEFINE( Transform )
     , Component( Component::tTransform )
@@ -16,19 +22,37 @@ namespace Ptakopysk
     , Rotation( this, &Transform::getRotation, &Transform::setRotation )
     , Scale( this, &Transform::getScale, &Transform::setScale )
     , Mode( this, &Transform::getMode, &Transform::setMode )
+    , Interpolated( this, &Transform::isInterpolated, &Transform::setInterpolated )
     , m_position( sf::Vector2f( 0.0f, 0.0f ) )
     , m_rotation( 0.0f )
     , m_scale( sf::Vector2f( 1.0f, 1.0f ) )
     , m_mode( mHierarchy )
+    , m_prevPosition( sf::Vector2f( 0.0f, 0.0f ) )
+    , m_prevRotation( 0.0f )
+    , m_prevScale( sf::Vector2f( 1.0f, 1.0f ) )
+    , m_interpolationStored( false )
+    , m_interpolated( false )
+    , m_interpolationOwner( 0 )
+    , m_interpolationIndex( 0 )
     {
         serializableProperty( "Position" );
         serializableProperty( "Rotation" );
         serializableProperty( "Scale" );
         serializableProperty( "Mode" );
+        serializableProperty( "Interpolated" );
     }
 
     Transform::~Transform()
     {
+        if( m_interpolationOwner )
+            m_interpolationOwner->unregisterInterpolatedTransform( this );
+    }
+
+    void Transform::setInterpolated( bool mode )
+    {
+        m_interpolated = mode;
+        if( m_interpolationOwner || ( mode && getGameObject() && getGameObject()->getGameManagerRoot() ) )
+            updateInterpolationTracking();
     }
 
     void Transform::recomputeTransform()
@@ -46,6 +70,30 @@ namespace Ptakopysk
         onTransform( t, t );
     }
 
+    void Transform::invalidate()
+    {
+        if( getGameObject() )
+            getGameObject()->invalidateTransform();
+    }
+
+    void Transform::storeInterpolationState()
+    {
+        m_prevPosition = m_position;
+        m_prevRotation = m_rotation;
+        m_prevScale = m_scale;
+        m_interpolationStored = true;
+    }
+
+    void Transform::updateInterpolationTracking()
+    {
+        GameObject* go = getGameObject();
+        GameManager* gm = go && !go->isPrefab() ? go->getGameManagerRoot() : 0;
+        if( gm && ( m_interpolated || go->hasComponent< Body >() ) )
+            gm->registerInterpolatedTransform( this );
+        else if( m_interpolationOwner )
+            m_interpolationOwner->unregisterInterpolatedTransform( this );
+    }
+
     Json::Value Transform::onSerialize( const std::string& property )
     {
         if( property == "Position" )
@@ -66,6 +114,8 @@ namespace Ptakopysk
         }
         else if( property == "Mode" )
             return Serialized::serializeCustom< ModeType >( "Transform::ModeType", m_mode );
+        else if( property == "Interpolated" )
+            return Json::Value( m_interpolated );
         else
             return Component::onSerialize( property );
     }
@@ -90,8 +140,18 @@ namespace Ptakopysk
         }
         else if( property == "Mode" && root.isString() )
             m_mode = Serialized::deserializeCustom< ModeType >( "Transform::ModeType", root );
+        else if( property == "Interpolated" && root.isBool() )
+        {
+            setInterpolated( root.asBool() );
+            return;
+        }
         else
+        {
             Component::onDeserialize( property, root );
+            return;
+        }
+        m_interpolationStored = false;
+        invalidate();
     }
 
     void Transform::onDuplicate( Component* dst )
@@ -106,29 +166,92 @@ namespace Ptakopysk
         c->setRotation( getRotation() );
         c->setScale( getScale() );
         c->setMode( getMode() );
+        c->setInterpolated( isInterpolated() );
+    }
+
+    void Transform::onCreate()
+    {
+        updateInterpolationTracking();
+    }
+
+    void Transform::onDestroy()
+    {
+        if( m_interpolationOwner )
+            m_interpolationOwner->unregisterInterpolatedTransform( this );
     }
 
     void Transform::onTransform( const sf::Transform& inTrans, sf::Transform& outTrans )
     {
+        sf::Vector2f position = m_position;
+        float rotation = m_rotation;
+        sf::Vector2f scale = m_scale;
+        if( s_interpolationAlpha < 1.0f && m_interpolationStored )
+        {
+            float a = s_interpolationAlpha;
+            float r = std::fmod( m_rotation - m_prevRotation, 360.0f );
+            if( r > 180.0f )
+                r -= 360.0f;
+            else if( r < -180.0f )
+                r += 360.0f;
+            position = m_prevPosition + ( m_position - m_prevPosition ) * a;
+            rotation = m_prevRotation + r * a;
+            scale = m_prevScale + ( m_scale - m_prevScale ) * a;
+        }
         sf::Transform t;
         if( m_mode == mHierarchy )
         {
-            t.translate( m_position );
-            t.rotate( m_rotation );
-            t.scale( m_scale );
+            t.translate( position );
+            t.rotate( rotation );
+            t.scale( scale );
             outTrans = inTrans * t;
         }
         else if( m_mode == mParent )
             outTrans = inTrans;
         else
         {
-            t.translate( m_position );
-            t.rotate( m_rotation );
-            t.scale( m_scale );
+            t.translate( position );
+            t.rotate( rotation );
+            t.scale( scale );
             outTrans = t;
         }
         m_transform = t;
         m_transformGlobal = outTrans;
     }
 
+    bool Transform::onRecycle()
+    {
+        m_position = sf::Vector2f( 0.0f, 0.0f );
+        m_rotation = 0.0f;
+        m_scale = sf::Vector2f( 1.0f, 1.0f );
+        m_mode = mHierarchy;
+        m_transform = sf::Transform::Identity;
+        m_transformGlobal = sf::Transform::Identity;
+        m_interpolationStored = false;
+        m_interpolated = false;
+        if( m_interpolationOwner )
+            m_interpolationOwner->unregisterInterpolatedTransform( this );
+        return true;
+    }
+
+    void Transform::onSaveState( StateBuffer& state )
+    {
+        state.write( m_position );
+        state.write( m_rotation );
+        state.write( m_scale );
+    }
+
+    void Transform::onLoadState( StateBuffer& state )
+    {
+        sf::Vector2f position = m_position;
+        float rotation = m_rotation;
+        sf::Vector2f scale = m_scale;
+        state.read( position );
+        state.read( rotation );
+        state.read( scale );
+        setPosition( position );
+        setRotation( rotation );
+        setScale( scale );
+        resetInterpolationState();
+    }
+
 }
@@ -1,5 +1,8 @@
 #include "../../include/Ptakopysk/CustomAssets/SpriteAtlasAsset.h"
+#include "../../include/Ptakopysk/System/TexturePacker.h"
+#include <XeCore/Common/Logger.h>
 #include <sstream>
+#include <algorithm>
 
 namespace Ptakopysk
 {
@@ -11,6 +14,7 @@ namespace Ptakopysk
 
     SpriteAtlasAsset::SpriteAtlasAsset()
     : RTTI_CLASS_DEFINE( SpriteAtlasAsset )
+    , m_packed( false )
     {
     }
 
@@ -33,6 +37,15 @@ namespace Ptakopysk
         if( sprite && m_rects.count( name ) )
         {
             sf::IntRect rect = m_rects[ name ];
+            sf::Texture* page;
+            sf::IntRect region;
+            if( m_packed )
+                sprite->setTexture( Assets::use().getTexture( name ) );
+            else if( Assets::use().findTextureRegion( sprite->getTexture(), page, region ) )
+            {
+                rect.left += region.left;
+                rect.top += region.top;
+            }
             sprite->setSize( sf::Vector2f( (float)rect.width, (float)rect.height ) );
             sprite->getRenderer()->setTextureRect( rect );
             return true;
@@ -60,9 +73,106 @@ namespace Ptakopysk
         return false;
     }
 
+    bool SpriteAtlasAsset::pack( const std::string& id, const std::vector< std::string >& textures, unsigned int pageSize, unsigned int padding, bool smooth )
+    {
+        m_rects.clear();
+        m_pages.clear();
+        m_packed = true;
+        Assets& assets = Assets::use();
+        if( assets.isHeadless() )
+            return false;
+        TexturePacker packer( pageSize, pageSize, padding );
+        std::vector< std::string > names;
+        std::vector< sf::Texture* > sources;
+        sf::Texture* t;
+        sf::Texture* page;
+        sf::IntRect rect;
+        for( std::vector< std::string >::const_iterator it = textures.begin(); it != textures.end(); it++ )
+        {
+            t = assets.getTexture( *it );
+            if( !t )
+            {
+                std::stringstream ss;
+                ss << "Texture '" << it->c_str() << "' not found and cannot be packed into atlas '" << id.c_str() << "'!";
+                XWARNING( ss.str().c_str() );
+                continue;
+            }
+            if( t->isRepeated() || assets.findTextureRegion( t, page, rect ) )
+                continue;
+            names.push_back( *it );
+            sources.push_back( t );
+            packer.add( t->getSize() );
+        }
+        packer.pack();
+        std::vector< sf::Image > images( packer.pagesCount() );
+        for( unsigned int i = 0; i < images.size(); i++ )
+        {
+            sf::Vector2u s = packer.getPageSize( i );
+            images[ i ].create( s.x, s.y, sf::Color::Transparent );
+        }
+        unsigned int index;
+        for( unsigned int i = 0; i < sources.size(); i++ )
+        {
+            if( packer.getItem( i, index, rect ) )
+            {
+                images[ index ].copy( sources[ i ]->copyToImage(), rect.left, rect.top );
+                if( padding )
+                    extrude( images[ index ], rect, padding / 2, padding - padding / 2 );
+            }
+        }
+        for( unsigned int i = 0; i < images.size(); i++ )
+        {
+            std::stringstream ss;
+            ss << id.c_str() << "#" << i;
+            assets.freeTexture( ss.str() );
+            t = xnew sf::Texture();
+            if( !t->loadFromImage( images[ i ] ) )
+            {
+                ss << " page cannot be created!";
+                XWARNING( ss.str().c_str() );
+                DELETE_OBJECT( t );
+                m_pages.push_back( "" );
+                continue;
+            }
+            t->setSmooth( smooth );
+            assets.addTexture( ss.str(), t );
+            m_pages.push_back( ss.str() );
+        }
+        for( unsigned int i = 0; i < sources.size(); i++ )
+        {
+            if( !packer.getItem( i, index, rect ) || m_pages[ index ].empty() )
+                continue;
+            m_rects[ names[ i ] ] = rect;
+            assets.setTextureRegion( sources[ i ], assets.getTexture( m_pages[ index ] ), rect );
+        }
+        return m_rects.size() > 0;
+    }
+
+    void SpriteAtlasAsset::extrude( sf::Image& image, const sf::IntRect& rect, unsigned int before, unsigned int after )
+    {
+        sf::Vector2u size = image.getSize();
+        int left = std::max( 0, rect.left - (int)before );
+        int top = std::max( 0, rect.top - (int)before );
+        int right = std::min( (int)size.x, rect.left + rect.width + (int)after );
+        int bottom = std::min( (int)size.y, rect.top + rect.height + (int)after );
+        int maxX = rect.left + rect.width - 1;
+        int maxY = rect.top + rect.height - 1;
+        for( int y = top; y < bottom; y++ )
+        {
+            for( int x = left; x < right; x++ )
+            {
+                if( x >= rect.left && x <= maxX && y >= rect.top && y <= maxY )
+                    continue;
+                image.setPixel( x, y, image.getPixel( std::min( std::max( x, rect.left ), maxX ), std::min( std::max( y, rect.top ), maxY ) ) );
+            }
+        }
+    }
+
     bool SpriteAtlasAsset::onLoad( const std::string& path )
     {
         m_rects.clear();
+        m_pages.clear();
+        m_packed = false;
         Json::Value root = Assets::use().loadJson( path );
         if( root.isObject() && root.isMember( "TextureAtlas" ) )
         {
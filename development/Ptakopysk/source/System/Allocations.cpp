@@ -0,0 +1,244 @@
+#include "../../include/Ptakopysk/System/Allocations.h"
+#include <cstdlib>
+#include <new>
+
+namespace Ptakopysk
+{
+
+    union AllocationHeader
+    {
+        struct
+        {
+            unsigned int size;
+            unsigned int subsystem;
+        } info;
+        double alignment[ 2 ];
+    };
+
+    static __thread int s_currentSubsystem = Allocations::sGeneral;
+
+    Allocations::Stats Allocations::s_stats[ Allocations::sCount ];
+    Allocations::FrameStats Allocations::s_frame[ Allocations::sCount ];
+    Allocations::FrameStats Allocations::s_lastFrame[ Allocations::sCount ];
+    unsigned int Allocations::s_framesCount = 0;
+
+    Allocations::Stats Allocations::getTotalStats()
+    {
+        Stats r = { 0, 0, 0, 0, 0, 0, 0 };
+        for( unsigned int i = 0; i < sCount; i++ )
+        {
+            r.allocations += s_stats[ i ].allocations;
+            r.deallocations += s_stats[ i ].deallocations;
+            r.allocatedBytes += s_stats[ i ].allocatedBytes;
+            r.liveBytes += s_stats[ i ].liveBytes;
+            r.peakLiveBytes += s_stats[ i ].peakLiveBytes;
+            r.peakFrameAllocations += s_stats[ i ].peakFrameAllocations;
+            r.peakFrameBytes += s_stats[ i ].peakFrameBytes;
+        }
+        return r;
+    }
+
+    Allocations::FrameStats Allocations::getTotalFrameStats()
+    {
+        FrameStats r = { 0, 0, 0 };
+        for( unsigned int i = 0; i < sCount; i++ )
+        {
+            r.allocations += s_frame[ i ].allocations;
+            r.deallocations += s_frame[ i ].deallocations;
+            r.allocatedBytes += s_frame[ i ].allocatedBytes;
+        }
+        return r;
+    }
+
+    Allocations::FrameStats Allocations::getTotalLastFrameStats()
+    {
+        FrameStats r = { 0, 0, 0 };
+        for( unsigned int i = 0; i < sCount; i++ )
+        {
+            r.allocations += s_lastFrame[ i ].allocations;
+            r.deallocations += s_lastFrame[ i ].deallocations;
+            r.allocatedBytes += s_lastFrame[ i ].allocatedBytes;
+        }
+        return r;
+    }
+
+    const char* Allocations::subsystemName( Subsystem s )
+    {
+        static const char* names[ sCount ] = { "general", "scene", "assets", "physics", "network", "update", "render" };
+        return s < sCount ? names[ s ] : "unknown";
+    }
+
+    Allocations::Subsystem Allocations::getSubsystem()
+    {
+        return (Subsystem)s_currentSubsystem;
+    }
+
+    Allocations::Subsystem Allocations::setSubsystem( Subsystem s )
+    {
+        Subsystem prev = (Subsystem)s_currentSubsystem;
+        s_currentSubsystem = s < sCount ? s : sGeneral;
+        return prev;
+    }
+
+    void* Allocations::allocate( std::size_t size )
+    {
+        AllocationHeader* h = (AllocationHeader*)std::malloc( sizeof( AllocationHeader ) + size );
+        if( !h )
+            return 0;
+        unsigned int s = (unsigned int)s_currentSubsystem;
+        h->info.size = (unsigned int)size;
+        h->info.subsystem = s;
+        Stats& st = s_stats[ s ];
+        __sync_fetch_and_add( &st.allocations, 1 );
+        __sync_fetch_and_add( &st.allocatedBytes, (unsigned long long)h->info.size );
+        __sync_fetch_and_add( &s_frame[ s ].allocations, 1 );
+        __sync_fetch_and_add( &s_frame[ s ].allocatedBytes, (unsigned long long)h->info.size );
+        unsigned long long live = __sync_add_and_fetch( &st.liveBytes, (unsigned long long)h->info.size );
+        unsigned long long peak = st.peakLiveBytes;
+        while( live > peak && !__sync_bool_compare_and_swap( &st.peakLiveBytes, peak, live ) )
+            peak = st.peakLiveBytes;
+        return h + 1;
+    }
+
+    void Allocations::release( void* ptr )
+    {
+        if( !ptr )
+            return;
+        AllocationHeader* h = (AllocationHeader*)ptr - 1;
+        unsigned int s = h->info.subsystem < sCount ? h->info.subsystem : sGeneral;
+        __sync_fetch_and_add( &s_stats[ s ].deallocations, 1 );
+        __sync_fetch_and_sub( &s_stats[ s ].liveBytes, (unsigned long long)h->info.size );
+        __sync_fetch_and_add( &s_frame[ s ].deallocations, 1 );
+        std::free( h );
+    }
+
+    void Allocations::beginFrame()
+    {
+        for( unsigned int i = 0; i < sCount; i++ )
+        {
+            s_frame[ i ].allocations = 0;
+            s_frame[ i ].deallocations = 0;
+            s_frame[ i ].allocatedBytes = 0;
+        }
+    }
+
+    void Allocations::endFrame()
+    {
+        for( unsigned int i = 0; i < sCount; i++ )
+        {
+            s_lastFrame[ i ] = s_frame[ i ];
+            if( s_frame[ i ].allocations > s_stats[ i ].peakFrameAllocations )
+                s_stats[ i ].peakFrameAllocations = s_frame[ i ].allocations;
+            if( s_frame[ i ].allocatedBytes > s_stats[ i ].peakFrameBytes )
+                s_stats[ i ].peakFrameBytes = s_frame[ i ].allocatedBytes;
+        }
+        s_framesCount++;
+    }
+
+    void Allocations::reset()
+    {
+        for( unsigned int i = 0; i < sCount; i++ )
+        {
+            s_stats[ i ].allocations = 0;
+            s_stats[ i ].deallocations = 0;
+            s_stats[ i ].allocatedBytes = 0;
+            s_stats[ i ].peakLiveBytes = s_stats[ i ].liveBytes;
+            s_stats[ i ].peakFrameAllocations = 0;
+            s_stats[ i ].peakFrameBytes = 0;
+            s_lastFrame[ i ].allocations = 0;
+            s_lastFrame[ i ].deallocations = 0;
+            s_lastFrame[ i ].allocatedBytes = 0;
+        }
+        s_framesCount = 0;
+    }
+
+    Json::Value Allocations::statsToJson()
+    {
+        Json::Value root;
+        root[ "hooked" ] = Json::Value( isHooked() );
+        root[ "frames" ] = Json::Value( s_framesCount );
+        Json::Value subsystems( Json::objectValue );
+        Json::Value item;
+        for( unsigned int i = 0; i < sCount; i++ )
+        {
+            const Stats& st = s_stats[ i ];
+            item = Json::Value( Json::objectValue );
+            item[ "allocations" ] = Json::Value( st.allocations );
+            item[ "deallocations" ] = Json::Value( st.deallocations );
+            item[ "allocatedBytes" ] = Json::Value( (double)st.allocatedBytes );
+            item[ "liveBytes" ] = Json::Value( (double)st.liveBytes );
+            item[ "peakLiveBytes" ] = Json::Value( (double)st.peakLiveBytes );
+            item[ "peakFrameAllocations" ] = Json::Value( st.peakFrameAllocations );
+            item[ "peakFrameBytes" ] = Json::Value( (double)st.peakFrameBytes );
+            item[ "lastFrame" ][ "allocations" ] = Json::Value( s_lastFrame[ i ].allocations );
+            item[ "lastFrame" ][ "deallocations" ] = Json::Value( s_lastFrame[ i ].deallocations );
+            item[ "lastFrame" ][ "allocatedBytes" ] = Json::Value( (double)s_lastFrame[ i ].allocatedBytes );
+            subsystems[ subsystemName( (Subsystem)i ) ] = item;
+        }
+        root[ "subsystems" ] = subsystems;
+#ifdef XMM_MEMORY_TRACING_MODE
+        root[ "traced" ][ "count" ] = Json::Value( XeCore::Common::MemoryManager::use().getCount() );
+        root[ "traced" ][ "bytes" ] = Json::Value( XeCore::Common::MemoryManager::use().totalByteSize() );
+#endif
+        return root;
+    }
+
+}
+
+#ifdef PTAKOPYSK_ALLOCATION_HOOKS
+
+static void* allocateOrThrow( std::size_t size )
+{
+    void* p;
+    while( !( p = Ptakopysk::Allocations::allocate( size ) ) )
+    {
+        std::new_handler handler = std::set_new_handler( 0 );
+        std::set_new_handler( handler );
+        if( !handler )
+            throw std::bad_alloc();
+        handler();
+    }
+    return p;
+}
+
+void* operator new( std::size_t size ) throw( std::bad_alloc )
+{
+    return allocateOrThrow( size );
+}
+
+void* operator new[]( std::size_t size ) throw( std::bad_alloc )
+{
+    return allocateOrThrow( size );
+}
+
+void* operator new( std::size_t size, const std::nothrow_t& ) throw()
+{
+    return Ptakopysk::Allocations::allocate( size );
+}
+
+void* operator new[]( std::size_t size, const std::nothrow_t& ) throw()
+{
+    return Ptakopysk::Allocations::allocate( size );
+}
+
+void operator delete( void* ptr ) throw()
+{
+    Ptakopysk::Allocations::release( ptr );
+}
+
+void operator delete[]( void* ptr ) throw()
+{
+    Ptakopysk::Allocations::release( ptr );
+}
+
+void operator delete( void* ptr, const std::nothrow_t& ) throw()
+{
+    Ptakopysk::Allocations::release( ptr );
+}
+
+void operator delete[]( void* ptr, const std::nothrow_t& ) throw()
+{
+    Ptakopysk::Allocations::release( ptr );
+}
+
+#endif
@@ -1,9 +1,12 @@
 #include "../../include/Ptakopysk/System/Assets.h"
 #include "../../include/Ptakopysk/CustomAssets/SpriteAtlasAsset.h"
+#include "../../include/Ptakopysk/System/Allocations.h"
+#include "../../include/Ptakopysk/System/GlyphRunCache.h"
 #include <XeCore/Common/String.h>
 #include <XeCore/Common/Logger.h>
 #include <BinaryJson/BinaryJson.h>
 #include <fstream>
+#include <algorithm>
 
 namespace Ptakopysk
 {
@@ -30,12 +33,11 @@ namespace Ptakopysk
     Assets::Assets()
     : RTTI_CLASS_DEFINE( Assets )
     , m_loadingMode( LoadOnlyValidAssets )
+    , m_defaultTexture( 0 )
     , m_assetsChangedListener( 0 )
+    , m_headless( false )
     {
         registerCustomAssetFactory( "SpriteAtlasAsset", RTTI_CLASS_TYPE( SpriteAtlasAsset ), SpriteAtlasAsset::onBuildCustomAsset );
-        m_defaultTexture = xnew sf::Texture();
-        m_defaultTexture->create( 1, 1 );
-        m_defaultTexture->update( &sf::Color::White.r );
     }
 
     Assets::~Assets()
@@ -47,6 +49,7 @@ namespace Ptakopysk
 
     Json::Value Assets::loadJson( const std::string& path, bool binary, dword binaryKeyHash )
     {
+        ALLOCATIONS_SCOPE( sAssets );
         std::ifstream file;
         std::string p = makePath( path );
         file.open( p.c_str(), std::ifstream::in | std::ifstream::binary );
@@ -144,49 +147,22 @@ namespace Ptakopysk
 
     bool Assets::registerCustomAssetFactory( const std::string& id, XeCore::Common::IRtti::Derivation type, ICustomAsset::OnBuildCustomAssetCallback builder )
     {
-        if( id.empty() || m_customFactory.count( id ) || !type || !builder )
-            return false;
-        CustomAssetFactoryData d;
-        d.type = type;
-        d.builder = builder;
-        m_customFactory[ id ] = d;
-        return true;
+        return m_customFactory.add( id, type, builder );
     }
 
     bool Assets::unregisterCustomAssetFactory( const std::string& id )
     {
-        if( m_customFactory.count( id ) )
-        {
-            m_customFactory.erase( id );
-            return true;
-        }
-        return false;
+        return m_customFactory.removeById( id );
     }
 
     bool Assets::unregisterCustomAssetFactory( XeCore::Common::IRtti::Derivation type )
     {
-        for( std::map< std::string, CustomAssetFactoryData >::iterator it = m_customFactory.begin(); it != m_customFactory.end(); it++ )
-        {
-            if( it->second.type == type )
-            {
-                m_customFactory.erase( it );
-                return true;
-            }
-        }
-        return false;
+        return m_customFactory.removeByType( type );
     }
 
     bool Assets::unregisterCustomAssetFactory( ICustomAsset::OnBuildCustomAssetCallback builder )
     {
-        for( std::map< std::string, CustomAssetFactoryData >::iterator it = m_customFactory.begin(); it != m_customFactory.end(); it++ )
-        {
-            if( it->second.builder == builder )
-            {
-                m_customFactory.erase( it );
-                return true;
-            }
-        }
-        return false;
+        return m_customFactory.removeByBuilder( builder );
     }
 
     void Assets::unregisterAllCustomAssetFactories()
@@ -196,69 +172,56 @@ namespace Ptakopysk
 
     XeCore::Common::IRtti::Derivation Assets::findCustomAssetFactoryTypeById( const std::string& id )
     {
-        if( m_customFactory.count( id ) )
-            return m_customFactory[ id ].type;
-        return 0;
+        const CustomAssetsFactory::Entry* e = m_customFactory.findById( id );
+        return e ? e->type : 0;
     }
 
     XeCore::Common::IRtti::Derivation Assets::findCustomAssetFactoryTypeByBuilder( ICustomAsset::OnBuildCustomAssetCallback builder )
     {
-        for( std::map< std::string, CustomAssetFactoryData >::iterator it = m_customFactory.begin(); it != m_customFactory.end(); it++ )
-            if( it->second.builder == builder )
-                return it->second.type;
-        return 0;
+        const CustomAssetsFactory::Entry* e = m_customFactory.findByBuilder( builder );
+        return e ? e->type : 0;
     }
 
     std::string Assets::findCustomAssetFactoryIdByType( XeCore::Common::IRtti::Derivation type )
     {
-        for( std::map< std::string, CustomAssetFactoryData >::iterator it = m_customFactory.begin(); it != m_customFactory.end(); it++ )
-            if( it->second.type == type )
-                return it->first;
-        return std::string();
+        const CustomAssetsFactory::Entry* e = m_customFactory.findByType( type );
+        return e ? e->id : std::string();
     }
 
     std::string Assets::findCustomAssetFactoryIdByBuilder( ICustomAsset::OnBuildCustomAssetCallback builder )
     {
-        for( std::map< std::string, CustomAssetFactoryData >::iterator it = m_customFactory.begin(); it != m_customFactory.end(); it++ )
-            if( it->second.builder == builder )
-                return it->first;
-        return std::string();
+        const CustomAssetsFactory::Entry* e = m_customFactory.findByBuilder( builder );
+        return e ? e->id : std::string();
     }
 
     ICustomAsset::OnBuildCustomAssetCallback Assets::findCustomAssetFactoryBuilderById( const std::string& id )
     {
-        if( m_customFactory.count( id ) )
-            return m_customFactory[ id ].builder;
-        return 0;
+        const CustomAssetsFactory::Entry* e = m_customFactory.findById( id );
+        return e ? e->builder : 0;
     }
 
     ICustomAsset::OnBuildCustomAssetCallback Assets::findCustomAssetFactoryBuilderByType( XeCore::Common::IRtti::Derivation type )
     {
-        for( std::map< std::string, CustomAssetFactoryData >::iterator it = m_customFactory.begin(); it != m_customFactory.end(); it++ )
-            if( it->second.type == type )
-                return it->second.builder;
-        return 0;
+        const CustomAssetsFactory::Entry* e = m_customFactory.findByType( type );
+        return e ? e->builder : 0;
     }
 
     ICustomAsset* Assets::buildCustomAsset( const std::string& id )
     {
-        if( m_customFactory.count( id ) )
-            return m_customFactory[ id ].builder();
-        return 0;
+        const CustomAssetsFactory::Entry* e = m_customFactory.findById( id );
+        return e ? e->builder() : 0;
     }
 
     ICustomAsset* Assets::buildCustomAsset( XeCore::Common::IRtti::Derivation type )
     {
-        for( std::map< std::string, CustomAssetFactoryData >::iterator it = m_customFactory.begin(); it != m_customFactory.end(); it++ )
-            if( it->second.type == type )
-                return it->second.builder();
-        return 0;
+        const CustomAssetsFactory::Entry* e = m_customFactory.findByType( type );
+        return e ? e->builder() : 0;
     }
 
     unsigned int Assets::getCustomAssetsIds( std::vector< std::string >& result )
     {
         result.clear();
-        for( std::map< std::string, CustomAssetFactoryData >::iterator it = m_customFactory.begin(); it != m_customFactory.end(); it++ )
+        for( CustomAssetsFactory::EntriesById::const_iterator it = m_customFactory.getEntries().begin(); it != m_customFactory.getEntries().end(); it++ )
             result.push_back( it->first );
         return result.size();
     }
@@ -266,7 +229,7 @@ namespace Ptakopysk
     unsigned int Assets::getCustomAssetsTypes( std::vector< XeCore::Common::IRtti::Derivation >& result )
     {
         result.clear();
-        for( std::map< std::string, CustomAssetFactoryData >::iterator it = m_customFactory.begin(); it != m_customFactory.end(); it++ )
+        for( CustomAssetsFactory::EntriesById::const_iterator it = m_customFactory.getEntries().begin(); it != m_customFactory.getEntries().end(); it++ )
             result.push_back( it->second.type );
         return result.size();
     }
@@ -274,16 +237,18 @@ namespace Ptakopysk
     unsigned int Assets::getCustomAssetsBuilders( std::vector< ICustomAsset::OnBuildCustomAssetCallback >& result )
     {
         result.clear();
-        for( std::map< std::string, CustomAssetFactoryData >::iterator it = m_customFactory.begin(); it != m_customFactory.end(); it++ )
+        for( CustomAssetsFactory::EntriesById::const_iterator it = m_customFactory.getEntries().begin(); it != m_customFactory.getEntries().end(); it++ )
             result.push_back( it->second.builder );
         return result.size();
     }
 
     void Assets::jsonToAssets( const Json::Value& root )
     {
+        ALLOCATIONS_SCOPE( sAssets );
         if( !root.isObject() )
             return;
         jsonToTextures( root[ "textures" ] );
+        jsonToAtlases( root[ "atlases" ] );
         jsonToShaders( root[ "shaders" ] );
         jsonToSounds( root[ "sounds" ] );
         jsonToMusics( root[ "musics" ] );
@@ -339,6 +304,14 @@ namespace Ptakopysk
             jsonToCustomAsset( root[ i ] );
     }
 
+    void Assets::jsonToAtlases( const Json::Value& root )
+    {
+        if( !root.isArray() )
+            return;
+        for( unsigned int i = 0; i < root.size(); i++ )
+            jsonToAtlas( root[ i ] );
+    }
+
     sf::Texture* Assets::jsonToTexture( const Json::Value& root )
     {
         if( !root.isObject() )
@@ -447,7 +420,7 @@ namespace Ptakopysk
         Json::Value id = root[ "id" ];
         Json::Value type = root[ "type" ];
         Json::Value path = root[ "path" ];
-        if( id.isString() && type.isString() && m_customFactory.count( type.asString() ) && path.isString() )
+        if( id.isString() && type.isString() && m_customFactory.findById( type.asString() ) && path.isString() )
         {
             Json::Value tags = root[ "tags" ];
             if( tags.isArray() && tags.size() )
@@ -457,6 +430,64 @@ namespace Ptakopysk
         return 0;
     }
 
+    SpriteAtlasAsset* Assets::jsonToAtlas( const Json::Value& root )
+    {
+        if( !root.isObject() )
+            return 0;
+        Json::Value id = root[ "id" ];
+        Json::Value textures = root[ "textures" ];
+        Json::Value tag = root[ "tag" ];
+        Json::Value pageSize = root[ "pageSize" ];
+        Json::Value padding = root[ "padding" ];
+        Json::Value smooth = root[ "smooth" ];
+        if( !id.isString() )
+            return 0;
+        std::vector< std::string > t;
+        Json::Value item;
+        if( textures.isArray() )
+        {
+            for( unsigned int i = 0; i < textures.size(); i++ )
+            {
+                item = textures[ i ];
+                if( item.isString() )
+                    t.push_back( item.asString() );
+            }
+        }
+        if( tag.isString() )
+        {
+            for( std::map< std::string, std::vector< std::string > >::iterator it = m_tagsTextures.begin(); it != m_tagsTextures.end(); it++ )
+            {
+                if( std::find( it->second.begin(), it->second.end(), tag.asString() ) != it->second.end() &&
+                    std::find( t.begin(), t.end(), it->first ) == t.end()
+                )
+                    t.push_back( it->first );
+            }
+        }
+        if( m_headless )
+        {
+            m_metaAtlases[ id.asString() ] = root;
+            Json::Value tags = root[ "tags" ];
+            if( tags.isArray() && tags.size() )
+                parseTags( tags, m_tagsCustom[ id.asString() ] );
+            return 0;
+        }
+        SpriteAtlasAsset* a = packAtlas(
+            id.asString(),
+            t,
+            pageSize.isNumeric() ? pageSize.asUInt() : 2048,
+            padding.isNumeric() ? padding.asUInt() : 1,
+            smooth.isBool() ? smooth.asBool() : true
+        );
+        if( a )
+        {
+            m_metaAtlases[ id.asString() ] = root;
+            Json::Value tags = root[ "tags" ];
+            if( tags.isArray() && tags.size() )
+                parseTags( tags, m_tagsCustom[ id.asString() ] );
+        }
+        return a;
+    }
+
     Json::Value Assets::assetsToJson()
     {
         Json::Value textures = texturesToJson();
@@ -465,6 +496,7 @@ namespace Ptakopysk
         Json::Value musics = musicsToJson();
         Json::Value fonts = fontsToJson();
         Json::Value custom = customAssetsToJson();
+        Json::Value atlases = atlasesToJson();
         Json::Value root;
         if( !textures.isNull() )
             root[ "textures" ] = textures;
@@ -478,6 +510,8 @@ namespace Ptakopysk
             root[ "fonts" ] = fonts;
         if( !custom.isNull() )
             root[ "custom" ] = custom;
+        if( !atlases.isNull() )
+            root[ "atlases" ] = atlases;
         return root;
     }
 
@@ -559,6 +593,19 @@ namespace Ptakopysk
         return root;
     }
 
+    Json::Value Assets::atlasesToJson()
+    {
+        Json::Value root;
+        Json::Value item;
+        for( std::map< std::string, Json::Value >::iterator it = m_metaAtlases.begin(); it != m_metaAtlases.end(); it++ )
+        {
+            item = atlasToJson( it->first );
+            if( !item.isNull() )
+                root.append( item );
+        }
+        return root;
+    }
+
     Json::Value Assets::textureToJson( const std::string& id )
     {
         if( !m_metaTextures.count( id ) )
@@ -745,10 +792,33 @@ namespace Ptakopysk
         return t;
     }
 
+    Json::Value Assets::atlasToJson( const std::string& id )
+    {
+        if( !m_metaAtlases.count( id ) )
+            return Json::Value::null;
+        Json::Value root = m_metaAtlases[ id ];
+        if( m_tagsCustom.count( id ) )
+            root[ "tags" ] = jsonTags( m_tagsCustom[ id ] );
+        return root;
+    }
+
     sf::Texture* Assets::loadTexture( const std::string& id, const std::string& path )
     {
+        ALLOCATIONS_SCOPE( sAssets );
         sf::Texture* t = getTexture( id );
-        if( !t )
+        if( !t && m_headless )
+        {
+            if( !m_metaTextures.count( id ) )
+            {
+                sf::Image image;
+                std::string p = makePath( path );
+                if( !image.loadFromFile( p ) && ( m_loadingMode != LoadIfFilesExists || !fileExists( p ) ) )
+                    return 0;
+                m_metaTextures[ id ] = path;
+                m_sizesTextures[ id ] = image.getSize();
+            }
+        }
+        else if( !t )
         {
             t = xnew sf::Texture();
             if( s_fileSystemRoot.empty() )
@@ -785,8 +855,16 @@ namespace Ptakopysk
 
     sf::Shader* Assets::loadShader( const std::string& id, const std::string& vspath, const std::string& fspath, const std::string* uniforms, unsigned int uniformsCount )
     {
+        ALLOCATIONS_SCOPE( sAssets );
         sf::Shader* t = getShader( id );
-        if( !t )
+        if( !t && m_headless )
+        {
+            m_metaShaders[ id ] = vspath + "|" + fspath;
+            m_uniformsShaders[ id ].clear();
+            for( unsigned int i = 0; i < uniformsCount; i++ )
+                m_uniformsShaders[ id ].push_back( uniforms[ i ] );
+        }
+        else if( !t )
         {
             if( !sf::Shader::isAvailable() && m_loadingMode == LoadOnlyValidAssets )
                 return 0;
@@ -830,6 +908,7 @@ namespace Ptakopysk
 
     sf::Sound* Assets::loadSound( const std::string& id, const std::string& path )
     {
+        ALLOCATIONS_SCOPE( sAssets );
         sf::Sound* t = getSound( id );
         if( !t )
         {
@@ -871,6 +950,7 @@ namespace Ptakopysk
 
     sf::Music* Assets::loadMusic( const std::string& id, const std::string& path )
     {
+        ALLOCATIONS_SCOPE( sAssets );
         sf::Music* t = getMusic( id );
         if( !t )
         {
@@ -909,8 +989,11 @@ namespace Ptakopysk
 
     sf::Font* Assets::loadFont( const std::string& id, const std::string& path )
     {
+        ALLOCATIONS_SCOPE( sAssets );
         sf::Font* t = getFont( id );
-        if( !t )
+        if( !t && m_headless )
+            m_metaFonts[ id ] = path;
+        else if( !t )
         {
             t = xnew sf::Font();
             if( s_fileSystemRoot.empty() )
@@ -947,10 +1030,12 @@ namespace Ptakopysk
 
     ICustomAsset* Assets::loadCustomAsset( const std::string& id, const std::string& type, const std::string& path )
     {
+        ALLOCATIONS_SCOPE( sAssets );
         ICustomAsset* t = getCustomAsset( id );
-        if( !t && m_customFactory.count( type ) )
+        const CustomAssetsFactory::Entry* e = t ? 0 : m_customFactory.findById( type );
+        if( e )
         {
-            t = m_customFactory[ type ].builder();
+            t = e->builder();
             if( !t )
                 return 0;
             if( !t->onLoad( path ) )
@@ -969,6 +1054,44 @@ namespace Ptakopysk
         return t;
     }
 
+    SpriteAtlasAsset* Assets::packAtlas( const std::string& id, const std::vector< std::string >& textures, unsigned int pageSize, unsigned int padding, bool smooth )
+    {
+        ALLOCATIONS_SCOPE( sAssets );
+        ICustomAsset* c = getCustomAsset( id );
+        if( c )
+            return XeCore::Common::IRtti::isType< SpriteAtlasAsset >( c ) ? (SpriteAtlasAsset*)c : 0;
+        if( m_headless )
+            return 0;
+        SpriteAtlasAsset* t = xnew SpriteAtlasAsset();
+        if( !t->pack( id, textures, pageSize, padding, smooth ) )
+        {
+            for( unsigned int i = 0; i < t->getPagesCount(); i++ )
+                freeTexture( t->getPage( i ) );
+            DELETE_OBJECT( t );
+            return 0;
+        }
+        addCustomAsset( id, t );
+        return t;
+    }
+
+    sf::Texture* Assets::getDefaultTexture()
+    {
+        if( !m_defaultTexture && !m_headless )
+        {
+            m_defaultTexture = xnew sf::Texture();
+            m_defaultTexture->create( 1, 1 );
+            m_defaultTexture->update( &sf::Color::White.r );
+        }
+        return m_defaultTexture;
+    }
+
+    sf::Vector2u Assets::getTextureSize( const std::string& id )
+    {
+        if( m_textures.count( id ) )
+            return m_textures[ id ]->getSize();
+        return m_sizesTextures.count( id ) ? m_sizesTextures[ id ] : sf::Vector2u();
+    }
+
     sf::Texture* Assets::getTexture( const std::string& id )
     {
         return m_textures.count( id ) ? m_textures[ id ] : 0;
@@ -999,6 +1122,30 @@ namespace Ptakopysk
         return m_custom.count( id ) ? m_custom[ id ] : 0;
     }
 
+    bool Assets::findTextureRegion( const sf::Texture* ptr, sf::Texture*& outPage, sf::IntRect& outRect )
+    {
+        std::map< const sf::Texture*, TextureRegion >::iterator it = m_textureRegions.find( ptr );
+        if( it == m_textureRegions.end() )
+            return false;
+        outPage = it->second.page;
+        outRect = it->second.rect;
+        return true;
+    }
+
+    void Assets::setTextureRegion( const sf::Texture* ptr, sf::Texture* page, const sf::IntRect& rect )
+    {
+        if( !ptr )
+            return;
+        if( !page )
+        {
+            m_textureRegions.erase( ptr );
+            return;
+        }
+        TextureRegion& r = m_textureRegions[ ptr ];
+        r.page = page;
+        r.rect = rect;
+    }
+
     std::string Assets::findTexture( const sf::Texture* ptr )
     {
         if( !ptr )
@@ -1061,7 +1208,7 @@ namespace Ptakopysk
 
     bool Assets::shadersAvailable()
     {
-        return sf::Shader::isAvailable();
+        return !m_headless && sf::Shader::isAvailable();
     }
 
     void Assets::freeTexture( const std::string& id )
@@ -1069,6 +1216,14 @@ namespace Ptakopysk
         if( m_textures.count( id ) )
         {
             sf::Texture* t = m_textures[ id ];
+            m_textureRegions.erase( t );
+            for( std::map< const sf::Texture*, TextureRegion >::iterator it = m_textureRegions.begin(); it != m_textureRegions.end(); )
+            {
+                if( it->second.page == t )
+                    m_textureRegions.erase( it++ );
+                else
+                    it++;
+            }
             if( m_assetsChangedListener )
                 m_assetsChangedListener->onTextureChanged( id, t, false );
             DELETE_OBJECT( t );
@@ -1076,6 +1231,8 @@ namespace Ptakopysk
         }
         if( m_metaTextures.count( id ) )
             m_metaTextures.erase( id );
+        if( m_sizesTextures.count( id ) )
+            m_sizesTextures.erase( id );
         if( m_tagsTextures.count( id ) )
             m_tagsTextures.erase( id );
     }
@@ -1143,6 +1300,7 @@ namespace Ptakopysk
             sf::Font* t = m_fonts[ id ];
             if( m_assetsChangedListener )
                 m_assetsChangedListener->onFontChanged( id, t, false );
+            GlyphRunCache::removeFontFromAll( t );
             DELETE_OBJECT( t );
             m_fonts.erase( id );
         }
@@ -1159,17 +1317,32 @@ namespace Ptakopysk
             ICustomAsset* t = m_custom[ id ];
             if( m_assetsChangedListener )
                 m_assetsChangedListener->onCustomAssetChanged( id, t, false );
+            freeAtlasPages( t );
             DELETE_OBJECT( t );
             m_custom.erase( id );
         }
+        if( m_metaAtlases.count( id ) )
+            m_metaAtlases.erase( id );
         if( m_metaCustom.count( id ) )
             m_metaCustom.erase( id );
         if( m_tagsCustom.count( id ) )
             m_tagsCustom.erase( id );
     }
 
+    void Assets::freeAtlasPages( ICustomAsset* asset )
+    {
+        if( !XeCore::Common::IRtti::isType< SpriteAtlasAsset >( asset ) )
+            return;
+        SpriteAtlasAsset* a = (SpriteAtlasAsset*)asset;
+        if( !a->isPacked() )
+            return;
+        for( unsigned int i = 0; i < a->getPagesCount(); i++ )
+            freeTexture( a->getPage( i ) );
+    }
+
     void Assets::freeAllTextures()
     {
+        m_textureRegions.clear();
         for( std::map< std::string, sf::Texture* >::iterator it = m_textures.begin(); it != m_textures.end(); it++ )
         {
             if( m_assetsChangedListener )
@@ -1178,6 +1351,7 @@ namespace Ptakopysk
         }
         m_textures.clear();
         m_metaTextures.clear();
+        m_sizesTextures.clear();
         m_tagsTextures.clear();
     }
 
@@ -1230,6 +1404,7 @@ namespace Ptakopysk
         {
             if( m_assetsChangedListener )
                 m_assetsChangedListener->onFontChanged( it->first, it->second, false );
+            GlyphRunCache::removeFontFromAll( it->second );
             DELETE_OBJECT( it->second );
         }
         m_fonts.clear();
@@ -1243,11 +1418,13 @@ namespace Ptakopysk
         {
             if( m_assetsChangedListener )
                 m_assetsChangedListener->onCustomAssetChanged( it->first, it->second, false );
+            freeAtlasPages( it->second );
             DELETE_OBJECT( it->second );
         }
         m_custom.clear();
         m_metaCustom.clear();
         m_tagsCustom.clear();
+        m_metaAtlases.clear();
     }
 
     void Assets::freeAll()
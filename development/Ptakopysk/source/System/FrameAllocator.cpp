@@ -0,0 +1,111 @@
+#include "../../include/Ptakopysk/System/FrameAllocator.h"
+#include <XeCore/Common/Logger.h>
+
+namespace Ptakopysk
+{
+
+    RTTI_CLASS_DERIVATIONS( FrameAllocator,
+                            RTTI_DERIVATIONS_END
+                            )
+
+    FrameAllocator::FrameAllocator( unsigned int capacity )
+    : RTTI_CLASS_DEFINE( FrameAllocator )
+    , m_buffer( 0 )
+    , m_capacity( 0 )
+    , m_used( 0 )
+    , m_lastFrameUsed( 0 )
+    , m_peakUsed( 0 )
+    , m_framesCount( 0 )
+    , m_overflowsCount( 0 )
+    , m_overflowBytes( 0 )
+    {
+        reserve( capacity );
+    }
+
+    FrameAllocator::~FrameAllocator()
+    {
+        for( std::vector< void* >::iterator it = m_overflows.begin(); it != m_overflows.end(); it++ )
+            ::operator delete( *it );
+        m_overflows.clear();
+        if( m_buffer )
+            ::operator delete( m_buffer );
+    }
+
+    void* FrameAllocator::allocate( unsigned int size, unsigned int alignment )
+    {
+        if( !size )
+            size = 1;
+        if( !alignment || ( alignment & ( alignment - 1 ) ) )
+            alignment = DEFAULT_ALIGNMENT;
+        unsigned int padding = (unsigned int)( ( alignment - ( (std::size_t)( m_buffer + m_used ) & ( alignment - 1 ) ) ) & ( alignment - 1 ) );
+        if( m_buffer && m_used + padding + size <= m_capacity )
+        {
+            void* p = m_buffer + m_used + padding;
+            m_used += padding + size;
+            return p;
+        }
+        void* p = ::operator new( size );
+        m_overflows.push_back( p );
+        m_overflowsCount++;
+        m_overflowBytes += size;
+        return p;
+    }
+
+    void FrameAllocator::deallocate( void* ptr, unsigned int size )
+    {
+        if( ptr && owns( ptr ) && (unsigned char*)ptr + size == m_buffer + m_used )
+            m_used = (unsigned char*)ptr - m_buffer;
+    }
+
+    void FrameAllocator::rewind( unsigned int marker )
+    {
+        if( marker < m_used )
+            m_used = marker;
+    }
+
+    void FrameAllocator::reset()
+    {
+        unsigned int used = getUsed();
+        m_lastFrameUsed = used;
+        if( used > m_peakUsed )
+            m_peakUsed = used;
+        for( std::vector< void* >::iterator it = m_overflows.begin(); it != m_overflows.end(); it++ )
+            ::operator delete( *it );
+        m_overflows.clear();
+        m_used = 0;
+        m_framesCount++;
+        if( m_overflowBytes )
+        {
+            m_overflowBytes = 0;
+            reserve( used + used / 2 );
+        }
+    }
+
+    void FrameAllocator::reserve( unsigned int capacity )
+    {
+        if( capacity <= m_capacity )
+            return;
+        if( m_used )
+        {
+            XWARNING( "Cannot reserve frame allocator memory while it is in use!" );
+            return;
+        }
+        if( m_buffer )
+            ::operator delete( m_buffer );
+        m_buffer = (unsigned char*)::operator new( capacity );
+        m_capacity = capacity;
+    }
+
+    Json::Value FrameAllocator::statsToJson()
+    {
+        Json::Value root;
+        root[ "capacity" ] = Json::Value( m_capacity );
+        root[ "used" ] = Json::Value( getUsed() );
+        root[ "lastFrameUsed" ] = Json::Value( m_lastFrameUsed );
+        root[ "peakUsed" ] = Json::Value( m_peakUsed );
+        root[ "overflows" ] = Json::Value( m_overflowsCount );
+        root[ "frames" ] = Json::Value( m_framesCount );
+        return root;
+    }
+
+}
@@ -2,6 +2,14 @@
 #include "../../include/Ptakopysk/System/Assets.h"
 #include "../../include/Ptakopysk/System/Events.h"
 #include "../../include/Ptakopysk/System/Tween.h"
+#include "../../include/Ptakopysk/System/RenderSnapshot.h"
+#include "../../include/Ptakopysk/System/StateBuffer.h"
+#include "../../include/Ptakopysk/System/Profiler.h"
+#include "../../include/Ptakopysk/System/Allocations.h"
+#include "../../include/Ptakopysk/System/SpriteBatch.h"
+#include "../../include/Ptakopysk/System/SpatialGrid.h"
+#include "../../include/Ptakopysk/System/RenderQueue.h"
+#include "../../include/Ptakopysk/System/GlyphRunCache.h"
 #include "../../include/Ptakopysk/Components/Body.h"
 #include "../../include/Ptakopysk/Components/Camera.h"
 #include "../../include/Ptakopysk/Components/RevoluteJoint.h"
@@ -15,9 +23,11 @@
 #include "../../include/Ptakopysk/Serialization/StyleSerializer.h"
 #include "../../include/Ptakopysk/Serialization/TransformModeSerializer.h"
 #include <XeCore/Common/Logger.h>
-#include <XeCore/Common/Concurrent/Thread.h>
-#include <XeCore/Common/Timer.h>
+#include <SFML/System/Sleep.hpp>
 #include <Box2D/Box2D.h>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
 
 namespace Ptakopysk
 {
@@ -162,12 +172,121 @@ namespace Ptakopysk
     {
     }
 
+    class ParallelUpdateJob
+        : public IParallelForJob
+    {
+    public:
+        ParallelUpdateJob( GameManager* owner ) : m_owner( owner ) {};
+
+    protected:
+        void onExecute( unsigned int from, unsigned int to ) { m_owner->processParallelUpdate( from, to ); };
+
+    private:
+        GameManager* m_owner;
+    };
+
+    class RenderThread
+        : public virtual XeCore::Common::IRtti
+        , public virtual XeCore::Common::MemoryManager::Manageable
+        , public XeCore::Common::Concurrent::Thread
+    {
+        RTTI_CLASS_DECLARE( RenderThread );
+
+    public:
+        RenderThread( sf::RenderWindow* window );
+        virtual ~RenderThread() {};
+
+        void submit( RenderSnapshot* snapshot );
+        void wait();
+        void stop();
+
+    private:
+        virtual void run();
+
+        sf::RenderWindow* m_window;
+        RenderSnapshot* m_snapshot;
+        bool m_working;
+        tthread::mutex m_mutex;
+        tthread::condition_variable m_condition;
+    };
+
+    RTTI_CLASS_DERIVATIONS( RenderThread,
+                            RTTI_DERIVATION( XeCore::Common::Concurrent::Thread ),
+                            RTTI_DERIVATIONS_END
+                            );
+
+    RenderThread::RenderThread( sf::RenderWindow* window )
+    : RTTI_CLASS_DEFINE( RenderThread )
+    , m_window( window )
+    , m_snapshot( 0 )
+    , m_working( true )
+    {
+    }
+
+    void RenderThread::submit( RenderSnapshot* snapshot )
+    {
+        tthread::lock_guard< tthread::mutex > guard( m_mutex );
+        while( m_snapshot )
+            m_condition.wait( m_mutex );
+        m_snapshot = snapshot;
+        m_condition.notify_all();
+    }
+
+    void RenderThread::wait()
+    {
+        tthread::lock_guard< tthread::mutex > guard( m_mutex );
+        while( m_snapshot )
+            m_condition.wait( m_mutex );
+    }
+
+    void RenderThread::stop()
+    {
+        m_mutex.lock();
+        m_working = false;
+        m_condition.notify_all();
+        m_mutex.unlock();
+        join();
+    }
+
+    void RenderThread::run()
+    {
+        ALLOCATIONS_SCOPE( sRender );
+        m_window->setActive( true );
+        RenderSnapshot* snapshot;
+        while( true )
+        {
+            {
+                tthread::lock_guard< tthread::mutex > guard( m_mutex );
+                while( m_working && !m_snapshot )
+                    m_condition.wait( m_mutex );
+                if( !m_snapshot )
+                    break;
+                snapshot = m_snapshot;
+            }
+            m_window->clear( snapshot->getClearColor() );
+            {
+                tthread::lock_guard< tthread::mutex > fontsGuard( GlyphRunCache::fontsMutex() );
+                snapshot->render( m_window );
+            }
+            m_window->display();
+            tthread::lock_guard< tthread::mutex > guard( m_mutex );
+            m_snapshot = 0;
+            m_condition.notify_all();
+        }
+        m_window->setActive( false );
+    }
+
     RTTI_CLASS_DERIVATIONS( GameManager,
                             RTTI_DERIVATIONS_END
                             );
 
-    std::map< std::string, GameManager::ComponentFactoryData > GameManager::s_componentsFactory = std::map< std::string, GameManager::ComponentFactoryData >();
+    GameManager::ComponentsFactory GameManager::s_componentsFactory = GameManager::ComponentsFactory();
     bool GameManager::s_editMode = false;
+    std::vector< GameObject* > GameManager::s_gameObjectsRecycled = std::vector< GameObject* >();
+    std::map< XeCore::Common::IRtti::Derivation, std::vector< Component* > > GameManager::s_componentsRecycled = std::map< XeCore::Common::IRtti::Derivation, std::vector< Component* > >();
+    unsigned int GameManager::s_gameObjectsRecycleLimit = 0;
+    unsigned int GameManager::s_componentsRecycleLimit = 0;
+    std::vector< RenderThread* > GameManager::s_renderThreads = std::vector< RenderThread* >();
 
     GameManager::GameManager( const Json::Value& config )
     : RTTI_CLASS_DEFINE( GameManager )
@@ -176,8 +295,46 @@ namespace Ptakopysk
     , m_renderWindow( 0 )
     , m_bgColor( sf::Color::Black )
     , m_fixedStep( 0.0f )
+    , m_targetFrameStep( 0.0f )
+    , m_maxSubSteps( DEFAULT_MAX_SUB_STEPS )
+    , m_interpolating( false )
+    , m_interpolationAlpha( 1.0f )
+    , m_fixedStepAccum( 0.0f )
+    , m_deterministic( false )
+    , m_headless( false )
+    , m_headlessRealTime( true )
+    , m_running( false )
+    , m_maxSteps( 0 )
+    , m_stepsCount( 0 )
+    , m_jobsWorkers( 0 )
+    , m_frameAllocatorCapacity( FrameAllocator::DEFAULT_CAPACITY )
+    , m_parallelUpdate( false )
+    , m_parallelUpdateBatch( 0 )
+    , m_parallelUpdateDt( 0.0f )
+    , m_pipelined( false )
+    , m_renderThread( 0 )
+    , m_renderSnapshotIndex( 0 )
+    , m_spriteBatching( false )
+    , m_renderSorting( false )
+    , m_renderCulling( false )
+    , m_renderCullingCellSize( (float)DEFAULT_RENDER_CULLING_CELL_SIZE )
+    , m_spatialGrid( 0 )
+    , m_componentsPooling( false )
+    , m_componentsPoolsSweeping( false )
+    , m_componentsPoolsDirty( false )
+    , m_updateFrame( 0 )
+    , m_gameObjectsOrderDirty( false )
     {
         setupFromConfig( config );
+        m_renderSnapshots[ 0 ] = 0;
+        m_renderSnapshots[ 1 ] = 0;
+        m_jobs = xnew Jobs( m_jobsWorkers );
+        m_frameAllocator = xnew FrameAllocator( m_frameAllocatorCapacity );
+        m_spriteBatch = xnew SpriteBatch();
+        m_glyphRunCache = xnew GlyphRunCache();
+        m_renderQueue = xnew RenderQueue();
+        if( m_renderCulling )
+            m_spatialGrid = xnew SpatialGrid( m_renderCullingCellSize );
         m_world = xnew b2World( b2Vec2( 0.0f, 0.0f ) );
         m_destructionListener = xnew DestructionListener( this );
         m_world->SetDestructionListener( m_destructionListener );
@@ -191,6 +348,7 @@ namespace Ptakopysk
     {
         Assets::use().setAssetsChangedListener( 0 );
         DELETE_OBJECT( m_assetsListener );
+        m_jobs->wait( &m_frameFence );
         removeScene();
         processRemoving();
         GameObject* go;
@@ -200,6 +358,27 @@ namespace Ptakopysk
             DELETE_OBJECT( go );
         }
         m_gameObjectsToCreate.clear();
+        for( std::vector< HandleSlot >::iterator it = m_handleSlots.begin(); it != m_handleSlots.end(); it++ )
+        {
+            if( it->object && it->object->m_handleOwner == this )
+            {
+                it->object->m_handle = 0;
+                it->object->m_handleOwner = 0;
+            }
+        }
+        m_handleSlots.clear();
+        m_handleFreeSlots.clear();
+        for( std::vector< Transform* >::iterator it = m_interpolatedTransforms.begin(); it != m_interpolatedTransforms.end(); it++ )
+            (*it)->m_interpolationOwner = 0;
+        m_interpolatedTransforms.clear();
+        DELETE_OBJECT( m_jobs );
+        DELETE_OBJECT( m_frameAllocator );
+        DELETE_OBJECT( m_spriteBatch );
+        DELETE_OBJECT( m_glyphRunCache );
+        DELETE_OBJECT( m_renderQueue );
+        setRenderCulling( false );
+        DELETE_OBJECT( m_renderSnapshots[ 0 ] );
+        DELETE_OBJECT( m_renderSnapshots[ 1 ] );
         DELETE_OBJECT( m_world );
         DELETE_OBJECT( m_destructionListener );
         DELETE_OBJECT( m_contactListener );
@@ -226,53 +405,31 @@ namespace Ptakopysk
     {
         Serialized::unregisterAllCustomSerializers();
         unregisterAllComponentFactories();
+        releaseRecycled();
+        GameObject::releaseRetiredComponentTypeSlots();
     }
 
     bool GameManager::registerComponentFactory( const std::string& id, XeCore::Common::IRtti::Derivation type, Component::OnBuildComponentCallback builder )
     {
-        if( id.empty() || s_componentsFactory.count( id ) || !type || !builder )
+        if( !s_componentsFactory.add( id, type, builder ) )
             return false;
-        ComponentFactoryData d;
-        d.type = type;
-        d.builder = builder;
-        s_componentsFactory[ id ] = d;
+        GameObject::componentTypeSlot( type );
         return true;
     }
 
     bool GameManager::unregisterComponentFactory( const std::string& id )
     {
-        if( s_componentsFactory.count( id ) )
-        {
-            s_componentsFactory.erase( id );
-            return true;
-        }
-        return false;
+        return s_componentsFactory.removeById( id );
     }
 
     bool GameManager::unregisterComponentFactory( XeCore::Common::IRtti::Derivation type )
     {
-        for( std::map< std::string, ComponentFactoryData >::iterator it = s_componentsFactory.begin(); it != s_componentsFactory.end(); it++ )
-        {
-            if( it->second.type == type )
-            {
-                s_componentsFactory.erase( it );
-                return true;
-            }
-        }
-        return false;
+        return s_componentsFactory.removeByType( type );
     }
 
     bool GameManager::unregisterComponentFactory( Component::OnBuildComponentCallback builder )
     {
-        for( std::map< std::string, ComponentFactoryData >::iterator it = s_componentsFactory.begin(); it != s_componentsFactory.end(); it++ )
-        {
-            if( it->second.builder == builder )
-            {
-                s_componentsFactory.erase( it );
-                return true;
-            }
-        }
-        return false;
+        return s_componentsFactory.removeByBuilder( builder );
     }
 
     void GameManager::unregisterAllComponentFactories()
@@ -282,69 +439,131 @@ namespace Ptakopysk
 
     XeCore::Common::IRtti::Derivation GameManager::findComponentFactoryTypeById( const std::string& id )
     {
-        if( s_componentsFactory.count( id ) )
-            return s_componentsFactory[ id ].type;
-        return 0;
+        const ComponentsFactory::Entry* e = s_componentsFactory.findById( id );
+        return e ? e->type : 0;
     }
 
     XeCore::Common::IRtti::Derivation GameManager::findComponentFactoryTypeByBuilder( Component::OnBuildComponentCallback builder )
     {
-        for( std::map< std::string, ComponentFactoryData >::iterator it = s_componentsFactory.begin(); it != s_componentsFactory.end(); it++ )
-            if( it->second.builder == builder )
-                return it->second.type;
-        return 0;
+        const ComponentsFactory::Entry* e = s_componentsFactory.findByBuilder( builder );
+        return e ? e->type : 0;
     }
 
     std::string GameManager::findComponentFactoryIdByType( XeCore::Common::IRtti::Derivation type )
     {
-        for( std::map< std::string, ComponentFactoryData >::iterator it = s_componentsFactory.begin(); it != s_componentsFactory.end(); it++ )
-            if( it->second.type == type )
-                return it->first;
-        return std::string();
+        const ComponentsFactory::Entry* e = s_componentsFactory.findByType( type );
+        return e ? e->id : std::string();
     }
 
     std::string GameManager::findComponentFactoryIdByBuilder( Component::OnBuildComponentCallback builder )
     {
-        for( std::map< std::string, ComponentFactoryData >::iterator it = s_componentsFactory.begin(); it != s_componentsFactory.end(); it++ )
-            if( it->second.builder == builder )
-                return it->first;
-        return std::string();
+        const ComponentsFactory::Entry* e = s_componentsFactory.findByBuilder( builder );
+        return e ? e->id : std::string();
     }
 
     Component::OnBuildComponentCallback GameManager::findComponentFactoryBuilderById( const std::string& id )
     {
-        if( s_componentsFactory.count( id ) )
-            return s_componentsFactory[ id ].builder;
-        return 0;
+        const ComponentsFactory::Entry* e = s_componentsFactory.findById( id );
+        return e ? e->builder : 0;
     }
 
     Component::OnBuildComponentCallback GameManager::findComponentFactoryBuilderByType( XeCore::Common::IRtti::Derivation type )
     {
-        for( std::map< std::string, ComponentFactoryData >::iterator it = s_componentsFactory.begin(); it != s_componentsFactory.end(); it++ )
-            if( it->second.type == type )
-                return it->second.builder;
-        return 0;
+        const ComponentsFactory::Entry* e = s_componentsFactory.findByType( type );
+        return e ? e->builder : 0;
     }
 
     Component* GameManager::buildComponent( const std::string& id )
     {
-        if( s_componentsFactory.count( id ) )
-            return s_componentsFactory[ id ].builder();
-        return 0;
+        const ComponentsFactory::Entry* e = s_componentsFactory.findById( id );
+        if( !e )
+            return 0;
+        Component* c = reuseComponent( e->type );
+        return c ? c : e->builder();
     }
 
     Component* GameManager::buildComponent( XeCore::Common::IRtti::Derivation type )
     {
-        for( std::map< std::string, ComponentFactoryData >::iterator it = s_componentsFactory.begin(); it != s_componentsFactory.end(); it++ )
-            if( it->second.type == type )
-                return it->second.builder();
-        return 0;
+        Component* c = reuseComponent( type );
+        if( c )
+            return c;
+        const ComponentsFactory::Entry* e = s_componentsFactory.findByType( type );
+        return e ? e->builder() : 0;
+    }
+
+    GameObject* GameManager::buildGameObject()
+    {
+        if( s_gameObjectsRecycled.empty() )
+            return xnew GameObject();
+        GameObject* go = s_gameObjectsRecycled.back();
+        s_gameObjectsRecycled.pop_back();
+        return go;
+    }
+
+    void GameManager::recycleGameObject( GameObject* go )
+    {
+        if( !go )
+            return;
+        if( s_gameObjectsRecycled.size() < s_gameObjectsRecycleLimit && go->getType() == RTTI_CLASS_TYPE( GameObject ) )
+        {
+            go->reset();
+            s_gameObjectsRecycled.push_back( go );
+        }
+        else
+            DELETE_OBJECT( go );
+    }
+
+    void GameManager::recycleComponent( Component* c )
+    {
+        if( !c )
+            return;
+        if( s_componentsRecycleLimit )
+        {
+            std::vector< Component* >& pool = s_componentsRecycled[ c->getType() ];
+            if( pool.size() < s_componentsRecycleLimit && c->recycle() )
+            {
+                pool.push_back( c );
+                return;
+            }
+        }
+        DELETE_OBJECT( c );
+    }
+
+    void GameManager::releaseRecycled()
+    {
+        GameObject* go;
+        for( std::vector< GameObject* >::iterator it = s_gameObjectsRecycled.begin(); it != s_gameObjectsRecycled.end(); it++ )
+        {
+            go = *it;
+            DELETE_OBJECT( go );
+        }
+        s_gameObjectsRecycled.clear();
+        Component* c;
+        for( std::map< XeCore::Common::IRtti::Derivation, std::vector< Component* > >::iterator it = s_componentsRecycled.begin(); it != s_componentsRecycled.end(); it++ )
+        {
+            for( std::vector< Component* >::iterator itc = it->second.begin(); itc != it->second.end(); itc++ )
+            {
+                c = *itc;
+                DELETE_OBJECT( c );
+            }
+        }
+        s_componentsRecycled.clear();
+    }
+
+    Component* GameManager::reuseComponent( XeCore::Common::IRtti::Derivation type )
+    {
+        std::map< XeCore::Common::IRtti::Derivation, std::vector< Component* > >::iterator it = s_componentsRecycled.find( type );
+        if( it == s_componentsRecycled.end() || it->second.empty() )
+            return 0;
+        Component* c = it->second.back();
+        it->second.pop_back();
+        return c;
     }
 
     unsigned int GameManager::getComponentsIds( std::vector< std::string >& result )
     {
         result.clear();
-        for( std::map< std::string, ComponentFactoryData >::iterator it = s_componentsFactory.begin(); it != s_componentsFactory.end(); it++ )
+        for( ComponentsFactory::EntriesById::const_iterator it = s_componentsFactory.getEntries().begin(); it != s_componentsFactory.getEntries().end(); it++ )
             result.push_back( it->first );
         return result.size();
     }
@@ -352,7 +571,7 @@ namespace Ptakopysk
     unsigned int GameManager::getComponentsTypes( std::vector< XeCore::Common::IRtti::Derivation >& result )
     {
         result.clear();
-        for( std::map< std::string, ComponentFactoryData >::iterator it = s_componentsFactory.begin(); it != s_componentsFactory.end(); it++ )
+        for( ComponentsFactory::EntriesById::const_iterator it = s_componentsFactory.getEntries().begin(); it != s_componentsFactory.getEntries().end(); it++ )
             result.push_back( it->second.type );
         return result.size();
     }
@@ -360,7 +579,7 @@ namespace Ptakopysk
     unsigned int GameManager::getComponentsBuilders( std::vector< Component::OnBuildComponentCallback >& result )
     {
         result.clear();
-        for( std::map< std::string, ComponentFactoryData >::iterator it = s_componentsFactory.begin(); it != s_componentsFactory.end(); it++ )
+        for( ComponentsFactory::EntriesById::const_iterator it = s_componentsFactory.getEntries().begin(); it != s_componentsFactory.getEntries().end(); it++ )
             result.push_back( it->second.builder );
         return result.size();
     }
@@ -378,6 +597,7 @@ namespace Ptakopysk
 
     void GameManager::jsonToScene( const Json::Value& root, SceneContentType contentFlags )
     {
+        ALLOCATIONS_SCOPE( sScene );
         if( contentFlags == GameManager::None || !root.isObject() )
             return;
         Json::Value physics = root[ "physics" ];
@@ -416,6 +636,7 @@ namespace Ptakopysk
 
     void GameManager::jsonToGameObjects( const Json::Value& root, bool prefab )
     {
+        ALLOCATIONS_SCOPE( sScene );
         if( !root.isArray() )
             return;
         Json::Value item;
@@ -435,7 +656,7 @@ namespace Ptakopysk
             }
             else
             {
-                GameObject* go = xnew GameObject();
+                GameObject* go = buildGameObject();
                 addGameObject( go, prefab );
                 go->fromJson( item );
             }
@@ -515,14 +736,312 @@ namespace Ptakopysk
             Assets::use().freeAll();
     }
 
+    void GameManager::snapshot( StateBuffer& state )
+    {
+        state.clear();
+        state.write( STATE_SIGNATURE );
+        state.write( STATE_VERSION );
+        state.write( m_stepsCount );
+        state.write( m_fixedStepAccum );
+        state.write( m_world->GetGravity() );
+        saveGameObjectsState( state, m_gameObjects );
+        Tweener::use().saveState( state );
+    }
+
+    bool GameManager::restore( StateBuffer& state )
+    {
+        state.rewind();
+        unsigned int signature = 0;
+        unsigned int version = 0;
+        unsigned int stepsCount = 0;
+        float fixedStepAccum = 0.0f;
+        b2Vec2 gravity;
+        state.read( signature );
+        state.read( version );
+        state.read( stepsCount );
+        state.read( fixedStepAccum );
+        state.read( gravity );
+        if( !state.isValid() || signature != STATE_SIGNATURE || version != STATE_VERSION )
+        {
+            XWARNING( "Cannot restore state: invalid state buffer!" );
+            return false;
+        }
+        processPending();
+        unsigned int position = state.getPosition();
+        if( !validateGameObjectsStructure( state, m_gameObjects ) )
+        {
+            XWARNING( "Cannot restore state: game objects structure does not match!" );
+            return false;
+        }
+        if( !Tweener::use().skipState( state ) )
+        {
+            XWARNING( "Cannot restore state: corrupted state buffer!" );
+            return false;
+        }
+        state.setPosition( position );
+        if( !restoreGameObjectsStructure( state, 0 ) )
+        {
+            XWARNING( "Cannot restore state: game objects structure does not match!" );
+            return false;
+        }
+        state.setPosition( position );
+        restoreGameObjectsState( state, m_gameObjects );
+        if( !Tweener::use().loadState( state ) || !state.isValid() )
+        {
+            XWARNING( "Cannot restore state: corrupted state buffer!" );
+            return false;
+        }
+        m_stepsCount = stepsCount;
+        m_fixedStepAccum = fixedStepAccum;
+        m_world->SetGravity( gravity );
+        return true;
+    }
+
+    void GameManager::saveGameObjectsState( StateBuffer& state, GameObject::List& list )
+    {
+        state.write( (unsigned int)list.size() );
+        GameObject* go;
+        unsigned int block;
+        unsigned int componentBlock;
+        for( GameObject::List::iterator it = list.begin(); it != list.end(); it++ )
+        {
+            go = *it;
+            state.write( go->m_id );
+            state.write( go->m_instanceOf ? go->m_instanceOf->m_id : std::string() );
+            block = state.beginBlock();
+            state.write( go->m_active );
+            state.write( go->m_order );
+            state.write( (unsigned int)go->m_components.size() );
+            for( GameObject::Components::iterator itc = go->m_components.begin(); itc != go->m_components.end(); itc++ )
+            {
+                state.write( itc->second->m_active );
+                componentBlock = state.beginBlock();
+                itc->second->onSaveState( state );
+                state.endBlock( componentBlock );
+            }
+            saveGameObjectsState( state, go->m_gameObjects );
+            state.endBlock( block );
+        }
+    }
+
+    bool GameManager::validateGameObjectsStructure( StateBuffer& state, GameObject::List& list )
+    {
+        unsigned int count = 0;
+        if( !state.read( count ) )
+            return false;
+        std::multimap< std::string, GameObject* > existing;
+        for( GameObject::List::iterator it = list.begin(); it != list.end(); it++ )
+            existing.insert( std::make_pair( (*it)->m_id, *it ) );
+        std::vector< GameObject* > sources;
+        std::vector< unsigned int > children;
+        sources.reserve( count );
+        children.reserve( count );
+        std::string id;
+        std::string prefab;
+        unsigned int size = 0;
+        unsigned int end;
+        GameObject* go;
+        for( unsigned int i = 0; i < count; i++ )
+        {
+            if( !state.read( id ) || !state.read( prefab ) || !state.read( size ) )
+                return false;
+            end = state.getPosition() + size;
+            if( end > state.size() )
+                return false;
+            std::multimap< std::string, GameObject* >::iterator found = existing.lower_bound( id );
+            if( found != existing.end() && found->first == id )
+            {
+                go = found->second;
+                existing.erase( found );
+            }
+            else
+            {
+                go = prefab.empty() ? 0 : getGameObject( prefab, true );
+                if( !go )
+                {
+                    std::stringstream ss;
+                    ss << "Cannot recreate game object '" << id.c_str() << "' without prefab!";
+                    XWARNING( ss.str().c_str() );
+                    return false;
+                }
+            }
+            sources.push_back( go );
+            if( !state.skip( sizeof( bool ) + sizeof( int ) ) || !skipComponentsState( state ) )
+                return false;
+            children.push_back( state.getPosition() );
+            state.setPosition( end );
+        }
+        end = state.getPosition();
+        for( unsigned int i = 0; i < count; i++ )
+        {
+            state.setPosition( children[ i ] );
+            if( !validateGameObjectsStructure( state, sources[ i ]->m_gameObjects ) )
+                return false;
+        }
+        state.setPosition( end );
+        return true;
+    }
+
+    bool GameManager::restoreGameObjectsStructure( StateBuffer& state, GameObject* parent )
+    {
+        GameObject::List& list = parent ? parent->m_gameObjects : m_gameObjects;
+        unsigned int count = 0;
+        if( !state.read( count ) )
+            return false;
+        std::multimap< std::string, GameObject* > existing;
+        for( GameObject::List::iterator it = list.begin(); it != list.end(); it++ )
+            existing.insert( std::make_pair( (*it)->m_id, *it ) );
+        std::vector< GameObject* > ordered;
+        std::vector< unsigned int > children;
+        ordered.reserve( count );
+        children.reserve( count );
+        std::string id;
+        std::string prefab;
+        unsigned int size = 0;
+        unsigned int end;
+        GameObject* go;
+        for( unsigned int i = 0; i < count; i++ )
+        {
+            if( !state.read( id ) || !state.read( prefab ) || !state.read( size ) )
+                return false;
+            end = state.getPosition() + size;
+            if( end > state.size() )
+                return false;
+            std::multimap< std::string, GameObject* >::iterator found = existing.lower_bound( id );
+            if( found != existing.end() && found->first == id )
+            {
+                go = found->second;
+                existing.erase( found );
+            }
+            else
+            {
+                go = prefab.empty() ? 0 : instantiatePrefab( prefab );
+                if( !go )
+                {
+                    std::stringstream ss;
+                    ss << "Cannot recreate game object '" << id.c_str() << "' without prefab!";
+                    XWARNING( ss.str().c_str() );
+                    return false;
+                }
+                go->setId( id );
+                if( parent )
+                    parent->addGameObject( go );
+                else
+                    addGameObject( go );
+            }
+            ordered.push_back( go );
+            if( !state.skip( sizeof( bool ) + sizeof( int ) ) || !skipComponentsState( state ) )
+                return false;
+            children.push_back( state.getPosition() );
+            state.setPosition( end );
+        }
+        for( std::multimap< std::string, GameObject* >::iterator it = existing.begin(); it != existing.end(); it++ )
+        {
+            if( parent )
+                parent->removeGameObject( it->second );
+            else
+                removeGameObject( it->second );
+        }
+        if( parent )
+        {
+            parent->processAdding();
+            parent->processRemoving();
+        }
+        else
+        {
+            processAdding();
+            processRemoving();
+        }
+        list.assign( ordered.begin(), ordered.end() );
+        end = state.getPosition();
+        for( unsigned int i = 0; i < count; i++ )
+        {
+            state.setPosition( children[ i ] );
+            if( !restoreGameObjectsStructure( state, ordered[ i ] ) )
+                return false;
+        }
+        state.setPosition( end );
+        return true;
+    }
+
+    void GameManager::restoreGameObjectsState( StateBuffer& state, GameObject::List& list )
+    {
+        unsigned int count = 0;
+        state.read( count );
+        std::string id;
+        std::string prefab;
+        unsigned int size = 0;
+        unsigned int end;
+        bool active = false;
+        int order = 0;
+        unsigned int components = 0;
+        GameObject* go;
+        Component* c;
+        GameObject::List::iterator it = list.begin();
+        for( unsigned int i = 0; i < count && it != list.end() && state.isValid(); i++, it++ )
+        {
+            go = *it;
+            state.read( id );
+            state.read( prefab );
+            state.read( size );
+            end = state.getPosition() + size;
+            state.read( active );
+            state.read( order );
+            state.read( components );
+            go->setActive( active );
+            go->setOrder( order );
+            if( components == go->m_components.size() )
+            {
+                for( GameObject::Components::iterator itc = go->m_components.begin(); itc != go->m_components.end(); itc++ )
+                {
+                    c = itc->second;
+                    state.read( active );
+                    state.read( size );
+                    size += state.getPosition();
+                    c->setActive( active );
+                    c->onLoadState( state );
+                    state.setPosition( size );
+                }
+            }
+            else
+            {
+                std::stringstream ss;
+                ss << "Components of game object '" << id.c_str() << "' do not match saved state!";
+                XWARNING( ss.str().c_str() );
+                for( unsigned int j = 0; j < components; j++ )
+                {
+                    state.skip( sizeof( bool ) );
+                    state.read( size );
+                    state.skip( size );
+                }
+            }
+            restoreGameObjectsState( state, go->m_gameObjects );
+            state.setPosition( end );
+        }
+    }
+
+    bool GameManager::skipComponentsState( StateBuffer& state )
+    {
+        unsigned int count = 0;
+        unsigned int size = 0;
+        if( !state.read( count ) )
+            return false;
+        for( unsigned int i = 0; i < count; i++ )
+            if( !state.skip( sizeof( bool ) ) || !state.read( size ) || !state.skip( size ) )
+                return false;
+        return true;
+    }
+
     void GameManager::addGameObject( GameObject* go, bool prefab )
     {
-        if( !go || go->getType() != RTTI_CLASS_TYPE( GameObject ) || hasGameObject( go ) || isWaitingToAdd( go ) )
+        if( !go || go->getType() != RTTI_CLASS_TYPE( GameObject ) || go->m_membership != GameObject::msNone )
             return;
         if( prefab )
         {
             go->setGameManager( this );
             m_prefabGameObjects.push_back( go );
+            go->m_membership = GameObject::msAdded;
+            GameObject::indexGameObject( m_prefabGameObjectsIndex, go );
             go->setPrefab( prefab );
             go->setDestroying( false );
             go->processAdding();
@@ -530,6 +1049,7 @@ namespace Ptakopysk
         else
         {
             m_gameObjectsToCreate.push_back( go );
+            go->m_membership = GameObject::msWaitingToAdd;
             go->setGameManager( this );
             go->setPrefab( prefab );
             go->setDestroying( false );
@@ -538,11 +1058,13 @@ namespace Ptakopysk
 
     void GameManager::removeGameObject( GameObject* go, bool prefab )
     {
-        if( !hasGameObject( go, prefab ) )
+        if( !hasGameObject( go, prefab ) || go->m_membership == GameObject::msWaitingToRemove )
             return;
         if( prefab )
         {
             m_prefabGameObjects.remove( go );
+            GameObject::unindexGameObject( m_prefabGameObjectsIndex, go );
+            m_prefabTemplates.erase( go );
             go->processRemoving();
             go->setGameManager( 0 );
             go->setPrefab( false );
@@ -551,6 +1073,7 @@ namespace Ptakopysk
         else
         {
             m_gameObjectsToDestroy.push_back( go );
+            go->m_membership = GameObject::msWaitingToRemove;
             go->setDestroying( true );
             go->onDestroy();
         }
@@ -559,11 +1082,13 @@ namespace Ptakopysk
     void GameManager::removeGameObject( const std::string& id, bool prefab )
     {
         GameObject* go = getGameObject( id, prefab );
-        if( !go )
+        if( !go || go->m_membership == GameObject::msWaitingToRemove )
             return;
         if( prefab )
         {
             m_prefabGameObjects.remove( go );
+            GameObject::unindexGameObject( m_prefabGameObjectsIndex, go );
+            m_prefabTemplates.erase( go );
             go->processRemoving();
             go->setGameManager( 0 );
             go->setPrefab( false );
@@ -572,6 +1097,7 @@ namespace Ptakopysk
         else
         {
             m_gameObjectsToDestroy.push_back( go );
+            go->m_membership = GameObject::msWaitingToRemove;
             go->setDestroying( true );
             go->onDestroy();
         }
@@ -591,13 +1117,18 @@ namespace Ptakopysk
                 DELETE_OBJECT( go );
             }
             m_prefabGameObjects.clear();
+            m_prefabGameObjectsIndex.clear();
+            m_prefabTemplates.clear();
         }
         else
         {
             for( GameObject::List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
             {
                 go = *it;
+                if( go->m_membership == GameObject::msWaitingToRemove )
+                    continue;
                 m_gameObjectsToDestroy.push_back( go );
+                go->m_membership = GameObject::msWaitingToRemove;
                 go->setDestroying( true );
                 go->onDestroy();
             }
@@ -606,20 +1137,12 @@ namespace Ptakopysk
 
     bool GameManager::hasGameObject( GameObject* go, bool prefab )
     {
-        GameObject::List& cgo = prefab ? m_prefabGameObjects : m_gameObjects;
-        for( GameObject::List::iterator it = cgo.begin(); it != cgo.end(); it++ )
-            if( *it == go )
-                return true;
-        return false;
+        return go && go->getGameManager() == this && go->isPrefab() == prefab && go->isAddedTo( 0 );
     }
 
     bool GameManager::hasGameObject( const std::string& id, bool prefab )
     {
-        GameObject::List& cgo = prefab ? m_prefabGameObjects : m_gameObjects;
-        for( GameObject::List::iterator it = cgo.begin(); it != cgo.end(); it++ )
-            if( (*it)->getId() == id )
-                return true;
-        return false;
+        return getGameObject( id, prefab ) != 0;
     }
 
     bool GameManager::containsGameObject( GameObject* go, bool prefab )
@@ -633,47 +1156,22 @@ namespace Ptakopysk
 
     GameObject* GameManager::getGameObject( const std::string& id, bool prefab )
     {
-        GameObject::List& cgo = prefab ? m_prefabGameObjects : m_gameObjects;
-        for( GameObject::List::iterator it = cgo.begin(); it != cgo.end(); it++ )
-            if( (*it)->getId() == id )
-                return *it;
-        return 0;
+        return GameObject::findIndexedGameObject( prefab ? m_prefabGameObjectsIndex : m_gameObjectsIndex, prefab ? m_prefabGameObjects : m_gameObjects, id, 0, id.size(), GameObjectPath::hash( id ) );
+    }
+
+    GameObject* GameManager::getGameObject( const std::string& str, unsigned int from, unsigned int length, unsigned int hash, bool prefab )
+    {
+        return GameObject::findIndexedGameObject( prefab ? m_prefabGameObjectsIndex : m_gameObjectsIndex, prefab ? m_prefabGameObjects : m_gameObjects, str, from, length, hash );
     }
 
     GameObject* GameManager::findGameObject( const std::string& path )
     {
-        unsigned int from = 0;
-        unsigned int p = path.find( '/', from );
-        while( p - from < 1 && p != std::string::npos )
-        {
-            from++;
-            p = path.find( '/', from );
-        }
-        std::string part = std::string( path, from, p );
-        if( part.empty() )
-            return 0;
-        else if( part == "." )
-        {
-            if( p == std::string::npos )
-                return 0;
-            else
-                return findGameObject( std::string( path, p + 1, std::string::npos ) );
-        }
-        else if( part == ".." )
-            return 0;
-        else
-        {
-            GameObject* go = getGameObject( part );
-            if( go )
-            {
-                if( p == std::string::npos )
-                    return go;
-                else
-                    return go->findGameObject( std::string( path, p + 1, std::string::npos ) );
-            }
-            else
-                return 0;
-        }
+        return GameObjectPath::resolve( path, 0, this );
+    }
+
+    GameObject* GameManager::findGameObject( const GameObjectPath& path )
+    {
+        return GameObjectPath::resolve( path, 0, this );
     }
 
     GameObject::List::iterator GameManager::gameObjectAtBegin( bool prefab )
@@ -713,68 +1211,412 @@ namespace Ptakopysk
 
     GameObject* GameManager::instantiatePrefab( const std::string& id )
     {
+        ALLOCATIONS_SCOPE( sScene );
         GameObject* p = getGameObject( id, true );
         if( !p )
             return 0;
-        GameObject* go = xnew GameObject();
-        go->setInstanceOf( p );
-        p->onDuplicate( go );
-        return go;
+        return instantiatePrefabTemplate( compilePrefab( p ) );
     }
 
-    void GameManager::processLifeCycle()
+    unsigned int GameManager::instantiatePrefab( const std::string& id, unsigned int count, std::vector< GameObject* >& result )
     {
-        if( !m_renderWindow )
-            return;
-        XeCore::Common::Timer timer;
-        timer.start();
-        float fixedStepAccum = 0.0f;
-        while( m_renderWindow->isOpen() )
+        ALLOCATIONS_SCOPE( sScene );
+        result.clear();
+        GameObject* p = getGameObject( id, true );
+        if( !p || !count )
+            return 0;
+        PrefabTemplate& t = compilePrefab( p );
+        result.reserve( count );
+        for( unsigned int i = 0; i < count; i++ )
+            result.push_back( instantiatePrefabTemplate( t ) );
+        return result.size();
+    }
+
+    GameManager::PrefabTemplate& GameManager::compilePrefab( GameObject* prefab )
+    {
+        PrefabTemplate& t = m_prefabTemplates[ prefab ];
+        if( !t.nodes.empty() && t.revision == GameObject::getPrefabsRevision() )
+            return t;
+        t.revision = GameObject::getPrefabsRevision();
+        t.nodes.clear();
+        t.components.clear();
+        compilePrefabNode( t, prefab, -1 );
+        return t;
+    }
+
+    void GameManager::compilePrefabNode( PrefabTemplate& result, GameObject* source, int parent )
+    {
+        PrefabTemplateNode node;
+        node.source = source;
+        node.parent = parent;
+        node.componentsBegin = result.components.size();
+        PrefabTemplateComponent comp;
+        for( GameObject::Components::iterator it = source->componentAtBegin(); it != source->componentAtEnd(); it++ )
         {
-            processRunningScene();
-            sf::Event event;
-            while( m_renderWindow->pollEvent( event ) )
-            {
-                processEvents( event );
-                if( event.type == sf::Event::Closed )
-                    m_renderWindow->close();
+            comp.source = it->second;
+            comp.type = it->first;
+            comp.builder = findComponentFactoryBuilderByType( comp.type );
+            if( comp.builder )
+                result.components.push_back( comp );
+        }
+        node.componentsEnd = result.components.size();
+        int index = result.nodes.size();
+        result.nodes.push_back( node );
+        for( GameObject::List::iterator it = source->m_gameObjectsToCreate.begin(); it != source->m_gameObjectsToCreate.end(); it++ )
+            compilePrefabNode( result, *it, index );
+        for( GameObject::List::iterator it = source->gameObjectAtBegin(); it != source->gameObjectAtEnd(); it++ )
+            compilePrefabNode( result, *it, index );
+    }
+
+    GameObject* GameManager::instantiatePrefabTemplate( PrefabTemplate& t )
+    {
+        m_prefabInstanceNodes.resize( t.nodes.size() );
+        GameObject* go;
+        Component* c;
+        for( unsigned int i = 0; i < t.nodes.size(); i++ )
+        {
+            PrefabTemplateNode& node = t.nodes[ i ];
+            go = buildGameObject();
+            go->setId( node.source->getId() );
+            go->setActive( node.source->isActive() );
+            go->setOrder( node.source->getOrder() );
+            go->setMetaData( node.source->getMetaData() );
+            for( unsigned int j = node.componentsBegin; j < node.componentsEnd; j++ )
+            {
+                PrefabTemplateComponent& comp = t.components[ j ];
+                c = reuseComponent( comp.type );
+                if( !c )
+                    c = comp.builder();
+                comp.source->onDuplicate( c );
+                go->addComponent( c );
             }
-            timer.update();
-            float dt = timer.deltaSeconds();
-            fixedStepAccum += dt;
-            bool processStep = true;
-            float stepDt = dt;
-            if( m_fixedStep > 0.0f )
+            if( node.parent < 0 )
+                go->setInstanceOf( node.source );
+            else
+                m_prefabInstanceNodes[ node.parent ]->addGameObject( go );
+            m_prefabInstanceNodes[ i ] = go;
+        }
+        return t.nodes.empty() ? 0 : m_prefabInstanceNodes[ 0 ];
+    }
+
+    GameObject::Handle GameManager::getHandle( GameObject* go )
+    {
+        if( !go )
+            return 0;
+        if( go->m_handleOwner == this )
+            return go->m_handle;
+        if( go->m_handleOwner )
+            go->m_handleOwner->releaseHandle( go );
+        unsigned int index;
+        if( m_handleFreeSlots.empty() )
+        {
+            if( m_handleSlots.size() > HANDLE_INDEX_MASK )
             {
-                processStep = false;
-                while( fixedStepAccum > m_fixedStep )
+                XWARNING( "Cannot issue game object handle: handle slots limit reached!" );
+                return 0;
+            }
+            index = m_handleSlots.size();
+            HandleSlot slot;
+            slot.object = 0;
+            slot.generation = 1;
+            m_handleSlots.push_back( slot );
+        }
+        else
+        {
+            index = m_handleFreeSlots.back();
+            m_handleFreeSlots.pop_back();
+        }
+        HandleSlot& slot = m_handleSlots[ index ];
+        slot.object = go;
+        go->m_handle = ( slot.generation << HANDLE_INDEX_BITS ) | index;
+        go->m_handleOwner = this;
+        return go->m_handle;
+    }
+
+    void GameManager::releaseHandle( GameObject* go )
+    {
+        if( !go || go->m_handleOwner != this )
+            return;
+        unsigned int index = go->m_handle & HANDLE_INDEX_MASK;
+        if( index < m_handleSlots.size() && m_handleSlots[ index ].object == go )
+        {
+            HandleSlot& slot = m_handleSlots[ index ];
+            slot.object = 0;
+            slot.generation = ( slot.generation + 1 ) & HANDLE_GENERATION_MASK;
+            if( !slot.generation )
+                slot.generation = 1;
+            m_handleFreeSlots.push_back( index );
+        }
+        go->m_handle = 0;
+        go->m_handleOwner = 0;
+    }
+
+    void GameManager::processLifeCycle()
+    {
+        if( m_headless )
+        {
+            processHeadlessLifeCycle();
+            return;
+        }
+        if( !m_renderWindow )
+            return;
+        sf::Clock clock;
+        sf::Time last = clock.getElapsedTime();
+        sf::Time deadline = last;
+        m_fixedStepAccum = 0.0f;
+        m_stepsCount = 0;
+        m_running = true;
+        if( m_pipelined )
+            startRenderPipeline();
+        while( m_running && m_renderWindow->isOpen() )
+        {
+            PROFILE_FRAME();
+            ALLOCATIONS_FRAME();
+            sf::Time now = clock.getElapsedTime();
+            float dt = ( now - last ).asSeconds();
+            last = now;
+            processRunningScene();
+            {
+                PROFILE_ZONE( "Events" );
+                sf::Event event;
+                while( m_renderWindow->pollEvent( event ) )
                 {
-                    processStep = true;
-                    stepDt = m_fixedStep;
-                    fixedStepAccum -= m_fixedStep;
+                    processEvents( event );
+                    if( event.type == sf::Event::Closed )
+                    {
+                        waitForRender();
+                        m_renderWindow->close();
+                    }
                 }
             }
+            processSteps( dt );
+            if( m_interpolating && m_fixedStep > 0.0f )
+                processInterpolation( m_interpolationAlpha );
+            if( m_renderThread )
+            {
+                if( m_renderWindow->isOpen() )
+                {
+                    RenderSnapshot* snapshot = m_renderSnapshots[ m_renderSnapshotIndex ];
+                    processRenderSnapshot( *snapshot );
+                    m_glyphRunCache->endFrame();
+                    PROFILE_ZONE( "RenderSubmit" );
+                    m_renderThread->submit( snapshot );
+                    m_renderSnapshotIndex ^= 1;
+                }
+            }
+            else
+            {
+                m_renderWindow->clear( m_bgColor );
+                processRender( m_renderWindow );
+                PROFILE_ZONE( "Display" );
+                m_renderWindow->display();
+            }
+            m_frameAllocator->reset();
+            waitForDeadline( clock, deadline );
+        }
+        stopRenderPipeline();
+        m_running = false;
+    }
+
+    void GameManager::startRenderPipeline()
+    {
+        if( m_renderThread || !m_renderWindow )
+            return;
+        if( !m_renderSnapshots[ 0 ] )
+            m_renderSnapshots[ 0 ] = xnew RenderSnapshot();
+        if( !m_renderSnapshots[ 1 ] )
+            m_renderSnapshots[ 1 ] = xnew RenderSnapshot();
+        m_renderWindow->setActive( false );
+        m_renderThread = xnew RenderThread( m_renderWindow );
+        m_renderThread->start();
+        s_renderThreads.push_back( m_renderThread );
+    }
+
+    void GameManager::stopRenderPipeline()
+    {
+        if( !m_renderThread )
+            return;
+        s_renderThreads.erase( std::find( s_renderThreads.begin(), s_renderThreads.end(), m_renderThread ) );
+        m_renderThread->stop();
+        DELETE_OBJECT( m_renderThread );
+        if( m_renderWindow )
+            m_renderWindow->setActive( true );
+    }
+
+    void GameManager::waitForRender()
+    {
+        if( m_renderThread )
+            m_renderThread->wait();
+    }
+
+    void GameManager::waitForAllRenders()
+    {
+        for( std::vector< RenderThread* >::iterator it = s_renderThreads.begin(); it != s_renderThreads.end(); it++ )
+            (*it)->wait();
+    }
+
+    void GameManager::processRenderSnapshot( RenderSnapshot& snapshot )
+    {
+        PROFILE_ZONE( "RenderSnapshot" );
+        ALLOCATIONS_SCOPE( sRender );
+        snapshot.clear();
+        snapshot.setClearColor( m_bgColor );
+        if( m_spatialGrid && m_renderWindow )
+        {
+            SpatialGrid::s_current = m_spatialGrid;
+            m_spatialGrid->markVisible( SpatialGrid::viewBounds( m_renderWindow->getDefaultView() ) );
+        }
+        for( GameObject::List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
+            (*it)->onRenderSnapshot( snapshot );
+        SpatialGrid::s_current = 0;
+    }
+
+    void GameManager::setRenderCulling( bool mode )
+    {
+        m_renderCulling = mode;
+        if( mode && !m_spatialGrid )
+        {
+            m_spatialGrid = xnew SpatialGrid( m_renderCullingCellSize );
+            updateGameObjectsCulling( m_gameObjects );
+        }
+        else if( !mode && m_spatialGrid )
+        {
+            std::vector< void* > components;
+            m_spatialGrid->getAllUserData( components );
+            for( std::vector< void* >::iterator it = components.begin(); it != components.end(); it++ )
+                ( (Component*)*it )->releaseCulling();
+            DELETE_OBJECT( m_spatialGrid );
+        }
+    }
+
+    void GameManager::updateGameObjectsCulling( GameObject::List& list )
+    {
+        Component* c;
+        for( GameObject::List::iterator it = list.begin(); it != list.end(); it++ )
+        {
+            for( GameObject::Components::iterator itc = (*it)->m_components.begin(); itc != (*it)->m_components.end(); itc++ )
+            {
+                c = itc->second;
+                if( c->isActive() && c->getTypeFlags() & Component::tRender )
+                    c->updateCulling();
+            }
+            updateGameObjectsCulling( (*it)->m_gameObjects );
+        }
+    }
+
+    void GameManager::stopLifeCycle()
+    {
+        m_running = false;
+    }
 
+    void GameManager::processHeadlessLifeCycle()
+    {
+        if( m_fixedStep <= 0.0f )
+            m_fixedStep = 1.0f / DEFAULT_HEADLESS_FPS;
+        sf::Clock clock;
+        sf::Time last = clock.getElapsedTime();
+        sf::Time deadline = last;
+        m_fixedStepAccum = 0.0f;
+        m_stepsCount = 0;
+        m_running = true;
+        while( m_running )
+        {
+            PROFILE_FRAME();
+            ALLOCATIONS_FRAME();
+            float dt = m_fixedStep;
+            if( m_headlessRealTime )
+            {
+                sf::Time now = clock.getElapsedTime();
+                dt = ( now - last ).asSeconds();
+                last = now;
+            }
+            processRunningScene();
+            processSteps( dt );
+            m_frameAllocator->reset();
+            if( m_headlessRealTime )
+                waitForDeadline( clock, deadline );
+        }
+    }
+
+    void GameManager::processSteps( float dt )
+    {
+        {
+            PROFILE_ZONE( "Dispatch" );
             Events::use().dispatch();
-            if( processStep )
+        }
+        if( m_fixedStep > 0.0f )
+        {
+            m_fixedStepAccum += dt;
+            unsigned int steps = 0;
+            while( m_running && m_fixedStepAccum >= m_fixedStep && ( !m_maxSubSteps || steps < m_maxSubSteps ) )
             {
-                Tweener::use().processTweens( stepDt );
-                processPhysics( stepDt );
-                processUpdate( stepDt );
+                if( m_interpolating )
+                    for( std::vector< Transform* >::iterator it = m_interpolatedTransforms.begin(); it != m_interpolatedTransforms.end(); it++ )
+                        (*it)->storeInterpolationState();
+                processStep( m_fixedStep );
+                m_fixedStepAccum -= m_fixedStep;
+                steps++;
             }
-            m_renderWindow->clear( m_bgColor );
-            processRender( m_renderWindow );
-            m_renderWindow->display();
-            if( stepDt > 0.0f )
-                XeCore::Common::Concurrent::Thread::sleep( (unsigned int)( 1000.0f * stepDt ) );
+            if( m_fixedStepAccum >= m_fixedStep )
+                m_fixedStepAccum = std::fmod( m_fixedStepAccum, m_fixedStep );
+            m_interpolationAlpha = m_fixedStepAccum / m_fixedStep;
+        }
+        else
+        {
+            processStep( dt );
+            m_interpolationAlpha = 1.0f;
         }
-        timer.stop();
+    }
+
+    void GameManager::waitForDeadline( sf::Clock& clock, sf::Time& deadline )
+    {
+        float frameStep = m_targetFrameStep > 0.0f ? m_targetFrameStep : m_fixedStep;
+        if( frameStep <= 0.0f )
+            return;
+        PROFILE_ZONE( "Wait" );
+        deadline += sf::seconds( frameStep );
+        sf::Time now = clock.getElapsedTime();
+        if( deadline > now )
+            sf::sleep( deadline - now );
+        else
+            deadline = now;
+    }
+
+    void GameManager::processInterpolation( float alpha )
+    {
+        PROFILE_ZONE( "Interpolation" );
+        Transform::s_interpolationAlpha = alpha;
+        GameObject* go;
+        for( std::vector< Transform* >::iterator it = m_interpolatedTransforms.begin(); it != m_interpolatedTransforms.end(); it++ )
+        {
+            go = (*it)->getGameObject();
+            if( go )
+                go->onUpdateTransform( go->getParent() ? go->getParent()->getWorldTransform() : sf::Transform::Identity, true );
+        }
+        Transform::s_interpolationAlpha = 1.0f;
+    }
+
+    void GameManager::setComponentsPooling( bool mode )
+    {
+        if( m_componentsPooling == mode )
+            return;
+        m_componentsPooling = mode;
+        attachComponentsPools( m_gameObjects, mode );
+        if( !mode )
+            m_componentsPools.clear();
+    }
+
+    GameManager::ComponentsPool* GameManager::getComponentsPool( XeCore::Common::IRtti::Derivation type )
+    {
+        return componentsPoolAt( GameObject::componentTypeSlot( type ) );
     }
 
     void GameManager::processRunningScene()
     {
+        ALLOCATIONS_SCOPE( sScene );
         if( m_sceneToRun.empty() )
             return;
+        waitForRender();
         removeScene( All );
         Json::Value scene = Assets::loadJson( m_sceneToRun );
         jsonToScene( scene );
@@ -789,21 +1631,79 @@ namespace Ptakopysk
 
     void GameManager::processPhysics( float dt, int velIters, int posIters )
     {
+        PROFILE_ZONE( "Physics" );
+        ALLOCATIONS_SCOPE( sPhysics );
         m_world->Step( dt, velIters, posIters );
     }
 
     void GameManager::processUpdate( float dt, bool sort )
     {
+        PROFILE_ZONE( "Update" );
+        ALLOCATIONS_SCOPE( sUpdate );
         processAdding();
         processRemoving();
         if( sort )
-            m_gameObjects.sort( CompareGameObjects() );
+            sortGameObjects();
+        if( m_componentsPooling )
+            processUpdatePools( dt, sort );
+        else
+        {
+            unsigned int parallelFrame = 0;
+            if( m_parallelUpdate )
+            {
+                m_updateFrame++;
+                if( !m_updateFrame )
+                    m_updateFrame++;
+                parallelFrame = m_updateFrame;
+                m_parallelUpdateComponents.clear();
+                for( GameObject::List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
+                    (*it)->onCollectParallelUpdate( m_parallelUpdateComponents, parallelFrame );
+                processParallelUpdate( dt );
+            }
+            // objects added while updating were not collected, so they run onUpdateParallel serially.
+            for( GameObject::List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
+                (*it)->onUpdate( dt, sf::Transform::Identity, sort, false, parallelFrame );
+        }
+        m_jobs->wait( &m_frameFence );
+    }
+
+    void GameManager::processStep( float dt )
+    {
+        PROFILE_ZONE( "Step" );
+        {
+            PROFILE_ZONE( "Tweens" );
+            Tweener::use().processTweens( dt );
+        }
+        processPhysics( dt );
+        processUpdate( dt );
+        if( m_deterministic )
+            processPending();
+        m_stepsCount++;
+        if( m_maxSteps && m_stepsCount >= m_maxSteps )
+            m_running = false;
+    }
+
+    void GameManager::setDeterministic( bool mode )
+    {
+        m_deterministic = mode;
+        if( m_deterministic && m_fixedStep <= 0.0f )
+            m_fixedStep = m_targetFrameStep > 0.0f ? m_targetFrameStep : 1.0f / DEFAULT_HEADLESS_FPS;
+    }
+
+    void GameManager::processPending()
+    {
+        processAdding();
+        processRemoving();
         for( GameObject::List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
-            (*it)->onUpdate( dt, sf::Transform::Identity, sort );
+            (*it)->onFlushPending();
     }
 
     void GameManager::processRender( sf::RenderTarget* target )
     {
+        if( m_headless )
+            return;
+        PROFILE_ZONE( "Render" );
+        ALLOCATIONS_SCOPE( sRender );
         if( !target )
             target = m_renderWindow;
         if( !target )
@@ -813,9 +1713,38 @@ namespace Ptakopysk
         }
         Camera::s_mainRT = target;
         target->setView( target->getDefaultView() );
+        if( m_spriteBatching )
+        {
+            SpriteBatch::s_current = m_spriteBatch;
+            m_spriteBatch->begin();
+        }
+        if( m_spatialGrid )
+        {
+            SpatialGrid::s_current = m_spatialGrid;
+            m_spatialGrid->markVisible( SpatialGrid::viewBounds( target->getView() ) );
+        }
         sf::RenderTarget*& currentTarget = target;
-        for( GameObject::List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
-            (*it)->onRender( currentTarget );
+        if( m_renderSorting )
+        {
+            m_renderQueue->begin();
+            GameObject::onRenderQueueList( m_gameObjects.begin(), m_gameObjects.end(), *m_renderQueue );
+            m_renderQueue->sort();
+            SpatialGrid::s_current = 0;
+            m_renderQueue->execute( currentTarget, SpriteBatch::current() );
+            m_renderQueue->end();
+        }
+        else
+        {
+            for( GameObject::List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
+                (*it)->onRender( currentTarget );
+        }
+        if( m_spriteBatching )
+        {
+            m_spriteBatch->end();
+            SpriteBatch::s_current = 0;
+        }
+        SpatialGrid::s_current = 0;
+        m_glyphRunCache->endFrame();
         target->setView( target->getDefaultView() );
         if( Camera::s_currentRT )
             Camera::s_currentRT->display();
@@ -839,11 +1768,19 @@ namespace Ptakopysk
 
     void GameManager::processAdding()
     {
+        if( m_gameObjectsToCreate.empty() )
+            return;
+        PROFILE_ZONE( "Adding" );
+        ALLOCATIONS_SCOPE( sScene );
+        m_gameObjectsOrderDirty = true;
         GameObject* go;
         for( GameObject::List::iterator it = m_gameObjectsToCreate.begin(); it != m_gameObjectsToCreate.end(); it++ )
         {
             go = *it;
             m_gameObjects.push_back( go );
+            go->m_membership = GameObject::msAdded;
+            GameObject::indexGameObject( m_gameObjectsIndex, go );
+            go->invalidateTransform();
             go->onCreate();
             go->processAdding();
         }
@@ -852,42 +1789,76 @@ namespace Ptakopysk
 
     void GameManager::processRemoving()
     {
+        if( m_gameObjectsToDestroy.empty() )
+            return;
+        PROFILE_ZONE( "Removing" );
+        ALLOCATIONS_SCOPE( sScene );
+        for( GameObject::List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); )
+        {
+            if( (*it)->m_membership == GameObject::msWaitingToRemove )
+                it = m_gameObjects.erase( it );
+            else
+                it++;
+        }
         GameObject* go;
         for( GameObject::List::iterator it = m_gameObjectsToDestroy.begin(); it != m_gameObjectsToDestroy.end(); it++ )
         {
             go = *it;
-            if( std::find( m_gameObjects.begin(), m_gameObjects.end(), go ) == m_gameObjects.end() )
-                continue;
             go->processRemoving();
-            m_gameObjects.remove( go );
+            go->m_membership = GameObject::msNone;
+            GameObject::unindexGameObject( m_gameObjectsIndex, go );
             go->setGameManager( 0 );
             go->setPrefab( false );
-            DELETE_OBJECT( go );
+            recycleGameObject( go );
         }
         m_gameObjectsToDestroy.clear();
     }
 
+    void GameManager::sortGameObjects()
+    {
+        if( !m_gameObjectsOrderDirty )
+            return;
+        m_gameObjects.sort( CompareGameObjects() );
+        m_gameObjectsOrderDirty = false;
+    }
+
     bool GameManager::isWaitingToAdd( GameObject* go )
     {
-        for( GameObject::List::iterator it = m_gameObjectsToCreate.begin(); it != m_gameObjectsToCreate.end(); it++ )
-            if( *it == go )
-                return true;
-        return false;
+        return go && go->getGameManager() == this && !go->getParent() && go->m_membership == GameObject::msWaitingToAdd;
     }
 
     bool GameManager::isWaitingToRemove( GameObject* go )
     {
-        for( GameObject::List::iterator it = m_gameObjectsToDestroy.begin(); it != m_gameObjectsToDestroy.end(); it++ )
-            if( *it == go )
-                return true;
-        return false;
+        return go && go->getGameManager() == this && !go->getParent() && go->m_membership == GameObject::msWaitingToRemove;
     }
 
     void GameManager::setupFromConfig( const Json::Value& config )
     {
         if( !config.isNull() && config.isObject() )
         {
-            if( config.isMember( "window" ) )
+            if( config.isMember( "headless" ) )
+            {
+                Json::Value headless = config[ "headless" ];
+                if( headless.isBool() )
+                    setHeadless( headless.asBool() );
+                else if( headless.isObject() )
+                {
+                    setHeadless( true );
+                    if( headless.isMember( "realTime" ) )
+                    {
+                        Json::Value realTime = headless[ "realTime" ];
+                        if( realTime.isBool() )
+                            m_headlessRealTime = realTime.asBool();
+                    }
+                    if( headless.isMember( "steps" ) )
+                    {
+                        Json::Value steps = headless[ "steps" ];
+                        if( steps.isNumeric() )
+                            m_maxSteps = steps.asUInt();
+                    }
+                }
+            }
+            if( !m_headless && config.isMember( "window" ) )
             {
                 Json::Value window = config[ "window" ];
                 m_bgColor = sf::Color::White;
@@ -986,6 +1957,107 @@ namespace Ptakopysk
                         if( fixedStep.isNumeric() )
                             m_fixedStep = (float)fixedStep.asDouble();
                     }
+                    if( lifeCycle.isMember( "targetFps" ) )
+                    {
+                        Json::Value targetFps = lifeCycle[ "targetFps" ];
+                        if( targetFps.isNumeric() )
+                        {
+                            float v = (float)targetFps.asDouble();
+                            m_targetFrameStep = v > 0.0f ? 1.0f / v : 0.0f;
+                        }
+                    }
+                    if( lifeCycle.isMember( "maxSubSteps" ) )
+                    {
+                        Json::Value maxSubSteps = lifeCycle[ "maxSubSteps" ];
+                        if( maxSubSteps.isNumeric() )
+                            m_maxSubSteps = maxSubSteps.asUInt();
+                    }
+                    if( lifeCycle.isMember( "interpolation" ) )
+                    {
+                        Json::Value interpolation = lifeCycle[ "interpolation" ];
+                        if( interpolation.isBool() )
+                            m_interpolating = interpolation.asBool();
+                    }
+                    if( lifeCycle.isMember( "jobsWorkers" ) )
+                    {
+                        Json::Value jobsWorkers = lifeCycle[ "jobsWorkers" ];
+                        if( jobsWorkers.isNumeric() )
+                            m_jobsWorkers = jobsWorkers.asUInt();
+                        else if( jobsWorkers.isString() && jobsWorkers.asString() == "auto" )
+                            m_jobsWorkers = Jobs::autoWorkersCount();
+                    }
+                    if( lifeCycle.isMember( "parallelUpdate" ) )
+                    {
+                        Json::Value parallelUpdate = lifeCycle[ "parallelUpdate" ];
+                        if( parallelUpdate.isBool() )
+                            m_parallelUpdate = parallelUpdate.asBool();
+                    }
+                    if( lifeCycle.isMember( "parallelUpdateBatch" ) )
+                    {
+                        Json::Value parallelUpdateBatch = lifeCycle[ "parallelUpdateBatch" ];
+                        if( parallelUpdateBatch.isNumeric() )
+                            m_parallelUpdateBatch = parallelUpdateBatch.asUInt();
+                    }
+                    if( lifeCycle.isMember( "deterministic" ) )
+                    {
+                        Json::Value deterministic = lifeCycle[ "deterministic" ];
+                        if( deterministic.isBool() )
+                            setDeterministic( deterministic.asBool() );
+                    }
+                    if( lifeCycle.isMember( "pipelined" ) )
+                    {
+                        Json::Value pipelined = lifeCycle[ "pipelined" ];
+                        if( pipelined.isBool() )
+                            m_pipelined = pipelined.asBool();
+                    }
+                    if( lifeCycle.isMember( "spriteBatching" ) )
+                    {
+                        Json::Value spriteBatching = lifeCycle[ "spriteBatching" ];
+                        if( spriteBatching.isBool() )
+                            m_spriteBatching = spriteBatching.asBool();
+                    }
+                    if( lifeCycle.isMember( "renderSorting" ) )
+                    {
+                        Json::Value renderSorting = lifeCycle[ "renderSorting" ];
+                        if( renderSorting.isBool() )
+                            m_renderSorting = renderSorting.asBool();
+                    }
+                    if( lifeCycle.isMember( "renderCulling" ) )
+                    {
+                        Json::Value renderCulling = lifeCycle[ "renderCulling" ];
+                        if( renderCulling.isBool() )
+                            m_renderCulling = renderCulling.asBool();
+                    }
+                    if( lifeCycle.isMember( "renderCullingCellSize" ) )
+                    {
+                        Json::Value renderCullingCellSize = lifeCycle[ "renderCullingCellSize" ];
+                        if( renderCullingCellSize.isNumeric() )
+                            m_renderCullingCellSize = (float)renderCullingCellSize.asDouble();
+                    }
+                    if( lifeCycle.isMember( "frameAllocatorCapacity" ) )
+                    {
+                        Json::Value frameAllocatorCapacity = lifeCycle[ "frameAllocatorCapacity" ];
+                        if( frameAllocatorCapacity.isNumeric() )
+                            m_frameAllocatorCapacity = frameAllocatorCapacity.asUInt();
+                    }
+                    if( lifeCycle.isMember( "recycleGameObjects" ) )
+                    {
+                        Json::Value recycleGameObjects = lifeCycle[ "recycleGameObjects" ];
+                        if( recycleGameObjects.isNumeric() )
+                            s_gameObjectsRecycleLimit = recycleGameObjects.asUInt();
+                    }
+                    if( lifeCycle.isMember( "recycleComponents" ) )
+                    {
+                        Json::Value recycleComponents = lifeCycle[ "recycleComponents" ];
+                        if( recycleComponents.isNumeric() )
+                            s_componentsRecycleLimit = recycleComponents.asUInt();
+                    }
+                    if( lifeCycle.isMember( "componentsPools" ) )
+                    {
+                        Json::Value componentsPools = lifeCycle[ "componentsPools" ];
+                        if( componentsPools.isBool() )
+                            m_componentsPooling = componentsPools.asBool();
+                    }
                 }
             }
             if( config.isMember( "scenes" ) )
@@ -1029,12 +2101,16 @@ namespace Ptakopysk
 
     void GameManager::processTextureChanged( const sf::Texture* p, bool addedOrRemoved )
     {
+        if( !addedOrRemoved )
+            waitForRender();
         for( GameObject::List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
             (*it)->onTextureChanged( p, addedOrRemoved );
     }
 
     void GameManager::processShaderChanged( const sf::Shader* p, bool addedOrRemoved )
     {
+        if( !addedOrRemoved )
+            waitForRender();
         for( GameObject::List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
             (*it)->onShaderChanged( p, addedOrRemoved );
     }
@@ -1053,6 +2129,8 @@ namespace Ptakopysk
 
     void GameManager::processFontChanged( const sf::Font* p, bool addedOrRemoved )
     {
+        if( !addedOrRemoved )
+            waitForRender();
         for( GameObject::List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
             (*it)->onFontChanged( p, addedOrRemoved );
     }
@@ -1063,6 +2141,170 @@ namespace Ptakopysk
             (*it)->onCustomAssetChanged( p, addedOrRemoved );
     }
 
+    void GameManager::registerComponentInPool( Component* c )
+    {
+        unsigned int slot = GameObject::componentTypeSlot( c->getType() );
+        if( slot >= m_componentsPools.size() )
+            m_componentsPools.resize( slot + 1 );
+        ComponentsPool& pool = m_componentsPools[ slot ];
+        if( c->m_poolIndex < pool.size() && pool[ c->m_poolIndex ] == c )
+            return;
+        c->m_poolIndex = pool.size();
+        pool.push_back( c );
+    }
+
+    void GameManager::registerInterpolatedTransform( Transform* t )
+    {
+        if( t->m_interpolationOwner == this )
+            return;
+        if( t->m_interpolationOwner )
+            t->m_interpolationOwner->unregisterInterpolatedTransform( t );
+        t->m_interpolationOwner = this;
+        t->m_interpolationIndex = m_interpolatedTransforms.size();
+        m_interpolatedTransforms.push_back( t );
+    }
+
+    void GameManager::unregisterInterpolatedTransform( Transform* t )
+    {
+        if( t->m_interpolationOwner != this )
+            return;
+        unsigned int index = t->m_interpolationIndex;
+        if( index < m_interpolatedTransforms.size() && m_interpolatedTransforms[ index ] == t )
+        {
+            Transform* last = m_interpolatedTransforms.back();
+            m_interpolatedTransforms[ index ] = last;
+            last->m_interpolationIndex = index;
+            m_interpolatedTransforms.pop_back();
+        }
+        t->m_interpolationOwner = 0;
+        t->m_interpolationIndex = 0;
+        t->resetInterpolationState();
+    }
+
+    void GameManager::unregisterComponentFromPool( Component* c )
+    {
+        unsigned int slot = GameObject::componentTypeSlot( c->getType() );
+        if( slot >= m_componentsPools.size() )
+            return;
+        ComponentsPool& pool = m_componentsPools[ slot ];
+        unsigned int index = c->m_poolIndex;
+        if( index >= pool.size() || pool[ index ] != c )
+            return;
+        if( m_componentsPoolsSweeping )
+        {
+            pool[ index ] = 0;
+            c->m_poolIndex = 0;
+            m_componentsPoolsDirty = true;
+            return;
+        }
+        Component* last = pool.back();
+        pool[ index ] = last;
+        last->m_poolIndex = index;
+        pool.pop_back();
+        c->m_poolIndex = 0;
+    }
+
+    void GameManager::processUpdatePools( float dt, bool sort )
+    {
+        m_updateFrame++;
+        if( !m_updateFrame )
+            m_updateFrame++;
+        for( GameObject::List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
+            (*it)->onUpdatePrepare( m_updateFrame, sort );
+        Component* c;
+        if( m_parallelUpdate )
+        {
+            m_parallelUpdateComponents.clear();
+            for( unsigned int slot = 0; slot < m_componentsPools.size(); slot++ )
+            {
+                for( unsigned int i = 0; i < m_componentsPools[ slot ].size(); i++ )
+                {
+                    c = m_componentsPools[ slot ][ i ];
+                    if( c && c->isActive() && c->getTypeFlags() & Component::tParallelUpdate && c->getGameObject()->m_updateFrame == m_updateFrame )
+                        m_parallelUpdateComponents.push_back( c );
+                }
+            }
+            processParallelUpdate( dt );
+        }
+        m_componentsPoolsSweeping = true;
+        for( unsigned int slot = 0; slot < m_componentsPools.size(); slot++ )
+        {
+            for( unsigned int i = 0; i < m_componentsPools[ slot ].size(); i++ )
+            {
+                c = m_componentsPools[ slot ][ i ];
+                if( !c || !c->isActive() || c->getGameObject()->m_updateFrame != m_updateFrame )
+                    continue;
+                if( !m_parallelUpdate && c->getTypeFlags() & Component::tParallelUpdate )
+                    c->onUpdateParallel( dt );
+                if( c->getTypeFlags() & Component::tUpdate )
+                {
+                    PROFILE_COMPONENT( c, cpUpdate );
+                    c->onUpdate( dt );
+                }
+            }
+        }
+        m_componentsPoolsSweeping = false;
+        if( m_componentsPoolsDirty )
+            compactComponentsPools();
+        for( GameObject::List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
+            (*it)->onUpdateTransform( sf::Transform::Identity );
+    }
+
+    void GameManager::compactComponentsPools()
+    {
+        unsigned int count;
+        Component* c;
+        for( std::vector< ComponentsPool >::iterator it = m_componentsPools.begin(); it != m_componentsPools.end(); it++ )
+        {
+            ComponentsPool& pool = *it;
+            count = 0;
+            for( unsigned int i = 0; i < pool.size(); i++ )
+            {
+                c = pool[ i ];
+                if( !c )
+                    continue;
+                c->m_poolIndex = count;
+                pool[ count++ ] = c;
+            }
+            pool.resize( count );
+        }
+        m_componentsPoolsDirty = false;
+    }
+
+    void GameManager::processParallelUpdate( float dt )
+    {
+        if( m_parallelUpdateComponents.empty() )
+            return;
+        PROFILE_ZONE( "ParallelUpdate" );
+        m_parallelUpdateDt = dt;
+        ParallelUpdateJob job( this );
+        m_jobs->parallelFor( &job, m_parallelUpdateComponents.size(), m_parallelUpdateBatch, m_frameAllocator );
+        m_parallelUpdateComponents.clear();
+    }
+
+    void GameManager::processParallelUpdate( unsigned int from, unsigned int to )
+    {
+        ALLOCATIONS_SCOPE( sUpdate );
+        for( unsigned int i = from; i < to; i++ )
+            m_parallelUpdateComponents[ i ]->onUpdateParallel( m_parallelUpdateDt );
+    }
+
+    void GameManager::attachComponentsPools( GameObject::List& list, bool mode )
+    {
+        GameObject* go;
+        for( GameObject::List::iterator it = list.begin(); it != list.end(); it++ )
+        {
+            go = *it;
+            if( go->isDestroying() )
+                continue;
+            if( mode )
+                go->attachComponentsToPools( this );
+            else
+                go->detachComponentsFromPools();
+            attachComponentsPools( go->m_gameObjects, mode );
+        }
+    }
+
     GameManager::SceneContentType operator|( GameManager::SceneContentType a, GameManager::SceneContentType b )
     {
         return (GameManager::SceneContentType)( (int)a | (int)b );
@@ -1,6 +1,11 @@
 #include "../../include/Ptakopysk/System/GameObject.h"
 #include "../../include/Ptakopysk/System/GameManager.h"
 #include "../../include/Ptakopysk/Components/Component.h"
+#include "../../include/Ptakopysk/Components/Transform.h"
+#include "../../include/Ptakopysk/System/Profiler.h"
+#include "../../include/Ptakopysk/System/SpriteBatch.h"
+#include "../../include/Ptakopysk/System/SpatialGrid.h"
+#include "../../include/Ptakopysk/System/RenderQueue.h"
 #include <XeCore/Common/Logger.h>
 #include <sstream>
 
@@ -12,6 +17,11 @@ namespace Ptakopysk
                             RTTI_DERIVATIONS_END
                             )
 
+    const GameObject::ComponentsTypeSlots* volatile GameObject::s_componentsTypeSlots = 0;
+    std::vector< const GameObject::ComponentsTypeSlots* > GameObject::s_componentsTypeSlotsRetired = std::vector< const GameObject::ComponentsTypeSlots* >();
+    tthread::mutex GameObject::s_componentsTypeSlotsMutex;
+    unsigned int GameObject::s_prefabsRevision = 0;
+
     GameObject::GameObject( const std::string& id )
     : RTTI_CLASS_DEFINE( GameObject )
     , Id( this, &GameObject::getId, &GameObject::setId )
@@ -24,10 +34,19 @@ namespace Ptakopysk
     , m_instanceOf( 0 )
     , m_prefab( false )
     , m_id( id )
+    , m_idHash( GameObjectPath::hash( id ) )
+    , m_handle( 0 )
+    , m_handleOwner( 0 )
     , m_active( true )
     , m_order( 0 )
     , m_isDestroying( false )
+    , m_membership( msNone )
     , m_metaData( Json::Value::null )
+    , m_componentsPoolsOwner( 0 )
+    , m_updateFrame( 0 )
+    , m_transformDirty( true )
+    , m_transformChildDirty( false )
+    , m_gameObjectsOrderDirty( false )
     {
         serializableProperty( "Id" );
         serializableProperty( "Active" );
@@ -37,17 +56,33 @@ namespace Ptakopysk
 
     GameObject::~GameObject()
     {
-        removeAllComponents();
-        removeAllGameObjects();
-        processRemovingDelayedComponents();
-        processRemoving();
-        GameObject* go;
-        for( List::iterator it = m_gameObjectsToCreate.begin(); it != m_gameObjectsToCreate.end(); it++ )
-        {
-            go = *it;
-            DELETE_OBJECT( go );
-        }
-        m_gameObjectsToCreate.clear();
+        reset();
+    }
+
+    void GameObject::setId( std::string id )
+    {
+        if( m_id == id )
+            return;
+        IdsIndex* index = 0;
+        if( m_parent )
+            index = &m_parent->m_gameObjectsIndex;
+        else if( m_gameManager )
+            index = m_prefab ? &m_gameManager->m_prefabGameObjectsIndex : &m_gameManager->m_gameObjectsIndex;
+        bool indexed = index && ( m_membership == msAdded || m_membership == msWaitingToRemove );
+        if( indexed )
+            unindexGameObject( *index, this );
+        m_id = id;
+        m_idHash = GameObjectPath::hash( id );
+        if( indexed )
+            indexGameObject( *index, this );
+    }
+
+    GameObject::Handle GameObject::getHandle()
+    {
+        if( m_handleOwner )
+            return m_handle;
+        GameManager* gm = getGameManagerRoot();
+        return gm ? gm->getHandle( this ) : 0;
     }
 
     GameManager* GameObject::getGameManagerRoot()
@@ -64,6 +99,28 @@ namespace Ptakopysk
         return 0;
     }
 
+    void GameObject::setOrder( int order )
+    {
+        if( m_order == order )
+            return;
+        m_order = order;
+        if( m_parent )
+            m_parent->m_gameObjectsOrderDirty = true;
+        else if( m_gameManager )
+            m_gameManager->m_gameObjectsOrderDirty = true;
+    }
+
+    void GameObject::invalidateTransform()
+    {
+        m_transformDirty = true;
+        GameObject* p = m_parent;
+        while( p && !p->m_transformChildDirty )
+        {
+            p->m_transformChildDirty = true;
+            p = p->getParent();
+        }
+    }
+
     void GameObject::fromJson( const Json::Value& root )
     {
         if( !root.isObject() )
@@ -131,7 +188,7 @@ namespace Ptakopysk
                 }
                 else
                 {
-                    GameObject* go = xnew GameObject();
+                    GameObject* go = GameManager::buildGameObject();
                     addGameObject( go );
                     go->fromJson( item );
                 }
@@ -191,7 +248,17 @@ namespace Ptakopysk
         if( !c || hasComponent( c->getType() ) )
             return;
         m_components.push_back( std::make_pair( c->getType(), c ) );
+        unsigned int slot = componentTypeSlot( c->getType() );
+        if( slot >= m_componentsSlots.size() )
+            m_componentsSlots.resize( slot + 1, 0 );
+        m_componentsSlots[ slot ] = c;
         c->setGameObject( this );
+        if( m_componentsPoolsOwner )
+            m_componentsPoolsOwner->registerComponentInPool( c );
+        if( c->getTypeFlags() & Component::tTransform )
+            invalidateTransform();
+        if( m_prefab )
+            s_prefabsRevision++;
     }
 
     void GameObject::removeComponent( Component* c, bool delayed )
@@ -206,9 +273,8 @@ namespace Ptakopysk
                     m_componentsToDestroyDelayed.push_back( std::make_pair( c->getType(), c ) );
                 else
                 {
-                    c->setGameObject( 0 );
-                    DELETE_OBJECT( c );
                     m_components.erase( it );
+                    destroyComponent( c );
                 }
                 return;
             }
@@ -227,9 +293,8 @@ namespace Ptakopysk
                     m_componentsToDestroyDelayed.push_back( std::make_pair( c->getType(), c ) );
                 else
                 {
-                    c->setGameObject( 0 );
-                    DELETE_OBJECT( c );
                     m_components.erase( it );
+                    destroyComponent( c );
                 }
                 return;
             }
@@ -245,13 +310,8 @@ namespace Ptakopysk
         }
         else
         {
-            Component* c;
             for( Components::iterator it = m_components.begin(); it != m_components.end(); it++ )
-            {
-                c = it->second;
-                c->setGameObject( 0 );
-                DELETE_OBJECT( c );
-            }
+                destroyComponent( it->second );
             m_components.clear();
         }
     }
@@ -270,22 +330,54 @@ namespace Ptakopysk
 
     bool GameObject::hasComponent( XeCore::Common::IRtti::Derivation d )
     {
-        for( Components::iterator it = m_components.begin(); it != m_components.end(); it++ )
-        {
-            if( it->first == d )
-                return true;
-        }
-        return false;
+        return getComponent( d ) != 0;
     }
 
     Component* GameObject::getComponent( XeCore::Common::IRtti::Derivation d )
     {
-        for( Components::iterator it = m_components.begin(); it != m_components.end(); it++ )
+        const ComponentsTypeSlots* slots = s_componentsTypeSlots;
+        if( !slots )
+            return 0;
+        ComponentsTypeSlots::const_iterator it = slots->find( d );
+        return it == slots->end() ? 0 : getComponentAtSlot( it->second );
+    }
+
+    unsigned int GameObject::componentTypeSlot( XeCore::Common::IRtti::Derivation d )
+    {
+        const ComponentsTypeSlots* slots = s_componentsTypeSlots;
+        ComponentsTypeSlots::const_iterator it;
+        if( slots && ( it = slots->find( d ) ) != slots->end() )
+            return it->second;
+        tthread::lock_guard< tthread::mutex > guard( s_componentsTypeSlotsMutex );
+        slots = s_componentsTypeSlots;
+        if( slots && ( it = slots->find( d ) ) != slots->end() )
+            return it->second;
+        ComponentsTypeSlots* next = slots ? new ComponentsTypeSlots( *slots ) : new ComponentsTypeSlots();
+        unsigned int slot = next->size();
+        ( *next )[ d ] = slot;
+        if( slots )
+            s_componentsTypeSlotsRetired.push_back( slots );
+        __sync_synchronize();
+        s_componentsTypeSlots = next;
+        return slot;
+    }
+
+    unsigned int GameObject::componentTypesCount()
+    {
+        const ComponentsTypeSlots* slots = s_componentsTypeSlots;
+        return slots ? slots->size() : 0;
+    }
+
+    void GameObject::releaseRetiredComponentTypeSlots()
+    {
+        tthread::lock_guard< tthread::mutex > guard( s_componentsTypeSlotsMutex );
+        const ComponentsTypeSlots* slots;
+        for( std::vector< const ComponentsTypeSlots* >::iterator it = s_componentsTypeSlotsRetired.begin(); it != s_componentsTypeSlotsRetired.end(); it++ )
         {
-            if( it->first == d )
-                return it->second;
+            slots = *it;
+            DELETE_OBJECT( slots );
         }
-        return 0;
+        s_componentsTypeSlotsRetired.clear();
     }
 
     Component* GameObject::getOrCreateComponent( XeCore::Common::IRtti::Derivation d )
@@ -311,8 +403,7 @@ namespace Ptakopysk
                 continue;
             c = it->second;
             m_components.remove( *it );
-            c->setGameObject( 0 );
-            DELETE_OBJECT( c );
+            destroyComponent( c );
         }
         m_componentsToDestroyDelayed.clear();
     }
@@ -355,11 +446,15 @@ namespace Ptakopysk
 
     void GameObject::addGameObject( GameObject* go )
     {
-        if( !go || go->getType() != RTTI_CLASS_TYPE( GameObject ) || hasGameObject( go ) || isWaitingToAdd( go ) )
+        if( !go || go->getType() != RTTI_CLASS_TYPE( GameObject ) || go->m_membership != msNone )
             return;
         if( m_prefab )
         {
+            s_prefabsRevision++;
             m_gameObjects.push_back( go );
+            go->m_membership = msAdded;
+            indexGameObject( m_gameObjectsIndex, go );
+            m_gameObjectsOrderDirty = true;
             go->setParent( this );
             go->setPrefab( m_prefab );
             go->setDestroying( m_isDestroying );
@@ -367,6 +462,7 @@ namespace Ptakopysk
         else
         {
             m_gameObjectsToCreate.push_back( go );
+            go->m_membership = msWaitingToAdd;
             go->setParent( this );
             go->setPrefab( m_prefab );
             go->setDestroying( m_isDestroying );
@@ -375,11 +471,13 @@ namespace Ptakopysk
 
     void GameObject::removeGameObject( GameObject* go )
     {
-        if( !hasGameObject( go ) )
+        if( !hasGameObject( go ) || go->m_membership == msWaitingToRemove )
             return;
         if( m_prefab )
         {
+            s_prefabsRevision++;
             m_gameObjects.remove( go );
+            unindexGameObject( m_gameObjectsIndex, go );
             go->setParent( 0 );
             go->setPrefab( false );
             DELETE_OBJECT( go );
@@ -387,6 +485,7 @@ namespace Ptakopysk
         else
         {
             m_gameObjectsToDestroy.push_back( go );
+            go->m_membership = msWaitingToRemove;
             go->setDestroying( true );
             go->onDestroy();
         }
@@ -395,11 +494,13 @@ namespace Ptakopysk
     void GameObject::removeGameObject( const std::string& id )
     {
         GameObject* go = getGameObject( id );
-        if( !go )
+        if( !go || go->m_membership == msWaitingToRemove )
             return;
         if( m_prefab )
         {
+            s_prefabsRevision++;
             m_gameObjects.remove( go );
+            unindexGameObject( m_gameObjectsIndex, go );
             go->setParent( 0 );
             go->setPrefab( false );
             DELETE_OBJECT( go );
@@ -407,6 +508,7 @@ namespace Ptakopysk
         else
         {
             m_gameObjectsToDestroy.push_back( go );
+            go->m_membership = msWaitingToRemove;
             go->setDestroying( true );
             go->onDestroy();
         }
@@ -417,6 +519,7 @@ namespace Ptakopysk
         GameObject* go;
         if( m_prefab )
         {
+            s_prefabsRevision++;
             for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
             {
                 go = *it;
@@ -425,13 +528,17 @@ namespace Ptakopysk
                 DELETE_OBJECT( go );
             }
             m_gameObjects.clear();
+            m_gameObjectsIndex.clear();
         }
         else
         {
             for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
             {
                 go = *it;
+                if( go->m_membership == msWaitingToRemove )
+                    continue;
                 m_gameObjectsToDestroy.push_back( go );
+                go->m_membership = msWaitingToRemove;
                 go->setDestroying( true );
                 go->onDestroy();
             }
@@ -440,18 +547,12 @@ namespace Ptakopysk
 
     bool GameObject::hasGameObject( GameObject* go )
     {
-        for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
-            if( *it == go )
-                return true;
-        return false;
+        return go && go->isAddedTo( this );
     }
 
     bool GameObject::hasGameObject( const std::string& id )
     {
-        for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
-            if( (*it)->getId() == id )
-                return true;
-        return false;
+        return getGameObject( id ) != 0;
     }
 
     bool GameObject::containsGameObject( GameObject* go )
@@ -464,61 +565,93 @@ namespace Ptakopysk
 
     GameObject* GameObject::getGameObject( const std::string& id )
     {
-        for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
-            if( (*it)->getId() == id )
-                return *it;
-        return 0;
+        return findIndexedGameObject( m_gameObjectsIndex, m_gameObjects, id, 0, id.size(), GameObjectPath::hash( id ) );
+    }
+
+    GameObject* GameObject::getGameObject( const std::string& str, unsigned int from, unsigned int length, unsigned int hash )
+    {
+        return findIndexedGameObject( m_gameObjectsIndex, m_gameObjects, str, from, length, hash );
     }
 
     GameObject* GameObject::findGameObject( const std::string& path )
     {
-        return findGameObjectInPartOfPath( path, 0 );
+        return GameObjectPath::resolve( path, this, 0 );
+    }
+
+    GameObject* GameObject::findGameObject( const GameObjectPath& path )
+    {
+        return GameObjectPath::resolve( path, this, 0 );
     }
 
     void GameObject::processAdding()
     {
+        if( m_gameObjectsToCreate.empty() )
+            return;
+        m_gameObjectsOrderDirty = true;
         GameObject* go;
         for( List::iterator it = m_gameObjectsToCreate.begin(); it != m_gameObjectsToCreate.end(); it++ )
         {
             go = *it;
             m_gameObjects.push_back( go );
+            go->m_membership = msAdded;
+            indexGameObject( m_gameObjectsIndex, go );
+            go->invalidateTransform();
             go->onCreate();
             go->processAdding();
         }
         m_gameObjectsToCreate.clear();
     }
 
+    void GameObject::onFlushPending()
+    {
+        processRemovingDelayedComponents();
+        processAdding();
+        processRemoving();
+        for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
+            (*it)->onFlushPending();
+    }
+
     void GameObject::processRemoving()
     {
+        if( m_gameObjectsToDestroy.empty() )
+            return;
+        for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); )
+        {
+            if( (*it)->m_membership == msWaitingToRemove )
+                it = m_gameObjects.erase( it );
+            else
+                it++;
+        }
         GameObject* go;
         for( List::iterator it = m_gameObjectsToDestroy.begin(); it != m_gameObjectsToDestroy.end(); it++ )
         {
             go = *it;
-            if( std::find( m_gameObjects.begin(), m_gameObjects.end(), go ) == m_gameObjects.end() )
-                continue;
             go->processRemoving();
-            m_gameObjects.remove( go );
+            go->m_membership = msNone;
+            unindexGameObject( m_gameObjectsIndex, go );
             go->setParent( 0 );
             go->setPrefab( false );
-            DELETE_OBJECT( go );
+            GameManager::recycleGameObject( go );
         }
         m_gameObjectsToDestroy.clear();
     }
 
+    void GameObject::sortGameObjects()
+    {
+        if( !m_gameObjectsOrderDirty )
+            return;
+        m_gameObjects.sort( GameManager::CompareGameObjects() );
+        m_gameObjectsOrderDirty = false;
+    }
+
     bool GameObject::isWaitingToAdd( GameObject* go )
     {
-        for( List::iterator it = m_gameObjectsToCreate.begin(); it != m_gameObjectsToCreate.end(); it++ )
-            if( *it == go )
-                return true;
-        return false;
+        return go && go->m_parent == this && go->m_membership == msWaitingToAdd;
     }
 
     bool GameObject::isWaitingToRemove( GameObject* go )
     {
-        for( List::iterator it = m_gameObjectsToDestroy.begin(); it != m_gameObjectsToDestroy.end(); it++ )
-            if( *it == go )
-                return true;
-        return false;
+        return go && go->m_parent == this && go->m_membership == msWaitingToRemove;
     }
 
     Json::Value GameObject::onSerialize( const std::string& property )
@@ -537,17 +670,20 @@ namespace Ptakopysk
     void GameObject::onDeserialize( const std::string& property, const Json::Value& root )
     {
         if( property == "Id" && root.isString() )
-            m_id = root.asString();
+            setId( root.asString() );
         else if( property == "Active" && root.isBool() )
-            m_active = root.asBool();
+            setActive( root.asBool() );
         else if( property == "Order" && root.isInt() )
-            m_order = root.asInt();
+            setOrder( root.asInt() );
         else if( property == "MetaData" )
             m_metaData = root;
     }
 
     void GameObject::onCreate()
     {
+        GameManager* gm = getGameManagerRoot();
+        if( gm && gm->isComponentsPooling() && !m_prefab )
+            attachComponentsToPools( gm );
         for( Components::iterator it = m_components.begin(); it != m_components.end(); it++ )
             it->second->onCreate();
         for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
@@ -559,7 +695,11 @@ namespace Ptakopysk
         for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
             (*it)->onDestroy();
         for( Components::iterator it = m_components.begin(); it != m_components.end(); it++ )
+        {
             it->second->onDestroy();
+            it->second->releaseCulling();
+        }
+        detachComponentsFromPools();
     }
 
     void GameObject::onDuplicate( GameObject* dst )
@@ -589,42 +729,89 @@ namespace Ptakopysk
         dst->removeAllGameObjects();
         for( List::iterator it = m_gameObjectsToCreate.begin(); it != m_gameObjectsToCreate.end(); it++ )
         {
-            GameObject* go = xnew GameObject();
+            GameObject* go = GameManager::buildGameObject();
             dst->addGameObject( go );
             (*it)->onDuplicate( go );
         }
         for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
         {
-            GameObject* go = xnew GameObject();
+            GameObject* go = GameManager::buildGameObject();
             dst->addGameObject( go );
             (*it)->onDuplicate( go );
         }
     }
 
-    void GameObject::onUpdate( float dt, const sf::Transform& trans, bool sort )
+    void GameObject::onUpdate( float dt, const sf::Transform& trans, bool sort, bool transformDirty, unsigned int parallelFrame )
     {
         if( m_active )
         {
+            bool parallelUpdated = parallelFrame && m_updateFrame == parallelFrame;
             processRemovingDelayedComponents();
             Component* c;
-            sf::Transform t = trans;
             for( Components::iterator it = m_components.begin(); it != m_components.end(); it++ )
             {
                 c = it->second;
-                if( c->isActive() )
+                if( !c->isActive() )
+                    continue;
+                if( !parallelUpdated && c->getTypeFlags() & Component::tParallelUpdate )
+                    c->onUpdateParallel( dt );
+                if( c->getTypeFlags() & Component::tUpdate )
                 {
-                    if( c->getTypeFlags() & Component::tUpdate )
-                        c->onUpdate( dt );
-                    if( c->getTypeFlags() & Component::tTransform )
-                        c->onTransform( t, t );
+                    PROFILE_COMPONENT( c, cpUpdate );
+                    c->onUpdate( dt );
                 }
             }
+            m_transformChildDirty = false;
+            transformDirty = processTransform( trans, transformDirty );
             processAdding();
             processRemoving();
             if( sort )
-                m_gameObjects.sort( GameManager::CompareGameObjects() );
+                sortGameObjects();
             for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
-                (*it)->onUpdate( dt, t, sort );
+                (*it)->onUpdate( dt, m_worldTransform, sort, transformDirty, parallelFrame );
+        }
+    }
+
+    void GameObject::onCollectParallelUpdate( std::vector< Component* >& result, unsigned int frame )
+    {
+        if( m_active )
+        {
+            m_updateFrame = frame;
+            Component* c;
+            for( Components::iterator it = m_components.begin(); it != m_components.end(); it++ )
+            {
+                c = it->second;
+                if( c->isActive() && c->getTypeFlags() & Component::tParallelUpdate )
+                    result.push_back( c );
+            }
+            for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
+                (*it)->onCollectParallelUpdate( result, frame );
+        }
+    }
+
+    void GameObject::onUpdatePrepare( unsigned int frame, bool sort )
+    {
+        if( m_active )
+        {
+            m_updateFrame = frame;
+            processRemovingDelayedComponents();
+            processAdding();
+            processRemoving();
+            if( sort )
+                sortGameObjects();
+            for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
+                (*it)->onUpdatePrepare( frame, sort );
+        }
+    }
+
+    void GameObject::onUpdateTransform( const sf::Transform& trans, bool transformDirty )
+    {
+        if( m_active && ( transformDirty || m_transformDirty || m_transformChildDirty ) )
+        {
+            m_transformChildDirty = false;
+            transformDirty = processTransform( trans, transformDirty );
+            for( List::iterator it = m_gameObjects.begin(); it != m_gameObjects.end(); it++ )
+                (*it)->onUpdateTransform( m_worldTransform, transformDirty );
         }
     }
 
@@ -657,11 +844,23 @@ namespace Ptakopysk
                 it++;
             }
             Component* c;
+            SpatialGrid* grid = SpatialGrid::current();
             for( Components::iterator it = m_components.begin(); it != m_components.end(); it++ )
             {
                 c = it->second;
                 if( c->isActive() && c->getTypeFlags() & Component::tRender )
-                    c->onRender( target );
+                {
+                    if( grid && c->m_cullingGrid == grid && !grid->isVisible( c->m_cullingProxy ) )
+                        continue;
+                    PROFILE_COMPONENT( c, cpRender );
+                    SpriteBatch* batch = SpriteBatch::current();
+                    if( !batch || !c->onRenderBatch( *batch, target ) )
+                    {
+                        if( batch )
+                            batch->flush();
+                        c->onRender( target );
+                    }
+                }
             }
             while( it != m_gameObjects.end() )
             {
@@ -671,6 +870,68 @@ namespace Ptakopysk
         }
     }
 
+    void GameObject::onRenderSnapshot( RenderSnapshot& snapshot )
+    {
+        if( m_active )
+        {
+            List::iterator it = m_gameObjects.begin();
+            while( it != m_gameObjects.end() )
+            {
+                if( (*it)->getOrder() <= 0 )
+                    break;
+                (*it)->onRenderSnapshot( snapshot );
+                it++;
+            }
+            Component* c;
+            SpatialGrid* grid = SpatialGrid::current();
+            for( Components::iterator it = m_components.begin(); it != m_components.end(); it++ )
+            {
+                c = it->second;
+                if( c->isActive() && c->getTypeFlags() & Component::tRender )
+                {
+                    if( grid && c->m_cullingGrid == grid && !grid->isVisible( c->m_cullingProxy ) )
+                        continue;
+                    c->onRenderSnapshot( snapshot );
+                }
+            }
+            while( it != m_gameObjects.end() )
+            {
+                (*it)->onRenderSnapshot( snapshot );
+                it++;
+            }
+        }
+    }
+
+    void GameObject::onRenderQueue( RenderQueue& queue )
+    {
+        if( m_active )
+        {
+            List::iterator split = m_gameObjects.begin();
+            while( split != m_gameObjects.end() && (*split)->getOrder() > 0 )
+                split++;
+            onRenderQueueList( m_gameObjects.begin(), split, queue );
+            Component* c;
+            SpatialGrid* grid = SpatialGrid::current();
+            for( Components::iterator it = m_components.begin(); it != m_components.end(); it++ )
+            {
+                c = it->second;
+                if( c->isActive() && c->getTypeFlags() & Component::tRender )
+                {
+                    if( grid && c->m_cullingGrid == grid && !grid->isVisible( c->m_cullingProxy ) )
+                        continue;
+                    c->onRenderQueue( queue );
+                }
+            }
+            onRenderQueueList( split, m_gameObjects.end(), queue );
+        }
+    }
+
+    void GameObject::onRenderQueueList( List::iterator begin, List::iterator end, RenderQueue& queue )
+    {
+        for( List::iterator it = begin; it != end; it++ )
+            (*it)->onRenderQueue( queue );
+    }
+
     void GameObject::onRenderEditor( sf::RenderTarget* target )
     {
         if( m_active )
@@ -790,6 +1051,8 @@ namespace Ptakopysk
 
     void GameObject::setPrefab( bool mode )
     {
+        if( m_prefab || mode )
+            s_prefabsRevision++;
         m_prefab = mode;
         for( List::iterator it = m_gameObjectsToCreate.begin(); it != m_gameObjectsToCreate.end(); it++ )
             (*it)->setPrefab( mode );
@@ -810,69 +1073,130 @@ namespace Ptakopysk
             (*it)->setDestroying( mode );
     }
 
-    GameObject* GameObject::findGameObjectInPartOfPath( const std::string& path, unsigned int from )
+    void GameObject::reset()
     {
-        unsigned int p = path.find( '/', from );
-        bool isRoot = from == 0 && p == 0 && p - from < 1;
-        while( p - from < 1 && p != std::string::npos )
-        {
-            from++;
-            p = path.find( '/', from );
-        }
-        if( isRoot )
+        removeAllComponents();
+        removeAllGameObjects();
+        processRemovingDelayedComponents();
+        processRemoving();
+        for( List::iterator it = m_gameObjectsToCreate.begin(); it != m_gameObjectsToCreate.end(); it++ )
+            GameManager::recycleGameObject( *it );
+        m_gameObjectsToCreate.clear();
+        m_gameObjectsIndex.clear();
+        detachComponentsFromPools();
+        if( m_handleOwner )
+            m_handleOwner->releaseHandle( this );
+        m_gameManager = 0;
+        m_parent = 0;
+        m_instanceOf = 0;
+        m_prefab = false;
+        m_id.clear();
+        m_idHash = GameObjectPath::hash( m_id );
+        m_active = true;
+        m_order = 0;
+        m_isDestroying = false;
+        m_membership = msNone;
+        m_metaData = Json::Value::null;
+        m_updateFrame = 0;
+        m_worldTransform = sf::Transform::Identity;
+        m_transformDirty = true;
+        m_transformChildDirty = false;
+        m_gameObjectsOrderDirty = false;
+    }
+
+    void GameObject::attachComponentsToPools( GameManager* gm )
+    {
+        if( m_componentsPoolsOwner == gm )
+            return;
+        detachComponentsFromPools();
+        m_componentsPoolsOwner = gm;
+        if( !gm )
+            return;
+        for( Components::iterator it = m_components.begin(); it != m_components.end(); it++ )
+            gm->registerComponentInPool( it->second );
+    }
+
+    void GameObject::detachComponentsFromPools()
+    {
+        if( !m_componentsPoolsOwner )
+            return;
+        for( Components::iterator it = m_components.begin(); it != m_components.end(); it++ )
+            m_componentsPoolsOwner->unregisterComponentFromPool( it->second );
+        m_componentsPoolsOwner = 0;
+    }
+
+    void GameObject::destroyComponent( Component* c )
+    {
+        if( m_prefab )
+            s_prefabsRevision++;
+        if( c->getTypeFlags() & Component::tTransform )
+            invalidateTransform();
+        unsigned int slot = componentTypeSlot( c->getType() );
+        if( slot < m_componentsSlots.size() && m_componentsSlots[ slot ] == c )
+            m_componentsSlots[ slot ] = 0;
+        if( m_componentsPoolsOwner )
+            m_componentsPoolsOwner->unregisterComponentFromPool( c );
+        c->setGameObject( 0 );
+        GameManager::recycleComponent( c );
+    }
+
+    bool GameObject::processTransform( const sf::Transform& trans, bool transformDirty )
+    {
+        if( !transformDirty && !m_transformDirty )
+            return false;
+        m_transformDirty = false;
+        Component* c;
+        sf::Transform t = trans;
+        for( Components::iterator it = m_components.begin(); it != m_components.end(); it++ )
         {
-            GameManager* gm = getGameManagerRoot();
-            if( gm )
-                return gm->findGameObject( std::string( path, 1, std::string::npos ) );
-            else
-                return 0;
+            c = it->second;
+            if( c->isActive() && c->getTypeFlags() & Component::tTransform )
+            {
+                c->onTransform( t, t );
+                if( c->getTypeFlags() & Component::tRender )
+                    c->updateCulling();
+            }
         }
+        m_worldTransform = t;
+        return true;
+    }
+
+    void GameObject::indexGameObject( IdsIndex& index, GameObject* go )
+    {
+        IdsIndexEntry& entry = index[ go->m_idHash ];
+        entry.object = entry.count ? 0 : go;
+        entry.count++;
+    }
+
+    void GameObject::unindexGameObject( IdsIndex& index, GameObject* go )
+    {
+        IdsIndex::iterator it = index.find( go->m_idHash );
+        if( it == index.end() )
+            return;
+        if( --it->second.count )
+            it->second.object = 0;
         else
+            index.erase( it );
+    }
+
+    GameObject* GameObject::findIndexedGameObject( IdsIndex& index, List& list, const std::string& str, unsigned int from, unsigned int length, unsigned int hash )
+    {
+        IdsIndex::iterator it = index.find( hash );
+        if( it == index.end() )
+            return 0;
+        IdsIndexEntry& entry = it->second;
+        GameObject* go = entry.object;
+        if( !go )
         {
-            std::string part = std::string( path, from, p );
-            if( part.empty() )
-                return 0;
-            else if( part == "." )
+            for( List::iterator itl = list.begin(); itl != list.end(); itl++ )
             {
-                if( p == std::string::npos )
-                    return this;
-                else
-                    return findGameObjectInPartOfPath( path, p + 1 );
-            }
-            else if( part == ".." )
-            {
-                if( p == std::string::npos )
-                {
-                    if( getParent() )
-                        return getParent();
-                    else
-                        return 0;
-                }
-                else
-                {
-                    if( getParent() )
-                        return getParent()->findGameObjectInPartOfPath( path, p + 1 );
-                    else if( getGameManager() )
-                        return getGameManager()->findGameObject( std::string( path, p + 1, std::string::npos ) );
-                    else
-                        return 0;
-                }
-            }
-            else
-            {
-                GameObject* go = getGameObject( part );
-                if( go )
-                {
-                    if( p == std::string::npos )
-                        return go;
-                    else
-                        return go->findGameObjectInPartOfPath( path, p + 1 );
-                }
-                else
-                    return 0;
+                go = *itl;
+                if( go->m_idHash == hash && go->m_id.size() == length && str.compare( from, length, go->m_id ) == 0 )
+                    return go;
             }
+            return 0;
         }
-        return 0;
+        return go->m_id.size() == length && str.compare( from, length, go->m_id ) == 0 ? go : 0;
     }
 
 }
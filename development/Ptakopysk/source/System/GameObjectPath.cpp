@@ -0,0 +1,183 @@
+#include "../../include/Ptakopysk/System/GameObjectPath.h"
+#include "../../include/Ptakopysk/System/GameObject.h"
+#include "../../include/Ptakopysk/System/GameManager.h"
+
+namespace Ptakopysk
+{
+
+    class PathSegmentsReader
+    {
+    public:
+        PathSegmentsReader( const std::string& path ) : m_path( path ), m_from( 0 ) {};
+
+        FORCEINLINE bool next( GameObjectPath::Segment& result ) { return GameObjectPath::nextSegment( m_path, m_from, result ); };
+
+    private:
+        const std::string& m_path;
+        unsigned int m_from;
+    };
+
+    class CompiledSegmentsReader
+    {
+    public:
+        CompiledSegmentsReader( const GameObjectPath& path ) : m_path( path ), m_index( 0 ) {};
+
+        FORCEINLINE bool next( GameObjectPath::Segment& result ) { if( m_index >= m_path.segmentsCount() ) return false; result = m_path.segmentAt( m_index++ ); return true; };
+
+    private:
+        const GameObjectPath& m_path;
+        unsigned int m_index;
+    };
+
+    template< typename T >
+    GameObject* walkGameObjectPath( T& reader, const std::string& path, GameObject* go, GameManager* gm )
+    {
+        GameObjectPath::Segment s;
+        bool any = false;
+        while( reader.next( s ) )
+        {
+            any = true;
+            if( s.type == GameObjectPath::stCurrent )
+                continue;
+            else if( s.type == GameObjectPath::stParent )
+            {
+                if( !go )
+                    return 0;
+                else if( go->getParent() )
+                    go = go->getParent();
+                else if( go->getGameManager() )
+                {
+                    gm = go->getGameManager();
+                    go = 0;
+                }
+                else
+                    return 0;
+            }
+            else
+            {
+                if( go )
+                    go = go->getGameObject( path, s.from, s.length, s.hash );
+                else if( gm )
+                    go = gm->getGameObject( path, s.from, s.length, s.hash );
+                if( !go )
+                    return 0;
+            }
+        }
+        return any ? go : 0;
+    }
+
+    RTTI_CLASS_DERIVATIONS( GameObjectPath,
+                            RTTI_DERIVATIONS_END
+                            )
+
+    GameObjectPath::GameObjectPath( const std::string& path )
+    : RTTI_CLASS_DEFINE( GameObjectPath )
+    , m_valid( false )
+    , m_absolute( false )
+    {
+        compile( path );
+    }
+
+    GameObjectPath::GameObjectPath( const GameObjectPath& path )
+    : RTTI_CLASS_DEFINE( GameObjectPath )
+    , m_path( path.m_path )
+    , m_valid( path.m_valid )
+    , m_absolute( path.m_absolute )
+    , m_segments( path.m_segments )
+    {
+    }
+
+    GameObjectPath::~GameObjectPath()
+    {
+    }
+
+    GameObjectPath& GameObjectPath::operator=( const GameObjectPath& path )
+    {
+        m_path = path.m_path;
+        m_valid = path.m_valid;
+        m_absolute = path.m_absolute;
+        m_segments = path.m_segments;
+        return *this;
+    }
+
+    unsigned int GameObjectPath::hash( const std::string& str, std::string::size_type from, std::string::size_type length )
+    {
+        std::string::size_type to = length == std::string::npos || from + length > str.size() ? str.size() : from + length;
+        unsigned int h = 2166136261u;
+        for( std::string::size_type i = from; i < to; i++ )
+        {
+            h ^= (unsigned char)str[ i ];
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    bool GameObjectPath::isValid( const std::string& path )
+    {
+        return !path.empty() && path[ path.size() - 1 ] != '/';
+    }
+
+    bool GameObjectPath::nextSegment( const std::string& path, unsigned int& from, Segment& result )
+    {
+        unsigned int size = path.size();
+        while( from < size && path[ from ] == '/' )
+            from++;
+        if( from >= size )
+            return false;
+        std::string::size_type p = path.find( '/', from );
+        if( p == std::string::npos )
+            p = size;
+        result.from = from;
+        result.length = p - from;
+        if( result.length == 1 && path[ from ] == '.' )
+            result.type = stCurrent;
+        else if( result.length == 2 && path[ from ] == '.' && path[ from + 1 ] == '.' )
+            result.type = stParent;
+        else
+            result.type = stName;
+        result.hash = result.type == stName ? hash( path, result.from, result.length ) : 0;
+        from = p;
+        return true;
+    }
+
+    GameObject* GameObjectPath::resolve( const std::string& path, GameObject* go, GameManager* gm )
+    {
+        if( !isValid( path ) )
+            return 0;
+        if( path[ 0 ] == '/' && go )
+        {
+            gm = go->getGameManagerRoot();
+            go = 0;
+        }
+        PathSegmentsReader reader( path );
+        return walkGameObjectPath( reader, path, go, gm );
+    }
+
+    GameObject* GameObjectPath::resolve( const GameObjectPath& path, GameObject* go, GameManager* gm )
+    {
+        if( !path.isValid() )
+            return 0;
+        if( path.isAbsolute() && go )
+        {
+            gm = go->getGameManagerRoot();
+            go = 0;
+        }
+        CompiledSegmentsReader reader( path );
+        return walkGameObjectPath( reader, path.getPath(), go, gm );
+    }
+
+    void GameObjectPath::compile( const std::string& path )
+    {
+        m_path = path;
+        m_valid = isValid( path );
+        m_absolute = m_valid && path[ 0 ] == '/';
+        m_segments.clear();
+        if( !m_valid )
+            return;
+        Segment s;
+        unsigned int from = 0;
+        while( nextSegment( m_path, from, s ) )
+            m_segments.push_back( s );
+    }
+
+}
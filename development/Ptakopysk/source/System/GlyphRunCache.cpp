@@ -0,0 +1,227 @@
+#include "../../include/Ptakopysk/System/GlyphRunCache.h"
+#include <SFML/Graphics/Text.hpp>
+#include <algorithm>
+
+namespace Ptakopysk
+{
+
+    RTTI_CLASS_DERIVATIONS( GlyphRunCache,
+                            RTTI_DERIVATIONS_END
+                            )
+
+    GlyphRunCache::GlyphRunCache( unsigned int capacity )
+    : RTTI_CLASS_DEFINE( GlyphRunCache )
+    , m_capacity( capacity )
+    , m_frame( 0 )
+    , m_revision( nextRevision() )
+    , m_hits( 0 )
+    , m_misses( 0 )
+    {
+        caches().push_back( this );
+    }
+
+    GlyphRunCache::~GlyphRunCache()
+    {
+        clear();
+        std::vector< GlyphRunCache* >& list = caches();
+        list.erase( std::find( list.begin(), list.end(), this ) );
+    }
+
+    GlyphRunCache& GlyphRunCache::use()
+    {
+        static GlyphRunCache s_instance;
+        return s_instance;
+    }
+
+    void GlyphRunCache::removeFontFromAll( const sf::Font* font )
+    {
+        std::vector< GlyphRunCache* >& list = caches();
+        for( std::vector< GlyphRunCache* >::iterator it = list.begin(); it != list.end(); it++ )
+            (*it)->removeFont( font );
+    }
+
+    tthread::mutex& GlyphRunCache::fontsMutex()
+    {
+        static tthread::mutex s_mutex;
+        return s_mutex;
+    }
+
+    void GlyphRunCache::layout( Run& run, const std::basic_string< sf::Uint32 >& text, const sf::Font& font, unsigned int size, unsigned int style )
+    {
+        tthread::lock_guard< tthread::mutex > guard( fontsMutex() );
+        run.vertices.clear();
+        run.bounds = sf::FloatRect();
+        run.texture = &font.getTexture( size );
+        if( text.empty() )
+            return;
+        bool bold = ( style & sf::Text::Bold ) != 0;
+        bool underlined = ( style & sf::Text::Underlined ) != 0;
+        float italic = ( style & sf::Text::Italic ) ? 0.208f : 0.0f;
+        float underlineOffset = (float)size * 0.1f;
+        float underlineThickness = (float)size * ( bold ? 0.1f : 0.07f );
+        float hspace = (float)font.getGlyph( L' ', size, bold ).advance;
+        float vspace = (float)font.getLineSpacing( size );
+        float x = 0.0f;
+        float y = (float)size;
+        float minX = (float)size;
+        float minY = (float)size;
+        float maxX = 0.0f;
+        float maxY = 0.0f;
+        float top, bottom, left, right;
+        sf::Uint32 prev = 0;
+        sf::Uint32 cur;
+        sf::Color white = sf::Color::White;
+        for( std::basic_string< sf::Uint32 >::const_iterator it = text.begin(); it != text.end(); it++ )
+        {
+            cur = *it;
+            x += (float)font.getKerning( prev, cur, size );
+            prev = cur;
+            if( underlined && cur == L'\n' )
+            {
+                top = y + underlineOffset;
+                bottom = top + underlineThickness;
+                run.vertices.push_back( sf::Vertex( sf::Vector2f( 0.0f, top ), white, sf::Vector2f( 1.0f, 1.0f ) ) );
+                run.vertices.push_back( sf::Vertex( sf::Vector2f( x, top ), white, sf::Vector2f( 1.0f, 1.0f ) ) );
+                run.vertices.push_back( sf::Vertex( sf::Vector2f( x, bottom ), white, sf::Vector2f( 1.0f, 1.0f ) ) );
+                run.vertices.push_back( sf::Vertex( sf::Vector2f( 0.0f, bottom ), white, sf::Vector2f( 1.0f, 1.0f ) ) );
+            }
+            if( cur == L' ' || cur == L'\t' || cur == L'\n' || cur == L'\v' )
+            {
+                minX = std::min( minX, x );
+                minY = std::min( minY, y );
+                if( cur == L' ' )
+                    x += hspace;
+                else if( cur == L'\t' )
+                    x += hspace * 4.0f;
+                else if( cur == L'\n' )
+                {
+                    y += vspace;
+                    x = 0.0f;
+                }
+                else
+                    y += vspace * 4.0f;
+                maxX = std::max( maxX, x );
+                maxY = std::max( maxY, y );
+                continue;
+            }
+            const sf::Glyph& glyph = font.getGlyph( cur, size, bold );
+            left = (float)glyph.bounds.left;
+            top = (float)glyph.bounds.top;
+            right = (float)( glyph.bounds.left + glyph.bounds.width );
+            bottom = (float)( glyph.bounds.top + glyph.bounds.height );
+            float u1 = (float)glyph.textureRect.left;
+            float v1 = (float)glyph.textureRect.top;
+            float u2 = (float)( glyph.textureRect.left + glyph.textureRect.width );
+            float v2 = (float)( glyph.textureRect.top + glyph.textureRect.height );
+            run.vertices.push_back( sf::Vertex( sf::Vector2f( x + left - italic * top, y + top ), white, sf::Vector2f( u1, v1 ) ) );
+            run.vertices.push_back( sf::Vertex( sf::Vector2f( x + right - italic * top, y + top ), white, sf::Vector2f( u2, v1 ) ) );
+            run.vertices.push_back( sf::Vertex( sf::Vector2f( x + right - italic * bottom, y + bottom ), white, sf::Vector2f( u2, v2 ) ) );
+            run.vertices.push_back( sf::Vertex( sf::Vector2f( x + left - italic * bottom, y + bottom ), white, sf::Vector2f( u1, v2 ) ) );
+            minX = std::min( minX, x + left - italic * bottom );
+            maxX = std::max( maxX, x + right - italic * top );
+            minY = std::min( minY, y + top );
+            maxY = std::max( maxY, y + bottom );
+            x += (float)glyph.advance;
+        }
+        if( underlined )
+        {
+            top = y + underlineOffset;
+            bottom = top + underlineThickness;
+            run.vertices.push_back( sf::Vertex( sf::Vector2f( 0.0f, top ), white, sf::Vector2f( 1.0f, 1.0f ) ) );
+            run.vertices.push_back( sf::Vertex( sf::Vector2f( x, top ), white, sf::Vector2f( 1.0f, 1.0f ) ) );
+            run.vertices.push_back( sf::Vertex( sf::Vector2f( x, bottom ), white, sf::Vector2f( 1.0f, 1.0f ) ) );
+            run.vertices.push_back( sf::Vertex( sf::Vector2f( 0.0f, bottom ), white, sf::Vector2f( 1.0f, 1.0f ) ) );
+        }
+        run.bounds = sf::FloatRect( minX, minY, maxX - minX, maxY - minY );
+    }
+
+    GlyphRunCache::Run* GlyphRunCache::acquire( const sf::String& text, const sf::Font* font, unsigned int size, unsigned int style )
+    {
+        if( !font )
+            return 0;
+        Key key;
+        key.text.assign( text.getData(), text.getSize() );
+        key.font = font;
+        key.size = size;
+        key.style = style;
+        Runs::iterator it = m_runs.find( key );
+        if( it != m_runs.end() )
+        {
+            touch( &it->second );
+            return &it->second;
+        }
+        Run& run = m_runs[ key ];
+        layout( run, key.text, *font, size, style );
+        run.lastFrame = m_frame;
+        m_misses++;
+        return &run;
+    }
+
+    void GlyphRunCache::removeFont( const sf::Font* font )
+    {
+        bool removed = false;
+        for( Runs::iterator it = m_runs.begin(); it != m_runs.end(); )
+        {
+            if( it->first.font == font )
+            {
+                m_runs.erase( it++ );
+                removed = true;
+            }
+            else
+                it++;
+        }
+        if( removed )
+            m_revision = nextRevision();
+    }
+
+    void GlyphRunCache::endFrame()
+    {
+        if( m_runs.size() > m_capacity )
+        {
+            bool removed = false;
+            for( Runs::iterator it = m_runs.begin(); it != m_runs.end(); )
+            {
+                if( it->second.lastFrame != m_frame )
+                {
+                    m_runs.erase( it++ );
+                    removed = true;
+                }
+                else
+                    it++;
+            }
+            if( removed )
+                m_revision = nextRevision();
+        }
+        m_frame++;
+    }
+
+    void GlyphRunCache::clear()
+    {
+        m_runs.clear();
+        m_revision = nextRevision();
+    }
+
+    bool GlyphRunCache::Key::operator<( const Key& other ) const
+    {
+        if( font != other.font )
+            return font < other.font;
+        if( size != other.size )
+            return size < other.size;
+        if( style != other.style )
+            return style < other.style;
+        return text < other.text;
+    }
+
+    std::vector< GlyphRunCache* >& GlyphRunCache::caches()
+    {
+        static std::vector< GlyphRunCache* > s_caches;
+        return s_caches;
+    }
+
+    unsigned int GlyphRunCache::nextRevision()
+    {
+        static unsigned int s_revision = 0;
+        return __sync_add_and_fetch( &s_revision, 1 );
+    }
+
+}
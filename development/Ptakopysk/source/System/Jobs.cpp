@@ -0,0 +1,358 @@
+#include "../../include/Ptakopysk/System/Jobs.h"
+#include "../../include/Ptakopysk/System/FrameAllocator.h"
+
+namespace Ptakopysk
+{
+
+    class Jobs::Worker
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    , public XeCore::Common::Concurrent::Thread
+    {
+        RTTI_CLASS_DECLARE( Worker );
+
+    public:
+        Worker( Jobs* owner, unsigned int index );
+        virtual ~Worker() {};
+
+        virtual void run() { m_owner->processWorker( m_index ); };
+
+    private:
+        Jobs* m_owner;
+        unsigned int m_index;
+    };
+
+    class Jobs::ParallelForBatch
+    : public virtual XeCore::Common::IRtti
+    , public virtual XeCore::Common::MemoryManager::Manageable
+    , public Job
+    {
+        RTTI_CLASS_DECLARE( ParallelForBatch );
+
+    public:
+        ParallelForBatch( IParallelForJob* job, unsigned int from, unsigned int to );
+
+    protected:
+        virtual void onExecute() { m_job->onExecute( m_from, m_to ); };
+
+    private:
+        IParallelForJob* m_job;
+        unsigned int m_from;
+        unsigned int m_to;
+    };
+
+    RTTI_CLASS_DERIVATIONS( Jobs::Worker,
+                            RTTI_DERIVATION( XeCore::Common::Concurrent::Thread ),
+                            RTTI_DERIVATIONS_END
+                            )
+
+    Jobs::Worker::Worker( Jobs* owner, unsigned int index )
+    : RTTI_CLASS_DEFINE( Worker )
+    , m_owner( owner )
+    , m_index( index )
+    {
+    }
+
+    RTTI_CLASS_DERIVATIONS( Jobs::ParallelForBatch,
+                            RTTI_DERIVATION( Job ),
+                            RTTI_DERIVATIONS_END
+                            )
+
+    Jobs::ParallelForBatch::ParallelForBatch( IParallelForJob* job, unsigned int from, unsigned int to )
+    : RTTI_CLASS_DEFINE( ParallelForBatch )
+    , m_job( job )
+    , m_from( from )
+    , m_to( to )
+    {
+    }
+
+    RTTI_CLASS_DERIVATIONS( JobsFence,
+                            RTTI_DERIVATIONS_END
+                            )
+
+    JobsFence::JobsFence()
+    : RTTI_CLASS_DEFINE( JobsFence )
+    , m_pending( 0 )
+    {
+    }
+
+    JobsFence::~JobsFence()
+    {
+    }
+
+    RTTI_CLASS_DERIVATIONS( Job,
+                            RTTI_DERIVATIONS_END
+                            )
+
+    Job::Job()
+    : RTTI_CLASS_DEFINE( Job )
+    , m_done( 0 )
+    , m_submitted( false )
+    , m_waiting( 0 )
+    , m_fence( 0 )
+    {
+    }
+
+    Job::~Job()
+    {
+    }
+
+    RTTI_CLASS_DERIVATIONS( Jobs,
+                            RTTI_DERIVATIONS_END
+                            )
+
+    Jobs::Jobs( unsigned int workersCount )
+    : RTTI_CLASS_DEFINE( Jobs )
+    , m_nextQueue( 0 )
+    , m_queued( 0 )
+    , m_sleeping( 0 )
+    , m_working( true )
+    {
+        unsigned int queues = workersCount ? workersCount : 1;
+        m_queues.resize( queues );
+        for( unsigned int i = 0; i < queues; i++ )
+            m_queuesSync.push_back( xnew XeCore::Common::Concurrent::Synchronized() );
+        for( unsigned int i = 0; i < workersCount; i++ )
+        {
+            Worker* w = xnew Worker( this, i );
+            m_workers.push_back( w );
+            w->start();
+        }
+    }
+
+    Jobs::~Jobs()
+    {
+        m_stateMutex.lock();
+        m_working = false;
+        m_workCondition.notify_all();
+        m_stateMutex.unlock();
+        Worker* w;
+        for( std::vector< Worker* >::iterator it = m_workers.begin(); it != m_workers.end(); it++ )
+        {
+            w = *it;
+            w->join();
+            DELETE_OBJECT( w );
+        }
+        m_workers.clear();
+        while( processJob() );
+        XeCore::Common::Concurrent::Synchronized* s;
+        for( std::vector< XeCore::Common::Concurrent::Synchronized* >::iterator it = m_queuesSync.begin(); it != m_queuesSync.end(); it++ )
+        {
+            s = *it;
+            DELETE_OBJECT( s );
+        }
+        m_queuesSync.clear();
+    }
+
+    unsigned int Jobs::autoWorkersCount()
+    {
+        unsigned int c = XeCore::Common::Concurrent::Thread::hardwareConcurrency();
+        return c > 1 ? c - 1 : 0;
+    }
+
+    bool Jobs::addDependency( Job* job, Job* dependency )
+    {
+        if( !job || !dependency || job == dependency )
+            return false;
+        tthread::lock_guard< tthread::mutex > guard( m_stateMutex );
+        if( job->m_submitted && !job->m_done )
+            return false;
+        if( dependency->m_submitted && dependency->m_done )
+            return true;
+        dependency->m_continuations.push_back( job );
+        job->m_waiting++;
+        return true;
+    }
+
+    bool Jobs::submit( Job* job, JobsFence* fence )
+    {
+        if( !job )
+            return false;
+        bool ready = false;
+        {
+            tthread::lock_guard< tthread::mutex > guard( m_stateMutex );
+            if( job->m_submitted && !job->m_done )
+                return false;
+            job->m_submitted = true;
+            job->m_done = 0;
+            job->m_fence = fence;
+            if( fence )
+                __sync_add_and_fetch( &fence->m_pending, 1 );
+            ready = !job->m_waiting;
+        }
+        if( ready )
+            enqueue( job );
+        return true;
+    }
+
+    void Jobs::wait( JobsFence* fence )
+    {
+        if( fence )
+            help( fence, 0 );
+    }
+
+    void Jobs::wait( Job* job )
+    {
+        if( job && job->m_submitted )
+            help( 0, job );
+    }
+
+    void Jobs::parallelFor( IParallelForJob* job, unsigned int count, unsigned int batchSize, FrameAllocator* scratch )
+    {
+        if( !job || !count )
+            return;
+        if( !batchSize )
+            batchSize = count / ( ( m_workers.size() + 1 ) * 4 );
+        if( !batchSize )
+            batchSize = 1;
+        if( m_workers.empty() || count <= batchSize )
+        {
+            job->onExecute( 0, count );
+            return;
+        }
+        JobsFence fence;
+        unsigned int batchesCount = ( count - 1 ) / batchSize;
+        unsigned int marker = scratch ? scratch->getMarker() : 0;
+        ParallelForBatch** batches = scratch ? scratch->allocateArray< ParallelForBatch* >( batchesCount ) : xnew ParallelForBatch*[ batchesCount ];
+        unsigned int from = batchSize;
+        for( unsigned int i = 0; i < batchesCount; i++, from += batchSize )
+        {
+            ParallelForBatch* b = scratch ? ::new( scratch->allocate( sizeof( ParallelForBatch ) ) ) ParallelForBatch( job, from, from + batchSize < count ? from + batchSize : count ) : xnew ParallelForBatch( job, from, from + batchSize < count ? from + batchSize : count );
+            batches[ i ] = b;
+            submit( b, &fence );
+        }
+        job->onExecute( 0, batchSize );
+        wait( &fence );
+        ParallelForBatch* b;
+        for( unsigned int i = 0; i < batchesCount; i++ )
+        {
+            b = batches[ i ];
+            if( scratch )
+                b->~ParallelForBatch();
+            else
+                DELETE_OBJECT( b );
+        }
+        if( scratch )
+            scratch->rewind( marker );
+        else
+            DELETE_ARRAY( batches );
+    }
+
+    bool Jobs::processJob()
+    {
+        Job* job = takeJob( m_queues.size() );
+        if( !job )
+            return false;
+        execute( job );
+        return true;
+    }
+
+    void Jobs::processWorker( unsigned int index )
+    {
+        Job* job;
+        while( true )
+        {
+            job = takeJob( index );
+            if( job )
+            {
+                execute( job );
+                continue;
+            }
+            tthread::lock_guard< tthread::mutex > guard( m_stateMutex );
+            __sync_add_and_fetch( &m_sleeping, 1 );
+            while( m_working && !__sync_fetch_and_add( &m_queued, 0 ) )
+                m_workCondition.wait( m_stateMutex );
+            __sync_sub_and_fetch( &m_sleeping, 1 );
+            if( !m_working )
+                return;
+        }
+    }
+
+    void Jobs::help( JobsFence* fence, Job* job )
+    {
+        while( true )
+        {
+            if( fence ? fence->isSignaled() : job->isDone() )
+                return;
+            if( processJob() )
+                continue;
+            tthread::lock_guard< tthread::mutex > guard( m_stateMutex );
+            __sync_add_and_fetch( &m_sleeping, 1 );
+            while( !__sync_fetch_and_add( &m_queued, 0 ) && ( fence ? !fence->isSignaled() : !job->isDone() ) )
+                m_doneCondition.wait( m_stateMutex );
+            __sync_sub_and_fetch( &m_sleeping, 1 );
+        }
+    }
+
+    void Jobs::enqueue( Job* job )
+    {
+        unsigned int q = __sync_fetch_and_add( &m_nextQueue, 1 ) % m_queues.size();
+        m_queuesSync[ q ]->lock();
+        m_queues[ q ].push_back( job );
+        m_queuesSync[ q ]->unlock();
+        __sync_add_and_fetch( &m_queued, 1 );
+        // sleepers register before re-checking m_queued, so the state lock is needed only to wake them.
+        if( !__sync_fetch_and_add( &m_sleeping, 0 ) )
+            return;
+        tthread::lock_guard< tthread::mutex > guard( m_stateMutex );
+        m_workCondition.notify_one();
+        m_doneCondition.notify_all();
+    }
+
+    Job* Jobs::takeJob( unsigned int queue )
+    {
+        unsigned int count = m_queues.size();
+        unsigned int q;
+        Job* job = 0;
+        for( unsigned int i = 0; i < count && !job; i++ )
+        {
+            q = ( queue + i ) % count;
+            m_queuesSync[ q ]->lock();
+            if( !m_queues[ q ].empty() )
+            {
+                if( !i && queue < count )
+                {
+                    job = m_queues[ q ].back();
+                    m_queues[ q ].pop_back();
+                }
+                else
+                {
+                    job = m_queues[ q ].front();
+                    m_queues[ q ].pop_front();
+                }
+            }
+            m_queuesSync[ q ]->unlock();
+        }
+        if( job )
+            __sync_sub_and_fetch( &m_queued, 1 );
+        return job;
+    }
+
+    void Jobs::execute( Job* job )
+    {
+        job->onExecute();
+        std::vector< Job* > ready;
+        {
+            tthread::lock_guard< tthread::mutex > guard( m_stateMutex );
+            Job* c;
+            for( std::vector< Job* >::iterator it = job->m_continuations.begin(); it != job->m_continuations.end(); it++ )
+            {
+                c = *it;
+                if( c->m_waiting )
+                    c->m_waiting--;
+                if( !c->m_waiting && c->m_submitted && !c->m_done )
+                    ready.push_back( c );
+            }
+            job->m_continuations.clear();
+            if( job->m_fence )
+                __sync_sub_and_fetch( &job->m_fence->m_pending, 1 );
+            job->m_fence = 0;
+            __sync_synchronize();
+            job->m_done = 1;
+            m_doneCondition.notify_all();
+        }
+        for( std::vector< Job* >::iterator it = ready.begin(); it != ready.end(); it++ )
+            enqueue( *it );
+    }
+
+}
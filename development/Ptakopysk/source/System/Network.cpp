@@ -1,4 +1,5 @@
 #include "../../include/Ptakopysk/System/Network.h"
+#include "../../include/Ptakopysk/System/Allocations.h"
 #include <sstream>
 
 namespace Ptakopysk
@@ -258,6 +259,7 @@ namespace Ptakopysk
 
     void Network::process()
     {
+        ALLOCATIONS_SCOPE( sNetwork );
         if( m_sync.tryLock() )
         {
             for( std::map< std::string, Client* >::iterator it = m_clients.begin(); it != m_clients.end(); it++ )
@@ -295,6 +297,7 @@ namespace Ptakopysk
 
     bool Network::sendPacketToClients( sf::Packet& packet, Client* excludeClient )
     {
+        ALLOCATIONS_SCOPE( sNetwork );
         if( m_sync.tryLock() )
         {
             for( std::map< std::string, Client* >::iterator it = m_clients.begin(); it != m_clients.end(); it++ )
@@ -308,12 +311,14 @@ namespace Ptakopysk
 
     void Network::sendPacketToClientsDelayed( sf::Packet& packet, Client* excludeClient )
     {
+        ALLOCATIONS_SCOPE( sNetwork );
         SYNCHRONIZED_OBJECT( m_syncToSend );
         m_packetsToSend.push_back( DelayedPacket( packet, excludeClient ) );
     }
 
     void Network::run()
     {
+        ALLOCATIONS_SCOPE( sNetwork );
         m_working = true;
         while( true )
         {
@@ -363,6 +368,7 @@ namespace Ptakopysk
 
     void Network::Server::run()
     {
+        ALLOCATIONS_SCOPE( sNetwork );
         if( m_listener.listen( m_port ) != sf::Socket::Done )
             return;
         m_listener.setBlocking( false );
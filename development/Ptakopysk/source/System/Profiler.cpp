@@ -0,0 +1,227 @@
+#include "../../include/Ptakopysk/System/Profiler.h"
+#include "../../include/Ptakopysk/System/GameManager.h"
+#include <fstream>
+
+namespace Ptakopysk
+{
+
+    RTTI_CLASS_DERIVATIONS( Profiler,
+                            RTTI_DERIVATIONS_END
+                            )
+
+    Profiler::Profiler()
+    : RTTI_CLASS_DEFINE( Profiler )
+    , m_enabled( true )
+    , m_frameActive( false )
+    , m_framesCount( 0 )
+    , m_traceFramesLimit( DEFAULT_TRACE_FRAMES_LIMIT )
+    , m_currentZone( -1 )
+    {
+        m_frame.index = 0;
+        m_frame.start = 0;
+        m_frame.duration = 0;
+        m_lastFrame = m_frame;
+    }
+
+    Profiler::~Profiler()
+    {
+        reset();
+    }
+
+    Profiler::Stats Profiler::getZoneStats( const std::string& name )
+    {
+        ZonesStats::iterator it = m_zonesStats.find( name );
+        if( it != m_zonesStats.end() )
+            return it->second;
+        Stats s = { 0, 0, 0 };
+        return s;
+    }
+
+    Profiler::Stats Profiler::getComponentStats( XeCore::Common::IRtti::Derivation type, ComponentPhase phase )
+    {
+        ComponentsStats::iterator it = m_componentsStats[ phase ].find( type );
+        if( it != m_componentsStats[ phase ].end() )
+            return it->second;
+        Stats s = { 0, 0, 0 };
+        return s;
+    }
+
+    void Profiler::beginFrame()
+    {
+        if( !m_enabled || m_frameActive )
+            return;
+        m_frameActive = true;
+        m_currentZone = -1;
+        m_frame.index = m_framesCount;
+        m_frame.zones.clear();
+        m_frame.start = now();
+        m_frame.duration = 0;
+    }
+
+    void Profiler::endFrame()
+    {
+        if( !m_frameActive )
+            return;
+        m_frameActive = false;
+        m_currentZone = -1;
+        m_frame.duration = now() - m_frame.start;
+        accumulate( m_zonesStats[ "Frame" ], m_frame.duration );
+        m_framesCount++;
+        m_lastFrame = m_frame;
+        if( !m_traceFramesLimit )
+            return;
+        m_trace.push_back( m_frame );
+        while( m_trace.size() > m_traceFramesLimit )
+            m_trace.pop_front();
+    }
+
+    int Profiler::beginZone( const char* name )
+    {
+        if( !m_enabled || !m_frameActive )
+            return -1;
+        Zone z;
+        z.name = name;
+        z.parent = m_currentZone;
+        z.depth = m_currentZone < 0 ? 0 : m_frame.zones[ m_currentZone ].depth + 1;
+        z.duration = 0;
+        m_currentZone = m_frame.zones.size();
+        m_frame.zones.push_back( z );
+        m_frame.zones.back().start = now();
+        return m_currentZone;
+    }
+
+    void Profiler::endZone( int index )
+    {
+        if( index < 0 || !m_frameActive || index >= (int)m_frame.zones.size() )
+            return;
+        Zone& z = m_frame.zones[ index ];
+        z.duration = now() - z.start;
+        m_currentZone = z.parent;
+        accumulate( m_zonesStats[ z.name ], z.duration );
+    }
+
+    void Profiler::addComponentSample( XeCore::Common::IRtti::Derivation type, ComponentPhase phase, sf::Int64 time )
+    {
+        if( m_enabled && phase < cpCount )
+            accumulate( m_componentsStats[ phase ][ type ], time );
+    }
+
+    void Profiler::reset()
+    {
+        m_framesCount = 0;
+        m_frameActive = false;
+        m_currentZone = -1;
+        m_frame.zones.clear();
+        m_lastFrame.zones.clear();
+        m_trace.clear();
+        m_zonesStats.clear();
+        for( unsigned int i = 0; i < cpCount; i++ )
+            m_componentsStats[ i ].clear();
+    }
+
+    Json::Value Profiler::statsToJson()
+    {
+        Json::Value root;
+        root[ "frames" ] = Json::Value( m_framesCount );
+        Json::Value lastFrame;
+        lastFrame[ "index" ] = Json::Value( m_lastFrame.index );
+        lastFrame[ "time" ] = Json::Value( (double)m_lastFrame.duration );
+        Json::Value zones( Json::arrayValue );
+        Json::Value item;
+        for( std::vector< Zone >::const_iterator it = m_lastFrame.zones.begin(); it != m_lastFrame.zones.end(); it++ )
+        {
+            item = Json::Value( Json::objectValue );
+            item[ "name" ] = Json::Value( it->name );
+            item[ "depth" ] = Json::Value( it->depth );
+            item[ "start" ] = Json::Value( (double)( it->start - m_lastFrame.start ) );
+            item[ "time" ] = Json::Value( (double)it->duration );
+            zones.append( item );
+        }
+        lastFrame[ "zones" ] = zones;
+        root[ "lastFrame" ] = lastFrame;
+        Json::Value zonesStats( Json::objectValue );
+        for( ZonesStats::iterator it = m_zonesStats.begin(); it != m_zonesStats.end(); it++ )
+        {
+            item = Json::Value( Json::objectValue );
+            item[ "calls" ] = Json::Value( it->second.calls );
+            item[ "time" ] = Json::Value( (double)it->second.time );
+            item[ "maxTime" ] = Json::Value( (double)it->second.maxTime );
+            zonesStats[ it->first ] = item;
+        }
+        root[ "zones" ] = zonesStats;
+        Json::Value componentsStats( Json::objectValue );
+        const char* phases[ cpCount ] = { "update", "render" };
+        std::string id;
+        for( unsigned int i = 0; i < cpCount; i++ )
+        {
+            for( ComponentsStats::iterator it = m_componentsStats[ i ].begin(); it != m_componentsStats[ i ].end(); it++ )
+            {
+                id = GameManager::findComponentFactoryIdByType( it->first );
+                if( id.empty() )
+                    id = "unknown";
+                item = Json::Value( Json::objectValue );
+                item[ "calls" ] = Json::Value( it->second.calls );
+                item[ "time" ] = Json::Value( (double)it->second.time );
+                item[ "maxTime" ] = Json::Value( (double)it->second.maxTime );
+                componentsStats[ id ][ phases[ i ] ] = item;
+            }
+        }
+        root[ "components" ] = componentsStats;
+        return root;
+    }
+
+    bool Profiler::saveChromeTrace( const std::string& path )
+    {
+        Json::Value events( Json::arrayValue );
+        Json::Value item;
+        for( std::deque< Frame >::iterator it = m_trace.begin(); it != m_trace.end(); it++ )
+        {
+            item = Json::Value( Json::objectValue );
+            item[ "name" ] = Json::Value( "Frame" );
+            item[ "cat" ] = Json::Value( "frame" );
+            item[ "ph" ] = Json::Value( "X" );
+            item[ "ts" ] = Json::Value( (double)it->start );
+            item[ "dur" ] = Json::Value( (double)it->duration );
+            item[ "pid" ] = Json::Value( 0 );
+            item[ "tid" ] = Json::Value( 0 );
+            item[ "args" ][ "index" ] = Json::Value( it->index );
+            events.append( item );
+            for( std::vector< Zone >::iterator itz = it->zones.begin(); itz != it->zones.end(); itz++ )
+            {
+                item = Json::Value( Json::objectValue );
+                item[ "name" ] = Json::Value( itz->name );
+                item[ "cat" ] = Json::Value( "zone" );
+                item[ "ph" ] = Json::Value( "X" );
+                item[ "ts" ] = Json::Value( (double)itz->start );
+                item[ "dur" ] = Json::Value( (double)itz->duration );
+                item[ "pid" ] = Json::Value( 0 );
+                item[ "tid" ] = Json::Value( 0 );
+                events.append( item );
+            }
+        }
+        Json::Value root;
+        root[ "traceEvents" ] = events;
+        root[ "displayTimeUnit" ] = Json::Value( "ms" );
+        std::ofstream file;
+        file.open( path.c_str(), std::ofstream::out | std::ofstream::binary );
+        if( !file.good() )
+        {
+            file.close();
+            return false;
+        }
+        Json::FastWriter writer;
+        std::string content = writer.write( root );
+        file.write( content.c_str(), content.length() );
+        file.close();
+        return true;
+    }
+
+    void Profiler::accumulate( Stats& stats, sf::Int64 time )
+    {
+        stats.calls++;
+        stats.time += time;
+        if( time > stats.maxTime )
+            stats.maxTime = time;
+    }
+
+}
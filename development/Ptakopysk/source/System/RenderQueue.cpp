@@ -0,0 +1,175 @@
+#include "../../include/Ptakopysk/System/RenderQueue.h"
+#include "../../include/Ptakopysk/System/SpriteBatch.h"
+#include "../../include/Ptakopysk/System/Profiler.h"
+#include "../../include/Ptakopysk/Components/Component.h"
+#include <cstring>
+#include <cfloat>
+#include <algorithm>
+
+namespace Ptakopysk
+{
+
+    RTTI_CLASS_DERIVATIONS( RenderQueue,
+                            RTTI_DERIVATIONS_END
+                            )
+
+    RenderQueue::RenderQueue()
+    : RTTI_CLASS_DEFINE( RenderQueue )
+    , m_pass( 0 )
+    , m_stateChanges( 0 )
+    , m_lastPackets( 0 )
+    , m_lastStateChanges( 0 )
+    {
+    }
+
+    RenderQueue::~RenderQueue()
+    {
+    }
+
+    sf::Uint64 RenderQueue::makeKey( unsigned int pass, unsigned int rank, unsigned int shader, unsigned int texture )
+    {
+        const unsigned int maxPass = ( 1u << PASS_BITS ) - 1;
+        const unsigned int maxRank = ( 1u << RANK_BITS ) - 1;
+        return
+            ( (sf::Uint64)( pass < maxPass ? pass : maxPass ) << ( RANK_BITS + SHADER_BITS + TEXTURE_BITS ) ) |
+            ( (sf::Uint64)( rank < maxRank ? rank : maxRank ) << ( SHADER_BITS + TEXTURE_BITS ) ) |
+            ( (sf::Uint64)shader << TEXTURE_BITS ) |
+            (sf::Uint64)texture;
+    }
+
+    void RenderQueue::begin()
+    {
+        m_packets.clear();
+        m_shaders.clear();
+        m_textures.clear();
+        m_ranks.clear();
+        m_pass = 0;
+        m_stateChanges = 0;
+    }
+
+    void RenderQueue::submit( Component* component, const sf::Shader* shader, const sf::Texture* texture )
+    {
+        if( !component )
+            return;
+        sf::FloatRect bounds;
+        unsigned int rank = m_ranks.size();
+        if( component->onCullingBounds( bounds ) )
+        {
+            while( rank > 0 && !m_ranks[ rank - 1 ].intersects( bounds ) )
+                rank--;
+        }
+        else
+            bounds = sf::FloatRect( -FLT_MAX * 0.5f, -FLT_MAX * 0.5f, FLT_MAX, FLT_MAX );
+        if( rank < m_ranks.size() )
+        {
+            sf::FloatRect& r = m_ranks[ rank ];
+            float left = std::min( r.left, bounds.left );
+            float top = std::min( r.top, bounds.top );
+            r.width = std::max( r.left + r.width, bounds.left + bounds.width ) - left;
+            r.height = std::max( r.top + r.height, bounds.top + bounds.height ) - top;
+            r.left = left;
+            r.top = top;
+        }
+        else
+            m_ranks.push_back( bounds );
+        Packet p;
+        p.key = makeKey( m_pass, rank, stateId( m_shaders, shader, SHADER_BITS ), stateId( m_textures, texture, TEXTURE_BITS ) );
+        p.component = component;
+        m_packets.push_back( p );
+    }
+
+    void RenderQueue::submitPass( Component* component )
+    {
+        if( !component )
+            return;
+        m_ranks.clear();
+        Packet p;
+        p.key = makeKey( ++m_pass, 0, 0, 0 );
+        p.component = component;
+        m_packets.push_back( p );
+    }
+
+    void RenderQueue::sort()
+    {
+        unsigned int count = m_packets.size();
+        if( count < 2 )
+            return;
+        unsigned int histograms[ 8 ][ 256 ];
+        memset( histograms, 0, sizeof( histograms ) );
+        for( std::vector< Packet >::iterator it = m_packets.begin(); it != m_packets.end(); it++ )
+            for( unsigned int b = 0; b < 8; b++ )
+                histograms[ b ][ (unsigned int)( it->key >> ( b * 8 ) ) & 0xFF ]++;
+        m_sorted.resize( count );
+        Packet* src = &m_packets[ 0 ];
+        Packet* dst = &m_sorted[ 0 ];
+        Packet* tmp;
+        unsigned int offsets[ 256 ];
+        unsigned int sum;
+        unsigned int shift;
+        for( unsigned int b = 0; b < 8; b++ )
+        {
+            shift = b * 8;
+            if( histograms[ b ][ (unsigned int)( src[ 0 ].key >> shift ) & 0xFF ] == count )
+                continue;
+            sum = 0;
+            for( unsigned int i = 0; i < 256; i++ )
+            {
+                offsets[ i ] = sum;
+                sum += histograms[ b ][ i ];
+            }
+            for( unsigned int i = 0; i < count; i++ )
+                dst[ offsets[ (unsigned int)( src[ i ].key >> shift ) & 0xFF ]++ ] = src[ i ];
+            tmp = src;
+            src = dst;
+            dst = tmp;
+        }
+        if( src != &m_packets[ 0 ] )
+            m_packets.swap( m_sorted );
+    }
+
+    void RenderQueue::execute( sf::RenderTarget*& target, SpriteBatch* batch )
+    {
+        const sf::Uint64 stateMask = ( (sf::Uint64)1 << ( SHADER_BITS + TEXTURE_BITS ) ) - 1;
+        sf::Uint64 state = 0;
+        Component* c;
+        for( std::vector< Packet >::iterator it = m_packets.begin(); it != m_packets.end(); it++ )
+        {
+            c = it->component;
+            if( ( it->key & stateMask ) != state )
+            {
+                state = it->key & stateMask;
+                m_stateChanges++;
+            }
+            PROFILE_COMPONENT( c, cpRender );
+            if( !batch || !c->onRenderBatch( *batch, target ) )
+            {
+                if( batch )
+                    batch->flush();
+                c->onRender( target );
+            }
+        }
+    }
+
+    void RenderQueue::end()
+    {
+        m_lastPackets = m_packets.size();
+        m_lastStateChanges = m_stateChanges;
+        m_packets.clear();
+    }
+
+    unsigned int RenderQueue::stateId( StateIds& ids, const void* state, unsigned int bits )
+    {
+        if( !state )
+            return 0;
+        StateIds::iterator it = ids.find( state );
+        if( it != ids.end() )
+            return it->second;
+        unsigned int id = ids.size() + 1;
+        unsigned int max = ( 1u << bits ) - 1;
+        if( id > max )
+            id = max;
+        ids[ state ] = id;
+        return id;
+    }
+
+}
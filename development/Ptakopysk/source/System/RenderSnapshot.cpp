@@ -0,0 +1,197 @@
+#include "../../include/Ptakopysk/System/RenderSnapshot.h"
+#include "../../include/Ptakopysk/System/SpriteBatch.h"
+#include <algorithm>
+
+namespace Ptakopysk
+{
+
+    RTTI_CLASS_DERIVATIONS( RenderSnapshot,
+                            RTTI_DERIVATIONS_END
+                            )
+
+    RenderSnapshot::RenderSnapshot()
+    : RTTI_CLASS_DEFINE( RenderSnapshot )
+    , m_clearColor( sf::Color::Black )
+    , m_materialsUsed( 0 )
+    {
+    }
+
+    RenderSnapshot::~RenderSnapshot()
+    {
+        clear();
+        RenderMaterial* m;
+        for( std::vector< RenderMaterial* >::iterator it = m_materials.begin(); it != m_materials.end(); it++ )
+        {
+            m = *it;
+            DELETE_OBJECT( m );
+        }
+        m_materials.clear();
+    }
+
+    void RenderSnapshot::clear()
+    {
+        m_commands.clear();
+        m_vertices.clear();
+        m_views.clear();
+        m_materialsUsed = 0;
+    }
+
+    void RenderSnapshot::addShape( const sf::RectangleShape& shape, const sf::RenderStates& states, RenderMaterial* material, bool materialValidation )
+    {
+        sf::Transform t = states.transform * shape.getTransform();
+        sf::RenderStates s( states.blendMode, sf::Transform::Identity, shape.getTexture(), states.shader );
+        sf::Vector2f size = shape.getSize();
+        sf::IntRect r = shape.getTextureRect();
+        sf::Color c = shape.getFillColor();
+        float left = (float)r.left;
+        float top = (float)r.top;
+        float right = left + (float)r.width;
+        float bottom = top + (float)r.height;
+        unsigned int first = m_vertices.size();
+        m_vertices.push_back( sf::Vertex( t.transformPoint( 0.0f, 0.0f ), c, sf::Vector2f( left, top ) ) );
+        m_vertices.push_back( sf::Vertex( t.transformPoint( size.x, 0.0f ), c, sf::Vector2f( right, top ) ) );
+        m_vertices.push_back( sf::Vertex( t.transformPoint( size.x, size.y ), c, sf::Vector2f( right, bottom ) ) );
+        m_vertices.push_back( sf::Vertex( t.transformPoint( 0.0f, size.y ), c, sf::Vector2f( left, bottom ) ) );
+        pushQuads( first, s, material, materialValidation );
+        float o = shape.getOutlineThickness();
+        if( o == 0.0f )
+            return;
+        /// outline bands: outer edges at x0/x3, inner edges at x1/x2 (same for y).
+        float x0 = std::min( 0.0f, -o );
+        float x1 = std::max( 0.0f, -o );
+        float x2 = size.x + std::min( 0.0f, o );
+        float x3 = size.x + std::max( 0.0f, o );
+        float y0 = x0;
+        float y1 = x1;
+        float y2 = size.y + std::min( 0.0f, o );
+        float y3 = size.y + std::max( 0.0f, o );
+        c = shape.getOutlineColor();
+        first = m_vertices.size();
+        addRect( t, x0, y0, x3, y1, c );
+        addRect( t, x0, y2, x3, y3, c );
+        addRect( t, x0, y1, x1, y2, c );
+        addRect( t, x2, y1, x3, y2, c );
+        s.texture = 0;
+        pushQuads( first, s, material, materialValidation );
+    }
+
+    void RenderSnapshot::addQuads( const sf::Vertex* vertices, unsigned int count, const sf::Color& color, const sf::RenderStates& states, RenderMaterial* material, bool materialValidation )
+    {
+        if( !vertices || !count )
+            return;
+        unsigned int first = m_vertices.size();
+        sf::Vertex v;
+        for( unsigned int i = 0; i < count; i++ )
+        {
+            v = vertices[ i ];
+            v.position = states.transform.transformPoint( v.position );
+            v.color = v.color * color;
+            m_vertices.push_back( v );
+        }
+        pushQuads( first, sf::RenderStates( states.blendMode, sf::Transform::Identity, states.texture, states.shader ), material, materialValidation );
+    }
+
+    void RenderSnapshot::addCamera( sf::RenderTexture* renderTexture, const sf::View& view, bool applyViewToRenderTexture )
+    {
+        Command c;
+        c.type = ctCamera;
+        c.index = m_views.size();
+        c.count = 0;
+        c.material = 0;
+        c.materialValidation = false;
+        c.renderTexture = renderTexture;
+        c.applyView = applyViewToRenderTexture;
+        m_views.push_back( view );
+        m_commands.push_back( c );
+    }
+
+    void RenderSnapshot::render( sf::RenderTarget* target )
+    {
+        if( !target )
+            return;
+        sf::RenderTarget* mainTarget = target;
+        sf::RenderTexture* currentRT = 0;
+        target->setView( target->getDefaultView() );
+        for( std::vector< Command >::iterator it = m_commands.begin(); it != m_commands.end(); it++ )
+        {
+            Command& c = *it;
+            if( c.type == ctCamera )
+            {
+                if( currentRT )
+                    currentRT->display();
+                if( c.renderTexture )
+                {
+                    currentRT = c.renderTexture;
+                    target = currentRT;
+                    target->clear( sf::Color( 0, 0, 0, 0 ) );
+                    if( c.applyView )
+                        target->setView( m_views[ c.index ] );
+                }
+                else
+                {
+                    currentRT = 0;
+                    target = mainTarget;
+                    target->setView( m_views[ c.index ] );
+                }
+                continue;
+            }
+            if( c.material )
+                c.material->apply( (sf::Shader*)c.states.shader, c.materialValidation );
+            target->draw( &m_vertices[ c.index ], c.count, sf::Quads, c.states );
+        }
+        mainTarget->setView( mainTarget->getDefaultView() );
+        if( currentRT )
+            currentRT->display();
+    }
+
+    RenderMaterial* RenderSnapshot::storeMaterial( RenderMaterial* material )
+    {
+        if( !material )
+            return 0;
+        if( m_materialsUsed >= m_materials.size() )
+            m_materials.push_back( xnew RenderMaterial() );
+        RenderMaterial* m = m_materials[ m_materialsUsed++ ];
+        m->copyFrom( *material );
+        return m;
+    }
+
+    void RenderSnapshot::pushQuads( unsigned int first, const sf::RenderStates& states, RenderMaterial* material, bool materialValidation )
+    {
+        if( first >= m_vertices.size() )
+            return;
+        if( !m_commands.empty() )
+        {
+            Command& p = m_commands.back();
+            if( p.type == ctQuads &&
+                p.index + p.count == first &&
+                p.states.texture == states.texture &&
+                p.states.shader == states.shader &&
+                p.states.blendMode == states.blendMode &&
+                ( !states.shader || ( p.materialValidation == materialValidation && SpriteBatch::isSameMaterial( p.material, material ) ) )
+            )
+            {
+                p.count = m_vertices.size() - p.index;
+                return;
+            }
+        }
+        Command c;
+        c.type = ctQuads;
+        c.index = first;
+        c.count = m_vertices.size() - first;
+        c.states = states;
+        c.material = states.shader ? storeMaterial( material ) : 0;
+        c.materialValidation = materialValidation;
+        c.renderTexture = 0;
+        c.applyView = false;
+        m_commands.push_back( c );
+    }
+
+    void RenderSnapshot::addRect( const sf::Transform& transform, float left, float top, float right, float bottom, const sf::Color& color )
+    {
+        m_vertices.push_back( sf::Vertex( transform.transformPoint( left, top ), color ) );
+        m_vertices.push_back( sf::Vertex( transform.transformPoint( right, top ), color ) );
+        m_vertices.push_back( sf::Vertex( transform.transformPoint( right, bottom ), color ) );
+        m_vertices.push_back( sf::Vertex( transform.transformPoint( left, bottom ), color ) );
+    }
+
+}
@@ -0,0 +1,239 @@
+#include "../../include/Ptakopysk/System/SpatialGrid.h"
+#include <cmath>
+
+namespace Ptakopysk
+{
+
+    SpatialGrid* SpatialGrid::s_current = 0;
+
+    RTTI_CLASS_DERIVATIONS( SpatialGrid,
+                            RTTI_DERIVATIONS_END
+                            )
+
+    SpatialGrid::SpatialGrid( float cellSize )
+    : RTTI_CLASS_DEFINE( SpatialGrid )
+    , m_cellSize( cellSize > 0.0f ? cellSize : 256.0f )
+    , m_proxiesCount( 0 )
+    , m_stamp( 0 )
+    , m_mark( 0 )
+    , m_visibleCount( 0 )
+    {
+        m_cellSizeInv = 1.0f / m_cellSize;
+    }
+
+    SpatialGrid::~SpatialGrid()
+    {
+        if( s_current == this )
+            s_current = 0;
+        clear();
+    }
+
+    sf::FloatRect SpatialGrid::viewBounds( const sf::View& view )
+    {
+        sf::Vector2f s = view.getSize();
+        sf::FloatRect r( view.getCenter() - s * 0.5f, s );
+        if( view.getRotation() == 0.0f )
+            return r;
+        sf::Transform t;
+        t.rotate( view.getRotation(), view.getCenter() );
+        return t.transformRect( r );
+    }
+
+    int SpatialGrid::createProxy( const sf::FloatRect& bounds, void* userData )
+    {
+        int proxy;
+        if( m_freeProxies.empty() )
+        {
+            proxy = m_proxies.size();
+            m_proxies.push_back( Proxy() );
+        }
+        else
+        {
+            proxy = m_freeProxies.back();
+            m_freeProxies.pop_back();
+        }
+        Proxy& p = m_proxies[ proxy ];
+        p.bounds = bounds;
+        p.userData = userData;
+        p.stamp = m_stamp;
+        p.mark = m_mark;
+        p.alive = true;
+        insert( proxy );
+        m_proxiesCount++;
+        return proxy;
+    }
+
+    void SpatialGrid::moveProxy( int proxy, const sf::FloatRect& bounds )
+    {
+        if( proxy < 0 || proxy >= (int)m_proxies.size() || !m_proxies[ proxy ].alive )
+            return;
+        Proxy& p = m_proxies[ proxy ];
+        int minX, minY, maxX, maxY;
+        cellsRange( bounds, minX, minY, maxX, maxY );
+        p.bounds = bounds;
+        if( minX == p.minX && minY == p.minY && maxX == p.maxX && maxY == p.maxY )
+            return;
+        remove( proxy );
+        insert( proxy );
+    }
+
+    void SpatialGrid::destroyProxy( int proxy )
+    {
+        if( proxy < 0 || proxy >= (int)m_proxies.size() || !m_proxies[ proxy ].alive )
+            return;
+        remove( proxy );
+        Proxy& p = m_proxies[ proxy ];
+        p.alive = false;
+        p.userData = 0;
+        m_freeProxies.push_back( proxy );
+        m_proxiesCount--;
+    }
+
+    unsigned int SpatialGrid::markVisible( const sf::FloatRect& rect )
+    {
+        m_stamp++;
+        m_visibleCount = visit( rect, &Proxy::stamp, m_stamp, 0 );
+        return m_visibleCount;
+    }
+
+    unsigned int SpatialGrid::query( const sf::FloatRect& rect, std::vector< void* >& result )
+    {
+        m_mark++;
+        return visit( rect, &Proxy::mark, m_mark, &result );
+    }
+
+    unsigned int SpatialGrid::getAllUserData( std::vector< void* >& result )
+    {
+        unsigned int count = 0;
+        for( std::vector< Proxy >::iterator it = m_proxies.begin(); it != m_proxies.end(); it++ )
+        {
+            if( it->alive )
+            {
+                result.push_back( it->userData );
+                count++;
+            }
+        }
+        return count;
+    }
+
+    void SpatialGrid::clear()
+    {
+        m_proxies.clear();
+        m_freeProxies.clear();
+        m_largeProxies.clear();
+        m_cells.clear();
+        m_proxiesCount = 0;
+        m_visibleCount = 0;
+    }
+
+    void SpatialGrid::cellsRange( const sf::FloatRect& rect, int& minX, int& minY, int& maxX, int& maxY )
+    {
+        minX = (int)std::floor( rect.left * m_cellSizeInv );
+        minY = (int)std::floor( rect.top * m_cellSizeInv );
+        maxX = (int)std::floor( ( rect.left + rect.width ) * m_cellSizeInv );
+        maxY = (int)std::floor( ( rect.top + rect.height ) * m_cellSizeInv );
+    }
+
+    void SpatialGrid::insert( int proxy )
+    {
+        Proxy& p = m_proxies[ proxy ];
+        cellsRange( p.bounds, p.minX, p.minY, p.maxX, p.maxY );
+        p.large = (unsigned int)( p.maxX - p.minX + 1 ) * (unsigned int)( p.maxY - p.minY + 1 ) > MAX_PROXY_CELLS;
+        if( p.large )
+        {
+            m_largeProxies.push_back( proxy );
+            return;
+        }
+        for( int y = p.minY; y <= p.maxY; y++ )
+            for( int x = p.minX; x <= p.maxX; x++ )
+                m_cells[ cellKey( x, y ) ].push_back( proxy );
+    }
+
+    void SpatialGrid::remove( int proxy )
+    {
+        Proxy& p = m_proxies[ proxy ];
+        if( p.large )
+        {
+            for( std::vector< int >::iterator it = m_largeProxies.begin(); it != m_largeProxies.end(); it++ )
+            {
+                if( *it == proxy )
+                {
+                    *it = m_largeProxies.back();
+                    m_largeProxies.pop_back();
+                    break;
+                }
+            }
+            return;
+        }
+        Cells::iterator cell;
+        for( int y = p.minY; y <= p.maxY; y++ )
+        {
+            for( int x = p.minX; x <= p.maxX; x++ )
+            {
+                cell = m_cells.find( cellKey( x, y ) );
+                if( cell == m_cells.end() )
+                    continue;
+                std::vector< int >& list = cell->second;
+                for( std::vector< int >::iterator it = list.begin(); it != list.end(); it++ )
+                {
+                    if( *it == proxy )
+                    {
+                        *it = list.back();
+                        list.pop_back();
+                        break;
+                    }
+                }
+                if( list.empty() )
+                    m_cells.erase( cell );
+            }
+        }
+    }
+
+    unsigned int SpatialGrid::visit( const sf::FloatRect& rect, unsigned int Proxy::* field, unsigned int value, std::vector< void* >* result )
+    {
+        int minX, minY, maxX, maxY;
+        cellsRange( rect, minX, minY, maxX, maxY );
+        unsigned int count = visitList( m_largeProxies, rect, field, value, result );
+        if( (double)( maxX - minX + 1 ) * (double)( maxY - minY + 1 ) > (double)m_cells.size() )
+        {
+            int x, y;
+            for( Cells::iterator it = m_cells.begin(); it != m_cells.end(); it++ )
+            {
+                x = cellKeyX( it->first );
+                y = cellKeyY( it->first );
+                if( x >= minX && x <= maxX && y >= minY && y <= maxY )
+                    count += visitList( it->second, rect, field, value, result );
+            }
+            return count;
+        }
+        Cells::iterator cell;
+        for( int y = minY; y <= maxY; y++ )
+        {
+            for( int x = minX; x <= maxX; x++ )
+            {
+                cell = m_cells.find( cellKey( x, y ) );
+                if( cell != m_cells.end() )
+                    count += visitList( cell->second, rect, field, value, result );
+            }
+        }
+        return count;
+    }
+
+    unsigned int SpatialGrid::visitList( std::vector< int >& list, const sf::FloatRect& rect, unsigned int Proxy::* field, unsigned int value, std::vector< void* >* result )
+    {
+        unsigned int count = 0;
+        for( std::vector< int >::iterator it = list.begin(); it != list.end(); it++ )
+        {
+            Proxy& p = m_proxies[ *it ];
+            if( p.*field != value && overlaps( p.bounds, rect ) )
+            {
+                p.*field = value;
+                if( result )
+                    result->push_back( p.userData );
+                count++;
+            }
+        }
+        return count;
+    }
+
+}
@@ -0,0 +1,120 @@
+#include "../../include/Ptakopysk/System/SpriteBatch.h"
+#include "../../include/Ptakopysk/System/RenderMaterial.h"
+
+namespace Ptakopysk
+{
+
+    SpriteBatch* SpriteBatch::s_current = 0;
+
+    RTTI_CLASS_DERIVATIONS( SpriteBatch,
+                            RTTI_DERIVATIONS_END
+                            )
+
+    SpriteBatch::SpriteBatch()
+    : RTTI_CLASS_DEFINE( SpriteBatch )
+    , m_vertices( sf::Quads )
+    , m_target( 0 )
+    , m_states( sf::RenderStates::Default )
+    , m_material( 0 )
+    , m_materialValidation( false )
+    , m_drawCalls( 0 )
+    , m_sprites( 0 )
+    , m_lastDrawCalls( 0 )
+    , m_lastSprites( 0 )
+    {
+    }
+
+    SpriteBatch::~SpriteBatch()
+    {
+        if( s_current == this )
+            s_current = 0;
+    }
+
+    void SpriteBatch::begin()
+    {
+        m_vertices.clear();
+        m_target = 0;
+        m_material = 0;
+        m_drawCalls = 0;
+        m_sprites = 0;
+    }
+
+    void SpriteBatch::end()
+    {
+        flush();
+        m_target = 0;
+        m_material = 0;
+        m_lastDrawCalls = m_drawCalls;
+        m_lastSprites = m_sprites;
+    }
+
+    void SpriteBatch::add( sf::RenderTarget* target, const sf::Vertex* quad, const sf::RenderStates& states, RenderMaterial* material, bool materialValidation )
+    {
+        if( !target || !quad )
+            return;
+        prepare( target, states, material, materialValidation );
+        for( unsigned int i = 0; i < 4; i++ )
+            m_vertices.append( quad[ i ] );
+        m_sprites++;
+    }
+
+    void SpriteBatch::add( sf::RenderTarget* target, const sf::Vertex* vertices, unsigned int count, const sf::Transform& transform, const sf::Color& color, const sf::RenderStates& states, RenderMaterial* material, bool materialValidation )
+    {
+        if( !target || !vertices || !count )
+            return;
+        prepare( target, states, material, materialValidation );
+        sf::Vertex v;
+        for( unsigned int i = 0; i < count; i++ )
+        {
+            v = vertices[ i ];
+            v.position = transform.transformPoint( v.position );
+            v.color = color;
+            m_vertices.append( v );
+        }
+        m_sprites += count / 4;
+    }
+
+    void SpriteBatch::flush()
+    {
+        if( !m_vertices.getVertexCount() || !m_target )
+            return;
+        if( m_states.shader && m_material )
+            m_material->apply( (sf::Shader*)m_states.shader, m_materialValidation );
+        m_target->draw( m_vertices, m_states );
+        m_vertices.clear();
+        m_drawCalls++;
+    }
+
+    void SpriteBatch::prepare( sf::RenderTarget* target, const sf::RenderStates& states, RenderMaterial* material, bool materialValidation )
+    {
+        if( m_vertices.getVertexCount() &&
+            (
+                target != m_target ||
+                states.texture != m_states.texture ||
+                states.shader != m_states.shader ||
+                states.blendMode != m_states.blendMode ||
+                ( states.shader && !isSameMaterial( material, m_material ) )
+            )
+        )
+            flush();
+        if( !m_vertices.getVertexCount() )
+        {
+            m_target = target;
+            m_states.texture = states.texture;
+            m_states.shader = states.shader;
+            m_states.blendMode = states.blendMode;
+            m_material = material;
+            m_materialValidation = materialValidation;
+        }
+    }
+
+    bool SpriteBatch::isSameMaterial( RenderMaterial* a, RenderMaterial* b )
+    {
+        if( a == b )
+            return true;
+        if( !a || !b )
+            return false;
+        return a->rawProperties() == b->rawProperties() && a->rawTextures() == b->rawTextures();
+    }
+
+}
@@ -0,0 +1,108 @@
+#include "../../include/Ptakopysk/System/StateBuffer.h"
+#include <cstring>
+
+namespace Ptakopysk
+{
+
+    RTTI_CLASS_DERIVATIONS( StateBuffer,
+                            RTTI_DERIVATIONS_END
+                            )
+
+    StateBuffer::StateBuffer()
+    : RTTI_CLASS_DEFINE( StateBuffer )
+    , m_position( 0 )
+    , m_valid( true )
+    {
+    }
+
+    StateBuffer::StateBuffer( const void* data, unsigned int size )
+    : RTTI_CLASS_DEFINE( StateBuffer )
+    , m_position( 0 )
+    , m_valid( true )
+    {
+        assign( data, size );
+    }
+
+    StateBuffer::~StateBuffer()
+    {
+    }
+
+    void StateBuffer::clear()
+    {
+        m_data.clear();
+        m_position = 0;
+        m_valid = true;
+    }
+
+    void StateBuffer::assign( const void* data, unsigned int size )
+    {
+        const unsigned char* bytes = (const unsigned char*)data;
+        m_data.assign( bytes, bytes + size );
+        m_position = 0;
+        m_valid = true;
+    }
+
+    void StateBuffer::writeBytes( const void* data, unsigned int size )
+    {
+        if( !size )
+            return;
+        if( m_position + size > m_data.size() )
+            m_data.resize( m_position + size );
+        std::memcpy( &m_data[ m_position ], data, size );
+        m_position += size;
+    }
+
+    bool StateBuffer::readBytes( void* data, unsigned int size )
+    {
+        if( !m_valid || m_position + size > m_data.size() )
+        {
+            m_valid = false;
+            return false;
+        }
+        if( size )
+            std::memcpy( data, &m_data[ m_position ], size );
+        m_position += size;
+        return true;
+    }
+
+    bool StateBuffer::skip( unsigned int size )
+    {
+        if( !m_valid || m_position + size > m_data.size() )
+        {
+            m_valid = false;
+            return false;
+        }
+        m_position += size;
+        return true;
+    }
+
+    unsigned int StateBuffer::beginBlock()
+    {
+        unsigned int block = m_position;
+        write( (unsigned int)0 );
+        return block;
+    }
+
+    void StateBuffer::endBlock( unsigned int block )
+    {
+        unsigned int size = m_position - block - sizeof( unsigned int );
+        std::memcpy( &m_data[ block ], &size, sizeof( unsigned int ) );
+    }
+
+    bool StateBuffer::read( std::string& v )
+    {
+        unsigned int size = 0;
+        if( !read( size ) || m_position + size > m_data.size() )
+        {
+            m_valid = false;
+            return false;
+        }
+        if( size )
+            v.assign( (const char*)&m_data[ m_position ], size );
+        else
+            v.clear();
+        m_position += size;
+        return true;
+    }
+
+}
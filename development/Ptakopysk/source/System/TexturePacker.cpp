@@ -0,0 +1,192 @@
+#include "../../include/Ptakopysk/System/TexturePacker.h"
+#include <XeCore/Common/Logger.h>
+#include <algorithm>
+#include <sstream>
+
+namespace Ptakopysk
+{
+
+    RTTI_CLASS_DERIVATIONS( TexturePacker,
+                            RTTI_DERIVATIONS_END
+                            )
+
+    TexturePacker::TexturePacker( unsigned int pageWidth, unsigned int pageHeight, unsigned int padding )
+    : RTTI_CLASS_DEFINE( TexturePacker )
+    , m_pageWidth( pageWidth )
+    , m_pageHeight( pageHeight )
+    , m_padding( padding )
+    {
+    }
+
+    TexturePacker::~TexturePacker()
+    {
+    }
+
+    sf::Vector2u TexturePacker::getPageSize( unsigned int page )
+    {
+        return page < m_pages.size() ? m_pages[ page ].used : sf::Vector2u();
+    }
+
+    unsigned int TexturePacker::add( const sf::Vector2u& size )
+    {
+        Item item;
+        item.size = size;
+        item.page = 0;
+        item.packed = false;
+        m_items.push_back( item );
+        return m_items.size() - 1;
+    }
+
+    bool TexturePacker::pack()
+    {
+        m_pages.clear();
+        std::vector< unsigned int > order;
+        for( unsigned int i = 0; i < m_items.size(); i++ )
+        {
+            m_items[ i ].packed = false;
+            order.push_back( i );
+        }
+        std::sort( order.begin(), order.end(), CompareItems( m_items ) );
+        bool result = true;
+        int width, height, y;
+        unsigned int node, page;
+        for( std::vector< unsigned int >::iterator it = order.begin(); it != order.end(); it++ )
+        {
+            Item& item = m_items[ *it ];
+            width = (int)( item.size.x + m_padding );
+            height = (int)( item.size.y + m_padding );
+            if( !item.size.x || !item.size.y || item.size.x > m_pageWidth || item.size.y > m_pageHeight )
+            {
+                std::stringstream ss;
+                ss << "Texture of size " << item.size.x << "x" << item.size.y << " cannot be packed into page of size " << m_pageWidth << "x" << m_pageHeight << "!";
+                XWARNING( ss.str().c_str() );
+                result = false;
+                continue;
+            }
+            for( page = 0; page < m_pages.size(); page++ )
+                if( findPosition( m_pages[ page ], width, height, node, y ) )
+                    break;
+            if( page == m_pages.size() )
+            {
+                m_pages.push_back( Page() );
+                Node n;
+                n.x = 0;
+                n.y = 0;
+                n.width = (int)m_pageWidth;
+                m_pages.back().skyline.push_back( n );
+                if( !findPosition( m_pages.back(), width, height, node, y ) )
+                {
+                    width = (int)item.size.x;
+                    height = (int)item.size.y;
+                    findPosition( m_pages.back(), width, height, node, y );
+                }
+            }
+            Page& p = m_pages[ page ];
+            item.rect = sf::IntRect( p.skyline[ node ].x, y, (int)item.size.x, (int)item.size.y );
+            item.page = page;
+            item.packed = true;
+            place( p, node, width, height, y );
+            p.used.x = std::max( p.used.x, (unsigned int)( item.rect.left + item.rect.width ) );
+            p.used.y = std::max( p.used.y, (unsigned int)( item.rect.top + item.rect.height ) );
+        }
+        return result;
+    }
+
+    bool TexturePacker::getItem( unsigned int index, unsigned int& outPage, sf::IntRect& outRect )
+    {
+        if( index >= m_items.size() || !m_items[ index ].packed )
+            return false;
+        outPage = m_items[ index ].page;
+        outRect = m_items[ index ].rect;
+        return true;
+    }
+
+    void TexturePacker::clear()
+    {
+        m_items.clear();
+        m_pages.clear();
+    }
+
+    bool TexturePacker::CompareItems::operator() ( unsigned int a, unsigned int b )
+    {
+        const sf::Vector2u& sa = m_items[ a ].size;
+        const sf::Vector2u& sb = m_items[ b ].size;
+        if( sa.y != sb.y )
+            return sa.y > sb.y;
+        if( sa.x != sb.x )
+            return sa.x > sb.x;
+        return a < b;
+    }
+
+    bool TexturePacker::fit( Page& page, unsigned int node, int width, int height, int& outY )
+    {
+        int x = page.skyline[ node ].x;
+        if( x + width > (int)m_pageWidth )
+            return false;
+        int left = width;
+        int y = 0;
+        for( unsigned int i = node; left > 0 && i < page.skyline.size(); i++ )
+        {
+            y = std::max( y, page.skyline[ i ].y );
+            if( y + height > (int)m_pageHeight )
+                return false;
+            left -= page.skyline[ i ].width;
+        }
+        outY = y;
+        return true;
+    }
+
+    bool TexturePacker::findPosition( Page& page, int width, int height, unsigned int& outNode, int& outY )
+    {
+        int bestTop = -1;
+        int bestX = 0;
+        int y;
+        for( unsigned int i = 0; i < page.skyline.size(); i++ )
+        {
+            if( !fit( page, i, width, height, y ) )
+                continue;
+            if( bestTop < 0 || y + height < bestTop || ( y + height == bestTop && page.skyline[ i ].x < bestX ) )
+            {
+                bestTop = y + height;
+                bestX = page.skyline[ i ].x;
+                outNode = i;
+                outY = y;
+            }
+        }
+        return bestTop >= 0;
+    }
+
+    void TexturePacker::place( Page& page, unsigned int node, int width, int height, int y )
+    {
+        Node n;
+        n.x = page.skyline[ node ].x;
+        n.y = y + height;
+        n.width = width;
+        page.skyline.insert( page.skyline.begin() + node, n );
+        int shrink;
+        for( unsigned int i = node + 1; i < page.skyline.size(); )
+        {
+            Node& prev = page.skyline[ i - 1 ];
+            Node& cur = page.skyline[ i ];
+            if( cur.x >= prev.x + prev.width )
+                break;
+            shrink = prev.x + prev.width - cur.x;
+            cur.x += shrink;
+            cur.width -= shrink;
+            if( cur.width > 0 )
+                break;
+            page.skyline.erase( page.skyline.begin() + i );
+        }
+        for( unsigned int i = 1; i < page.skyline.size(); )
+        {
+            if( page.skyline[ i - 1 ].y == page.skyline[ i ].y )
+            {
+                page.skyline[ i - 1 ].width += page.skyline[ i ].width;
+                page.skyline.erase( page.skyline.begin() + i );
+            }
+            else
+                i++;
+        }
+    }
+
+}
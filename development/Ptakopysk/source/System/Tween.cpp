@@ -84,6 +84,34 @@ namespace Ptakopysk
         return (dword)this;
     }
 
+    void TweenSequence::onSaveState( StateBuffer& state )
+    {
+        state.write( m_state );
+        state.write( m_time );
+        state.write( (unsigned int)m_working.size() );
+        for( std::vector< dword >::iterator it = m_working.begin(); it != m_working.end(); it++ )
+            state.write( *it );
+    }
+
+    void TweenSequence::onLoadState( StateBuffer& state )
+    {
+        int s = m_state;
+        unsigned int count = 0;
+        state.read( s );
+        state.read( m_time );
+        state.read( count );
+        std::vector< dword > working( count, 0 );
+        for( unsigned int i = 0; i < count; i++ )
+            state.read( working[ i ] );
+        if( s == -1 && m_state != -1 )
+            return;
+        m_state = s;
+        m_working.clear();
+        for( std::vector< dword >::iterator it = working.begin(); it != working.end(); it++ )
+            if( Tweener::use().hasTween( *it ) )
+                m_working.push_back( *it );
+    }
+
     TweenBlock::TweenBlock()
     : m_state( -1 )
     , m_duration( 0.0f )
@@ -163,12 +191,41 @@ namespace Ptakopysk
         return (dword)this;
     }
 
+    void TweenBlock::onSaveState( StateBuffer& state )
+    {
+        state.write( m_state );
+        state.write( m_time );
+        state.write( (unsigned int)m_working.size() );
+        for( std::vector< dword >::iterator it = m_working.begin(); it != m_working.end(); it++ )
+            state.write( *it );
+    }
+
+    void TweenBlock::onLoadState( StateBuffer& state )
+    {
+        int s = m_state;
+        unsigned int count = 0;
+        state.read( s );
+        state.read( m_time );
+        state.read( count );
+        std::vector< dword > working( count, 0 );
+        for( unsigned int i = 0; i < count; i++ )
+            state.read( working[ i ] );
+        if( s == -1 && m_state != -1 )
+            return;
+        m_state = s;
+        m_working.clear();
+        for( std::vector< dword >::iterator it = working.begin(); it != working.end(); it++ )
+            if( Tweener::use().hasTween( *it ) )
+                m_working.push_back( *it );
+    }
+
     RTTI_CLASS_DERIVATIONS( Tweener,
                             RTTI_DERIVATIONS_END
                             )
 
     Tweener::Tweener()
     : RTTI_CLASS_DEFINE( Tweener )
+    , m_nextTweenId( 0 )
     {
     }
 
@@ -179,20 +236,23 @@ namespace Ptakopysk
 
     bool Tweener::hasTween( dword id )
     {
-        return std::find( m_tweens.begin(), m_tweens.end(), (ITween*)id ) != m_tweens.end();
+        return findTween( id ) != m_tweens.end();
     }
 
     dword Tweener::startTween( ITween* t )
     {
-        if( !t || hasTween( (dword)t ) )
+        if( !t || hasTween( t->m_tweenId ) )
             return 0;
-        m_tweens.push_back( (ITween*)t );
-        return (dword)t;
+        if( !++m_nextTweenId )
+            m_nextTweenId++;
+        t->m_tweenId = m_nextTweenId;
+        m_tweens.push_back( t );
+        return t->m_tweenId;
     }
 
     void Tweener::killTween( dword id )
     {
-        std::list< ITween* >::iterator it = std::find( m_tweens.begin(), m_tweens.end(), (ITween*)id );
+        std::list< ITween* >::iterator it = findTween( id );
         if( it != m_tweens.end() )
         {
             ITween* tf = *it;
@@ -216,10 +276,20 @@ namespace Ptakopysk
 
     ITween* Tweener::getTween( dword id )
     {
-        std::list< ITween* >::iterator it = std::find( m_tweens.begin(), m_tweens.end(), (ITween*)id );
+        std::list< ITween* >::iterator it = findTween( id );
         return it == m_tweens.end() ? 0 : *it;
     }
 
+    std::list< ITween* >::iterator Tweener::findTween( dword id )
+    {
+        if( !id )
+            return m_tweens.end();
+        for( std::list< ITween* >::iterator it = m_tweens.begin(); it != m_tweens.end(); it++ )
+            if( (*it)->m_tweenId == id )
+                return it;
+        return m_tweens.end();
+    }
+
     void Tweener::processTweens( float dt )
     {
         ITween* t;
@@ -241,4 +311,67 @@ namespace Ptakopysk
         }
     }
 
+    void Tweener::saveState( StateBuffer& state )
+    {
+        state.write( (unsigned int)m_tweens.size() );
+        unsigned int block;
+        for( std::list< ITween* >::iterator it = m_tweens.begin(); it != m_tweens.end(); it++ )
+        {
+            state.write( (*it)->m_tweenId );
+            block = state.beginBlock();
+            (*it)->onSaveState( state );
+            state.endBlock( block );
+        }
+    }
+
+    bool Tweener::loadState( StateBuffer& state )
+    {
+        unsigned int count = 0;
+        if( !state.read( count ) )
+            return false;
+        std::vector< std::pair< ITween*, unsigned int > > found;
+        dword id = 0;
+        unsigned int size = 0;
+        ITween* t;
+        for( unsigned int i = 0; i < count; i++ )
+        {
+            if( !state.read( id ) || !state.read( size ) )
+                return false;
+            t = getTween( id );
+            if( t )
+                found.push_back( std::make_pair( t, state.getPosition() ) );
+            if( !state.skip( size ) )
+                return false;
+        }
+        unsigned int end = state.getPosition();
+        std::list< ITween* > tweens;
+        for( std::vector< std::pair< ITween*, unsigned int > >::iterator it = found.begin(); it != found.end(); it++ )
+        {
+            m_tweens.remove( it->first );
+            tweens.push_back( it->first );
+        }
+        killAllTweens();
+        m_tweens.swap( tweens );
+        for( std::vector< std::pair< ITween*, unsigned int > >::iterator it = found.begin(); it != found.end(); it++ )
+        {
+            state.setPosition( it->second );
+            it->first->onLoadState( state );
+        }
+        state.setPosition( end );
+        return state.isValid();
+    }
+
+    bool Tweener::skipState( StateBuffer& state )
+    {
+        unsigned int count = 0;
+        dword id = 0;
+        unsigned int size = 0;
+        if( !state.read( count ) )
+            return false;
+        for( unsigned int i = 0; i < count; i++ )
+            if( !state.read( id ) || !state.read( size ) || !state.skip( size ) )
+                return false;
+        return true;
+    }
+
 }
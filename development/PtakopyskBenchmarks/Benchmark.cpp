@@ -0,0 +1,170 @@
+#include "Benchmark.h"
+#include <Ptakopysk/System/Allocations.h>
+#include <XeCore/Common/MemoryManager.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+static const void* volatile s_sink = 0;
+
+std::vector< Benchmark* > Benchmark::s_benchmarks;
+
+Benchmark::Benchmark( const std::string& name )
+: m_name( name )
+, m_paused( false )
+, m_pauseStart( 0 )
+, m_pausedTime( 0 )
+, m_pauseAllocations( 0 )
+, m_pausedAllocations( 0 )
+, m_pauseBytes( 0 )
+, m_pausedBytes( 0 )
+{
+}
+
+Benchmark::~Benchmark()
+{
+}
+
+void Benchmark::registerBenchmark( Benchmark* benchmark )
+{
+    if( benchmark )
+        s_benchmarks.push_back( benchmark );
+}
+
+void Benchmark::unregisterAllBenchmarks()
+{
+    Benchmark* b;
+    for( std::vector< Benchmark* >::iterator it = s_benchmarks.begin(); it != s_benchmarks.end(); it++ )
+    {
+        b = *it;
+        DELETE_OBJECT( b );
+    }
+    s_benchmarks.clear();
+}
+
+unsigned int Benchmark::runAll( const std::string& filter, float minTime, unsigned int repeats, bool csv )
+{
+    if( csv )
+        printf( "name,iterations,ns/op,allocs/op,bytes/op\n" );
+    else
+        printf( "%-40s %12s %14s %12s %12s\n", "Benchmark", "Iterations", "ns/op", "allocs/op", "bytes/op" );
+    unsigned int count = 0;
+    Benchmark* b;
+    Result r;
+    for( std::vector< Benchmark* >::iterator it = s_benchmarks.begin(); it != s_benchmarks.end(); it++ )
+    {
+        b = *it;
+        if( !filter.empty() && b->getName().find( filter ) == std::string::npos )
+            continue;
+        r = b->run( minTime, repeats );
+        if( r.skipped )
+        {
+            if( csv )
+                printf( "%s,skipped,,,\n", r.name.c_str() );
+            else
+                printf( "%-40s %12s\n", r.name.c_str(), "skipped" );
+        }
+        else if( csv )
+            printf( "%s,%u,%.2f,%.2f,%.2f\n", r.name.c_str(), r.iterations, r.nsPerOp, r.allocationsPerOp, r.bytesPerOp );
+        else
+            printf( "%-40s %12u %14.2f %12.2f %12.2f\n", r.name.c_str(), r.iterations, r.nsPerOp, r.allocationsPerOp, r.bytesPerOp );
+        fflush( stdout );
+        count++;
+    }
+    return count;
+}
+
+unsigned int Benchmark::allocationsCount()
+{
+    return Ptakopysk::Allocations::getTotalStats().allocations;
+}
+
+unsigned long long Benchmark::allocatedBytes()
+{
+    return Ptakopysk::Allocations::getTotalStats().allocatedBytes;
+}
+
+void Benchmark::doNotOptimize( const void* p )
+{
+    s_sink = p;
+}
+
+Benchmark::Result Benchmark::run( float minTime, unsigned int repeats )
+{
+    Result r;
+    r.name = m_name;
+    r.skipped = true;
+    r.iterations = 0;
+    r.nsPerOp = 0.0;
+    r.allocationsPerOp = 0.0;
+    r.bytesPerOp = 0.0;
+    if( !onSetup() )
+    {
+        onTeardown();
+        return r;
+    }
+    sf::Int64 minMicroseconds = (sf::Int64)( minTime * 1000000.0f );
+    unsigned int iterations = 1;
+    Sample s = measure( iterations );
+    while( s.time < minMicroseconds && iterations < MAX_ITERATIONS )
+    {
+        iterations = s.time > 0 ? (unsigned int)std::min< sf::Int64 >( MAX_ITERATIONS, iterations * minMicroseconds * 12 / ( s.time * 10 ) + 1 ) : iterations * 10;
+        if( iterations > MAX_ITERATIONS )
+            iterations = MAX_ITERATIONS;
+        s = measure( iterations );
+    }
+    std::vector< std::pair< sf::Int64, unsigned int > > order;
+    std::vector< Sample > samples;
+    for( unsigned int i = 0; i < ( repeats ? repeats : 1 ); i++ )
+    {
+        samples.push_back( measure( iterations ) );
+        order.push_back( std::make_pair( samples.back().time, i ) );
+    }
+    std::sort( order.begin(), order.end() );
+    s = samples[ order[ order.size() / 2 ].second ];
+    onTeardown();
+    r.skipped = false;
+    r.iterations = iterations;
+    r.nsPerOp = (double)s.time * 1000.0 / iterations;
+    r.allocationsPerOp = (double)s.allocations / iterations;
+    r.bytesPerOp = (double)s.bytes / iterations;
+    return r;
+}
+
+void Benchmark::pauseTiming()
+{
+    if( m_paused )
+        return;
+    m_paused = true;
+    m_pauseStart = m_clock.getElapsedTime().asMicroseconds();
+    m_pauseAllocations = allocationsCount();
+    m_pauseBytes = allocatedBytes();
+}
+
+void Benchmark::resumeTiming()
+{
+    if( !m_paused )
+        return;
+    m_paused = false;
+    m_pausedTime += m_clock.getElapsedTime().asMicroseconds() - m_pauseStart;
+    m_pausedAllocations += allocationsCount() - m_pauseAllocations;
+    m_pausedBytes += allocatedBytes() - m_pauseBytes;
+}
+
+Benchmark::Sample Benchmark::measure( unsigned int iterations )
+{
+    m_paused = false;
+    m_pausedTime = 0;
+    m_pausedAllocations = 0;
+    m_pausedBytes = 0;
+    unsigned int allocations = allocationsCount();
+    unsigned long long bytes = allocatedBytes();
+    sf::Int64 start = m_clock.getElapsedTime().asMicroseconds();
+    onRun( iterations );
+    resumeTiming();
+    Sample s;
+    s.time = m_clock.getElapsedTime().asMicroseconds() - start - m_pausedTime;
+    s.allocations = allocationsCount() - allocations - m_pausedAllocations;
+    s.bytes = allocatedBytes() - bytes - m_pausedBytes;
+    return s;
+}
@@ -0,0 +1,67 @@
+#ifndef __PTAKOPYSK_BENCHMARKS__BENCHMARK__
+#define __PTAKOPYSK_BENCHMARKS__BENCHMARK__
+
+#include <XeCore/Common/Base.h>
+#include <SFML/System/Clock.hpp>
+#include <string>
+#include <vector>
+
+class Benchmark
+{
+public:
+    struct Result
+    {
+        std::string name;
+        bool skipped;
+        unsigned int iterations;
+        double nsPerOp;
+        double allocationsPerOp;
+        double bytesPerOp;
+    };
+
+    static const unsigned int MAX_ITERATIONS = 1 << 24;
+
+    Benchmark( const std::string& name );
+    virtual ~Benchmark();
+
+    static void registerBenchmark( Benchmark* benchmark );
+    static void unregisterAllBenchmarks();
+    static unsigned int runAll( const std::string& filter, float minTime, unsigned int repeats, bool csv );
+    static unsigned int allocationsCount();
+    static unsigned long long allocatedBytes();
+    static void doNotOptimize( const void* p );
+
+    FORCEINLINE const std::string& getName() { return m_name; };
+    Result run( float minTime, unsigned int repeats );
+    void pauseTiming();
+    void resumeTiming();
+
+protected:
+    virtual bool onSetup() { return true; };
+    virtual void onRun( unsigned int iterations ) = 0;
+    virtual void onTeardown() {};
+
+private:
+    struct Sample
+    {
+        sf::Int64 time;
+        unsigned int allocations;
+        unsigned long long bytes;
+    };
+
+    Sample measure( unsigned int iterations );
+
+    static std::vector< Benchmark* > s_benchmarks;
+
+    std::string m_name;
+    sf::Clock m_clock;
+    bool m_paused;
+    sf::Int64 m_pauseStart;
+    sf::Int64 m_pausedTime;
+    unsigned int m_pauseAllocations;
+    unsigned int m_pausedAllocations;
+    unsigned long long m_pauseBytes;
+    unsigned long long m_pausedBytes;
+};
+
+#endif
@@ -0,0 +1,542 @@
+#include "Benchmark.h"
+#include <Ptakopysk/System/GameManager.h>
+#include <Ptakopysk/System/GameObjectPath.h>
+#include <Ptakopysk/System/Tween.h>
+#include <Ptakopysk/System/GlyphRunCache.h>
+#include <Ptakopysk/Components/Transform.h>
+#include <Ptakopysk/Components/SpriteRenderer.h>
+#include <Ptakopysk/Components/TextRenderer.h>
+#include <Ptakopysk/Components/Body.h>
+#include <SFML/Graphics/RenderTexture.hpp>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Ptakopysk;
+
+static const float BENCHMARK_DT = 1.0f / 60.0f;
+
+class BenchmarkComponent
+: public virtual XeCore::Common::IRtti
+, public virtual XeCore::Common::MemoryManager::Manageable
+, public Component
+{
+    RTTI_CLASS_DECLARE( BenchmarkComponent );
+
+public:
+    BenchmarkComponent() : RTTI_CLASS_DEFINE( BenchmarkComponent ), Component( Component::tUpdate ), m_accum( 0.0f ) {};
+
+    FORCEINLINE static Component* onBuildComponent() { return xnew BenchmarkComponent(); }
+
+protected:
+    virtual void onUpdate( float dt ) { m_accum += dt; };
+
+private:
+    float m_accum;
+};
+
+RTTI_CLASS_DERIVATIONS( BenchmarkComponent,
+                        RTTI_DERIVATION( Component ),
+                        RTTI_DERIVATIONS_END
+                        )
+
+Json::Value headlessConfig()
+{
+    Json::Value config;
+    config[ "headless" ] = Json::Value( true );
+    config[ "lifeCycle" ][ "jobsWorkers" ] = Json::Value( 0 );
+    return config;
+}
+
+std::string makeId( const char* prefix, unsigned int index )
+{
+    std::stringstream ss;
+    ss << prefix << index;
+    return ss.str();
+}
+
+GameObject* buildObject( const std::string& id, sf::Vector2f position )
+{
+    GameObject* go = xnew GameObject( id );
+    Transform* trans = xnew Transform();
+    trans->setPosition( position );
+    go->addComponent( trans );
+    return go;
+}
+
+class GameManagerBenchmark
+: public Benchmark
+{
+public:
+    GameManagerBenchmark( const std::string& name ) : Benchmark( name ), m_gameManager( 0 ) {};
+
+protected:
+    virtual bool onSetup() { m_gameManager = xnew GameManager( headlessConfig() ); return true; };
+    virtual void onTeardown() { DELETE_OBJECT( m_gameManager ); };
+
+    GameManager* m_gameManager;
+};
+
+class SceneLoadBenchmark
+: public GameManagerBenchmark
+{
+public:
+    SceneLoadBenchmark( unsigned int count ) : GameManagerBenchmark( makeId( "SceneLoad/", count ) ), m_count( count ) {};
+
+protected:
+    virtual bool onSetup()
+    {
+        GameManagerBenchmark::onSetup();
+        for( unsigned int i = 0; i < m_count; i++ )
+            m_gameManager->addGameObject( buildObject( makeId( "go", i ), sf::Vector2f( (float)i, 0.0f ) ) );
+        m_gameManager->processAdding();
+        m_scene = m_gameManager->sceneToJson( GameManager::GameObjects );
+        m_gameManager->removeScene( GameManager::GameObjects );
+        return true;
+    };
+
+    virtual void onRun( unsigned int iterations )
+    {
+        for( unsigned int i = 0; i < iterations; i++ )
+        {
+            m_gameManager->jsonToScene( m_scene, GameManager::GameObjects );
+            pauseTiming();
+            m_gameManager->removeScene( GameManager::GameObjects );
+            resumeTiming();
+        }
+    };
+
+private:
+    unsigned int m_count;
+    Json::Value m_scene;
+};
+
+class PrefabInstantiateBenchmark
+: public GameManagerBenchmark
+{
+public:
+    PrefabInstantiateBenchmark() : GameManagerBenchmark( "PrefabInstantiate" ) {};
+
+protected:
+    virtual bool onSetup()
+    {
+        GameManagerBenchmark::onSetup();
+        GameObject* prefab = buildObject( "prefab", sf::Vector2f() );
+        prefab->addComponent( xnew SpriteRenderer() );
+        for( unsigned int i = 0; i < 4; i++ )
+        {
+            GameObject* child = buildObject( makeId( "child", i ), sf::Vector2f( (float)i, 0.0f ) );
+            child->addComponent( xnew SpriteRenderer() );
+            prefab->addGameObject( child );
+        }
+        m_gameManager->addGameObject( prefab, true );
+        return true;
+    };
+
+    virtual void onRun( unsigned int iterations )
+    {
+        for( unsigned int i = 0; i < iterations; i++ )
+            m_gameManager->addGameObject( m_gameManager->instantiatePrefab( "prefab" ) );
+        pauseTiming();
+        m_gameManager->removeScene( GameManager::GameObjects );
+        resumeTiming();
+    };
+};
+
+class UpdateBenchmark
+: public GameManagerBenchmark
+{
+public:
+    UpdateBenchmark( unsigned int count, unsigned int depth ) : GameManagerBenchmark( makeId( makeId( "Update/", count ).append( "/depth" ).c_str(), depth ) ), m_count( count ), m_depth( depth ? depth : 1 ) {};
+
+protected:
+    virtual bool onSetup()
+    {
+        GameManagerBenchmark::onSetup();
+        GameObject* parent = 0;
+        GameObject* go;
+        for( unsigned int i = 0; i < m_count; i++ )
+        {
+            go = buildObject( makeId( "go", i ), sf::Vector2f( 1.0f, 0.0f ) );
+            go->addComponent( xnew BenchmarkComponent() );
+            if( i % m_depth && parent )
+                parent->addGameObject( go );
+            else
+                m_gameManager->addGameObject( go );
+            parent = go;
+        }
+        m_gameManager->processUpdate( BENCHMARK_DT );
+        return true;
+    };
+
+    virtual void onRun( unsigned int iterations )
+    {
+        for( unsigned int i = 0; i < iterations; i++ )
+            m_gameManager->processUpdate( BENCHMARK_DT );
+    };
+
+private:
+    unsigned int m_count;
+    unsigned int m_depth;
+};
+
+class GetComponentBenchmark
+: public Benchmark
+{
+public:
+    GetComponentBenchmark( bool slot ) : Benchmark( slot ? "GetComponent/slot" : "GetComponent/type" ), m_slot( slot ), m_gameObject( 0 ) {};
+
+protected:
+    virtual bool onSetup()
+    {
+        m_gameObject = buildObject( "go", sf::Vector2f() );
+        m_gameObject->addComponent( xnew SpriteRenderer() );
+        m_gameObject->addComponent( xnew BenchmarkComponent() );
+        m_gameObject->addComponent( xnew Body() );
+        return true;
+    };
+
+    virtual void onRun( unsigned int iterations )
+    {
+        Component* c = 0;
+        if( m_slot )
+        {
+            for( unsigned int i = 0; i < iterations; i++ )
+                c = m_gameObject->getComponent< Body >();
+        }
+        else
+        {
+            for( unsigned int i = 0; i < iterations; i++ )
+                c = m_gameObject->getComponent( RTTI_CLASS_TYPE( Body ) );
+        }
+        doNotOptimize( c );
+    };
+
+    virtual void onTeardown() { DELETE_OBJECT( m_gameObject ); };
+
+private:
+    bool m_slot;
+    GameObject* m_gameObject;
+};
+
+class FindGameObjectBenchmark
+: public GameManagerBenchmark
+{
+public:
+    FindGameObjectBenchmark( bool compiled ) : GameManagerBenchmark( compiled ? "FindGameObject/compiled" : "FindGameObject/string" ), m_compiled( compiled ), m_path( "/n7/n3/n9" ) {};
+
+protected:
+    virtual bool onSetup()
+    {
+        GameManagerBenchmark::onSetup();
+        for( unsigned int i = 0; i < 10; i++ )
+        {
+            GameObject* a = buildObject( makeId( "n", i ), sf::Vector2f() );
+            for( unsigned int j = 0; j < 10; j++ )
+            {
+                GameObject* b = buildObject( makeId( "n", j ), sf::Vector2f() );
+                for( unsigned int k = 0; k < 10; k++ )
+                    b->addGameObject( buildObject( makeId( "n", k ), sf::Vector2f() ) );
+                a->addGameObject( b );
+            }
+            m_gameManager->addGameObject( a );
+        }
+        m_gameManager->processUpdate( BENCHMARK_DT );
+        return m_gameManager->findGameObject( m_path ) != 0;
+    };
+
+    virtual void onRun( unsigned int iterations )
+    {
+        GameObject* go = 0;
+        if( m_compiled )
+        {
+            for( unsigned int i = 0; i < iterations; i++ )
+                go = m_gameManager->findGameObject( m_path );
+        }
+        else
+        {
+            for( unsigned int i = 0; i < iterations; i++ )
+                go = m_gameManager->findGameObject( m_path.getPath() );
+        }
+        doNotOptimize( go );
+    };
+
+private:
+    bool m_compiled;
+    GameObjectPath m_path;
+};
+
+class RenderBenchmark
+: public Benchmark
+{
+public:
+    RenderBenchmark( unsigned int count, bool batching, bool culling = false, bool mixed = false, bool sorting = false ) : Benchmark( makeId( sorting ? "RenderSorted/" : mixed ? "RenderMixed/" : culling ? "RenderCulled/" : batching ? "RenderBatched/" : "Render/", count ) ), m_count( count ), m_batching( batching ), m_culling( culling ), m_mixed( mixed ), m_sorting( sorting ), m_gameManager( 0 ), m_target( 0 ) {};
+
+protected:
+    virtual bool onSetup()
+    {
+        m_target = xnew sf::RenderTexture();
+        if( !m_target->create( 1024, 768 ) )
+            return false;
+        for( unsigned int i = 0; i < 2; i++ )
+            if( !m_textures[ i ].create( 16, 16 ) )
+                return false;
+        Json::Value config;
+        config[ "lifeCycle" ][ "jobsWorkers" ] = Json::Value( 0 );
+        config[ "lifeCycle" ][ "spriteBatching" ] = Json::Value( m_batching );
+        config[ "lifeCycle" ][ "renderCulling" ] = Json::Value( m_culling );
+        config[ "lifeCycle" ][ "renderSorting" ] = Json::Value( m_sorting );
+        float spacing = m_culling ? 64.0f : 16.0f;
+        m_gameManager = xnew GameManager( config );
+        GameObject* go;
+        SpriteRenderer* sprite;
+        for( unsigned int i = 0; i < m_count; i++ )
+        {
+            go = buildObject( makeId( "go", i ), sf::Vector2f( (float)( i % 64 ) * spacing, (float)( i / 64 ) * spacing ) );
+            sprite = xnew SpriteRenderer();
+            sprite->setSize( sf::Vector2f( 16.0f, 16.0f ) );
+            if( m_mixed )
+                sprite->setTexture( &m_textures[ i % 2 ] );
+            go->addComponent( sprite );
+            m_gameManager->addGameObject( go );
+        }
+        m_gameManager->processUpdate( BENCHMARK_DT );
+        return true;
+    };
+
+    virtual void onRun( unsigned int iterations )
+    {
+        for( unsigned int i = 0; i < iterations; i++ )
+        {
+            m_target->clear();
+            m_gameManager->processRender( m_target );
+            m_target->display();
+        }
+    };
+
+    virtual void onTeardown()
+    {
+        DELETE_OBJECT( m_gameManager );
+        DELETE_OBJECT( m_target );
+    };
+
+private:
+    unsigned int m_count;
+    bool m_batching;
+    bool m_culling;
+    bool m_mixed;
+    bool m_sorting;
+    GameManager* m_gameManager;
+    sf::RenderTexture* m_target;
+    sf::Texture m_textures[ 2 ];
+};
+
+class TextRenderBenchmark
+: public Benchmark
+{
+public:
+    TextRenderBenchmark( unsigned int count, bool batching, const std::string& fontPath ) : Benchmark( makeId( batching ? "TextRenderBatched/" : "TextRender/", count ) ), m_count( count ), m_batching( batching ), m_fontPath( fontPath ), m_frame( 0 ), m_gameManager( 0 ), m_target( 0 ) {};
+
+protected:
+    virtual bool onSetup()
+    {
+        if( m_fontPath.empty() || !m_font.loadFromFile( m_fontPath ) )
+            return false;
+        m_target = xnew sf::RenderTexture();
+        if( !m_target->create( 1024, 768 ) )
+            return false;
+        Json::Value config;
+        config[ "lifeCycle" ][ "jobsWorkers" ] = Json::Value( 0 );
+        config[ "lifeCycle" ][ "spriteBatching" ] = Json::Value( m_batching );
+        m_gameManager = xnew GameManager( config );
+        GameObject* go;
+        TextRenderer* text;
+        for( unsigned int i = 0; i < m_count; i++ )
+        {
+            go = buildObject( makeId( "go", i ), sf::Vector2f( (float)( i % 16 ) * 64.0f, (float)( i / 16 ) * 16.0f ) );
+            text = xnew TextRenderer();
+            text->setFont( &m_font );
+            text->setSize( 12 );
+            go->addComponent( text );
+            m_gameManager->addGameObject( go );
+            m_texts.push_back( text );
+        }
+        m_gameManager->processUpdate( BENCHMARK_DT );
+        return true;
+    };
+
+    virtual void onRun( unsigned int iterations )
+    {
+        for( unsigned int i = 0; i < iterations; i++ )
+        {
+            m_frame++;
+            for( unsigned int j = 0; j < m_texts.size(); j++ )
+                m_texts[ j ]->setText( makeId( "", ( j + m_frame ) % 1000 ) );
+            m_target->clear();
+            m_gameManager->processRender( m_target );
+            m_target->display();
+        }
+    };
+
+    virtual void onTeardown()
+    {
+        m_texts.clear();
+        DELETE_OBJECT( m_gameManager );
+        DELETE_OBJECT( m_target );
+        GlyphRunCache::removeFontFromAll( &m_font );
+    };
+
+private:
+    unsigned int m_count;
+    bool m_batching;
+    std::string m_fontPath;
+    unsigned int m_frame;
+    GameManager* m_gameManager;
+    sf::RenderTexture* m_target;
+    sf::Font m_font;
+    std::vector< TextRenderer* > m_texts;
+};
+
+class TweensBenchmark
+: public Benchmark
+{
+public:
+    TweensBenchmark( unsigned int count ) : Benchmark( makeId( "Tweens/", count ) ), m_count( count ) {};
+
+protected:
+    virtual bool onSetup()
+    {
+        typedef Tween< float, Transform, Math::Easing::Linear::inOut > RotationTween;
+        for( unsigned int i = 0; i < m_count; i++ )
+        {
+            Transform* trans = xnew Transform();
+            m_transforms.push_back( trans );
+            Tweener::use().startTween( xnew RotationTween( trans->Rotation, 360.0f, 1000000.0f ) );
+        }
+        return true;
+    };
+
+    virtual void onRun( unsigned int iterations )
+    {
+        for( unsigned int i = 0; i < iterations; i++ )
+            Tweener::use().processTweens( BENCHMARK_DT );
+    };
+
+    virtual void onTeardown()
+    {
+        Tweener::use().killAllTweens();
+        Transform* trans;
+        for( std::vector< Transform* >::iterator it = m_transforms.begin(); it != m_transforms.end(); it++ )
+        {
+            trans = *it;
+            DELETE_OBJECT( trans );
+        }
+        m_transforms.clear();
+    };
+
+private:
+    unsigned int m_count;
+    std::vector< Transform* > m_transforms;
+};
+
+class PhysicsBenchmark
+: public GameManagerBenchmark
+{
+public:
+    PhysicsBenchmark( unsigned int count ) : GameManagerBenchmark( makeId( "Physics/", count ) ), m_count( count ) {};
+
+protected:
+    virtual bool onSetup()
+    {
+        GameManagerBenchmark::onSetup();
+        GameObject* ground = buildObject( "ground", sf::Vector2f( 0.0f, -1.0f ) );
+        Body* body = xnew Body();
+        Body::VerticesData verts;
+        verts.push_back( b2Vec2( -100.0f, -1.0f ) );
+        verts.push_back( b2Vec2( 100.0f, -1.0f ) );
+        verts.push_back( b2Vec2( 100.0f, 1.0f ) );
+        verts.push_back( b2Vec2( -100.0f, 1.0f ) );
+        body->setVertices( verts );
+        body->setBodyType( b2_staticBody );
+        ground->addComponent( body );
+        m_gameManager->addGameObject( ground );
+        GameObject* go;
+        for( unsigned int i = 0; i < m_count; i++ )
+        {
+            go = buildObject( makeId( "go", i ), sf::Vector2f( (float)( i % 32 ) * 1.5f - 24.0f, (float)( i / 32 ) * 1.5f + 1.0f ) );
+            body = xnew Body();
+            body->setBodyType( b2_dynamicBody );
+            body->setRadius( 0.5f );
+            body->setSleepingAllowed( false );
+            go->addComponent( body );
+            m_gameManager->addGameObject( go );
+        }
+        m_gameManager->setWorldGravity( b2Vec2( 0.0f, -10.0f ) );
+        m_gameManager->processAdding();
+        return true;
+    };
+
+    virtual void onRun( unsigned int iterations )
+    {
+        for( unsigned int i = 0; i < iterations; i++ )
+            m_gameManager->processPhysics( BENCHMARK_DT );
+    };
+
+private:
+    unsigned int m_count;
+};
+
+int main( int argc, char* argv[] )
+{
+    std::string filter;
+    float minTime = 0.5f;
+    unsigned int repeats = 5;
+    bool csv = false;
+    std::string fontPath;
+    for( int i = 1; i < argc; i++ )
+    {
+        if( !strncmp( argv[ i ], "--min-time=", 11 ) )
+            minTime = (float)atof( argv[ i ] + 11 );
+        else if( !strncmp( argv[ i ], "--repeats=", 10 ) )
+            repeats = (unsigned int)atoi( argv[ i ] + 10 );
+        else if( !strncmp( argv[ i ], "--font=", 7 ) )
+            fontPath = argv[ i ] + 7;
+        else if( !strcmp( argv[ i ], "--csv" ) )
+            csv = true;
+        else
+            filter = argv[ i ];
+    }
+
+    GameManager::initialize();
+    GameManager::registerComponentFactory( "BenchmarkComponent", RTTI_CLASS_TYPE( BenchmarkComponent ), BenchmarkComponent::onBuildComponent );
+
+    Benchmark::registerBenchmark( xnew SceneLoadBenchmark( 100 ) );
+    Benchmark::registerBenchmark( xnew SceneLoadBenchmark( 1000 ) );
+    Benchmark::registerBenchmark( xnew PrefabInstantiateBenchmark() );
+    Benchmark::registerBenchmark( xnew UpdateBenchmark( 1000, 1 ) );
+    Benchmark::registerBenchmark( xnew UpdateBenchmark( 1000, 8 ) );
+    Benchmark::registerBenchmark( xnew UpdateBenchmark( 10000, 1 ) );
+    Benchmark::registerBenchmark( xnew UpdateBenchmark( 10000, 8 ) );
+    Benchmark::registerBenchmark( xnew GetComponentBenchmark( true ) );
+    Benchmark::registerBenchmark( xnew GetComponentBenchmark( false ) );
+    Benchmark::registerBenchmark( xnew FindGameObjectBenchmark( false ) );
+    Benchmark::registerBenchmark( xnew FindGameObjectBenchmark( true ) );
+    Benchmark::registerBenchmark( xnew RenderBenchmark( 1000, false ) );
+    Benchmark::registerBenchmark( xnew RenderBenchmark( 1000, true ) );
+    Benchmark::registerBenchmark( xnew RenderBenchmark( 5000, true ) );
+    Benchmark::registerBenchmark( xnew RenderBenchmark( 5000, true, true ) );
+    Benchmark::registerBenchmark( xnew RenderBenchmark( 5000, true, false, true ) );
+    Benchmark::registerBenchmark( xnew RenderBenchmark( 5000, true, false, true, true ) );
+    Benchmark::registerBenchmark( xnew TextRenderBenchmark( 500, false, fontPath ) );
+    Benchmark::registerBenchmark( xnew TextRenderBenchmark( 500, true, fontPath ) );
+    Benchmark::registerBenchmark( xnew TweensBenchmark( 1000 ) );
+    Benchmark::registerBenchmark( xnew PhysicsBenchmark( 256 ) );
+    Benchmark::registerBenchmark( xnew PhysicsBenchmark( 1024 ) );
+
+    unsigned int count = Benchmark::runAll( filter, minTime, repeats, csv );
+
+    Benchmark::unregisterAllBenchmarks();
+    GameManager::cleanup();
+    return count ? 0 : 1;
+}
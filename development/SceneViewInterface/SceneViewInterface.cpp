@@ -691,7 +691,7 @@ int SceneViewInterface::createGameObject( bool isPrefab, int parent, const std::
             m_gameManager->addGameObject( go, isPrefab );
             m_gameManager->processAdding();
         }
-        return (int)go;
+        return getGameObjectHandle( go );
     }
     else
     {
@@ -703,7 +703,7 @@ int SceneViewInterface::createGameObject( bool isPrefab, int parent, const std::
                 go->setId( id );
                 p->addGameObject( go );
                 p->processAdding();
-                return (int)go;
+                return getGameObjectHandle( go );
             }
         }
         else
@@ -714,7 +714,7 @@ int SceneViewInterface::createGameObject( bool isPrefab, int parent, const std::
                 go->setId( id );
                 m_gameManager->addGameObject( go, isPrefab );
                 m_gameManager->processAdding();
-                return (int)go;
+                return getGameObjectHandle( go );
             }
         }
     }
@@ -828,7 +828,7 @@ Json::Value SceneViewInterface::convertGameObjectToJson( int handle, bool isPref
 int SceneViewInterface::findGameObjectHandleById( const std::string& id, bool isPrefab, int parent )
 {
     GameObject* p = parent == 0 ? 0 : findGameObject( parent, isPrefab );
-    return (int)findGameObjectById( id, isPrefab, p );
+    return getGameObjectHandle( findGameObjectById( id, isPrefab, p ) );
 }
 
 int SceneViewInterface::findGameObjectHandleAtScreenPosition( const sf::Vector2i& p )
@@ -839,7 +839,7 @@ int SceneViewInterface::findGameObjectHandleAtScreenPosition( const sf::Vector2i
         return 0;
     }
     sf::Vector2f worldPos = m_renderWindow->mapPixelToCoords( p, m_sceneView );
-    return (int)findGameObjectAtPosition( worldPos );
+    return getGameObjectHandle( findGameObjectAtPosition( worldPos ) );
 }
 
 Json::Value SceneViewInterface::listGameObjects( bool isPrefab, bool includeChilds, GameObject* parent )
@@ -859,7 +859,7 @@ Json::Value SceneViewInterface::listGameObjects( bool isPrefab, bool includeChil
         {
             go = *it;
             item = Json::Value::null;
-            item[ "handle" ] = (int)go;
+            item[ "handle" ] = getGameObjectHandle( go );
             item[ "id" ] = go->getId();
             if( includeChilds )
                 item[ "childs" ] = listGameObjects( isPrefab, includeChilds, go );
@@ -873,7 +873,7 @@ Json::Value SceneViewInterface::listGameObjects( bool isPrefab, bool includeChil
         {
             go = *it;
             item = Json::Value::null;
-            item[ "handle" ] = (int)go;
+            item[ "handle" ] = getGameObjectHandle( go );
             item[ "id" ] = go->getId();
             if( includeChilds )
                 item[ "childs" ] = listGameObjects( isPrefab, includeChilds, go );
@@ -1523,7 +1523,7 @@ void SceneViewInterface::renderGrid( sf::RenderWindow* target, sf::Vector2f grid
     }
 }
 
-GameObject* SceneViewInterface::findGameObject( int handle, bool isPrefab, GameObject* parent )
+GameObject* SceneViewInterface::findGameObject( int handle, bool isPrefab )
 {
     if( !m_gameManager )
     {
@@ -1531,43 +1531,13 @@ GameObject* SceneViewInterface::findGameObject( int handle, bool isPrefab, GameO
         return 0;
     }
 
-    if( !handle )
-        return 0;
-
-    if( parent )
-    {
-        GameObject* go = 0;
-        for( GameObject::List::iterator it = parent->gameObjectAtBegin(); it != parent->gameObjectAtEnd(); it++ )
-        {
-            go = *it;
-            if( (int)go == handle )
-                return go;
-            else
-            {
-                go = findGameObject( handle, isPrefab, go );
-                if( (int)go == handle )
-                    return go;
-            }
-        }
-    }
-    else
-    {
-        GameObject* go = 0;
-        for( GameObject::List::iterator it = m_gameManager->gameObjectAtBegin( isPrefab ); it != m_gameManager->gameObjectAtEnd( isPrefab ); it++ )
-        {
-            go = *it;
-            if( (int)go == handle )
-                return go;
-            else
-            {
-                go = findGameObject( handle, isPrefab, go );
-                if( (int)go == handle )
-                    return go;
-            }
-        }
-    }
+    GameObject* go = m_gameManager->resolve( (GameObject::Handle)handle );
+    return go && go->isPrefab() == isPrefab ? go : 0;
+}
 
-    return 0;
+int SceneViewInterface::getGameObjectHandle( GameObject* go )
+{
+    return m_gameManager ? (int)m_gameManager->getHandle( go ) : 0;
 }
 
 GameObject* SceneViewInterface::findGameObjectById( const std::string& id, bool isPrefab, GameObject* parent )
@@ -93,7 +93,8 @@ protected:
 
 private:
     void renderGrid( sf::RenderWindow* target, sf::Vector2f gridSize );
-    GameObject* findGameObject( int handle, bool isPrefab, GameObject* parent = 0 );
+    GameObject* findGameObject( int handle, bool isPrefab );
+    int getGameObjectHandle( GameObject* go );
     GameObject* findGameObjectById( const std::string& id, bool isPrefab, GameObject* parent = 0 );
     GameObject* findGameObjectAtPosition( const sf::Vector2f& pos, GameObject* parent = 0 );
 